@@ -0,0 +1,668 @@
+/*
+	C90 TODO List
+	Copyright (C) 2015 Daniel Esteban Nombela <dani@dabuten.co>
+
+	This software is provided 'as-is', without any express or implied
+	warranty. In no event will the author be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+/**
+ *  \file bench.c
+ *
+ *  Synthetic workload benchmarks for the C90 TODO List
+ *
+ *  Generates lists from 10^3 entries up to the maximum size and times
+ *  the hot paths on each of them, printing the min/median/p99 of every
+ *  benchmark as CSV (or JSON with -j). The scanning kernels get timed
+ *  first, on in-memory text, with their throughput in bytes/cycle.
+ */
+
+/* Using Standard lib, Standard I/O, Strings & POSIX */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "data.h"
+#include "lib.h"
+#include "render.h"
+
+/**
+ *  \brief The default maximum list size
+ */
+#define BENCH_DEFAULT_MAX 1000000
+
+/**
+ *  \brief The number of operations timed per list position
+ */
+#define BENCH_OPERATIONS 1000
+
+/**
+ *  \brief The number of generated lines the scanning kernels get timed on
+ */
+#define BENCH_KERNEL_LINES 20000
+
+/**
+ *  \brief The headless window size
+ */
+#define BENCH_ROWS 50
+#define BENCH_COLS 200
+
+/**
+ *  \brief The benchmark result struct
+ */
+struct BenchResult {
+	char name[32];         /**< The benchmark name */
+	unsigned long entries; /**< The list size */
+	unsigned long runs;    /**< The number of timed runs */
+	double min;            /**< The fastest run (seconds) */
+	double median;         /**< The median run (seconds) */
+	double p99;            /**< The 99th percentile run (seconds) */
+	double bytes;          /**< The bytes processed per run (Zero if not measured) */
+};
+
+/** The results **/
+static struct BenchResult *results = NULL;
+static unsigned long resultsCount = 0;
+
+/** The samples of the benchmark being run **/
+static double *samples = NULL;
+static unsigned long samplesCount = 0;
+
+/** Where the kernels results go (So they don't get optimized away) **/
+static volatile size_t benchSink = 0;
+
+/** The (TSC) cycles per second **/
+static double cyclesPerSecond = 0;
+
+/** The number of threads for the (parallel) loads **/
+static unsigned int loadThreads = 0;
+
+/** The title words **/
+static const char *words[16] = {
+	"review", "deploy", "the", "weekly", "report", "fix", "login", "bug",
+	"call", "with", "team", "update", "docs", "for", "release", "backup"
+};
+
+/** The title generator state **/
+static unsigned long randomState = 88172645463325252UL;
+
+/**
+ *  \brief A xorshift pseudo random number generator
+ *
+ *  \return The next pseudo random number
+ */
+static unsigned long nextRandom() {
+	randomState ^= randomState << 13;
+	randomState ^= randomState >> 7;
+	randomState ^= randomState << 17;
+	return randomState;
+}
+
+/**
+ *  \brief Compares two samples (For qsort)
+ */
+static int compareSamples(const void *a, const void *b) {
+	const double x = *((const double *) a);
+	const double y = *((const double *) b);
+	return x < y ? -1 : x > y;
+}
+
+/**
+ *  \brief Records a sample of the benchmark being run
+ *
+ *  \param seconds The sample time
+ */
+static void addSample(const double seconds) {
+	samples[samplesCount++] = seconds;
+}
+
+/**
+ *  \brief Stores the result of the benchmark being run
+ *
+ *  \param name The benchmark name
+ *  \param entries The list size
+ */
+static void addResult(const char *name, const unsigned long entries) {
+	struct BenchResult *result;
+	unsigned long p99;
+
+	if(samplesCount == 0) return;
+	if((results = (struct BenchResult *) realloc(results, sizeof(struct BenchResult) * (resultsCount + 1))) == NULL) {
+		printf("ERROR allocating results");
+		exit(1);
+	}
+	result = results + resultsCount++;
+
+	qsort(samples, samplesCount, sizeof(double), compareSamples);
+	p99 = (samplesCount * 99 + 99) / 100;
+	strncpy(result->name, name, sizeof(result->name) - 1);
+	result->name[sizeof(result->name) - 1] = '\0';
+	result->entries = entries;
+	result->runs = samplesCount;
+	result->min = samples[0];
+	result->median = samples[samplesCount / 2];
+	result->p99 = samples[(p99 > 0 ? p99 : 1) - 1];
+	result->bytes = 0;
+	samplesCount = 0;
+
+	/* Report the progress */
+	fprintf(stderr, "%-24s %9lu entries: %12.3fus median\n", name, entries, result->median * 1e6);
+}
+
+/**
+ *  \brief Generates a synthetic list file
+ *
+ *  \param filename The list filename
+ *  \param entries The number of entries
+ */
+static void generateList(const char *filename, const unsigned long entries) {
+	FILE *file = fopen(filename, "w");
+	unsigned long i;
+	unsigned long wordsCount;
+
+	if(file == NULL) {
+		printf("ERROR writing to file: %s\n", filename);
+		exit(1);
+	}
+
+	fputs("========================================\n                Bench\n========================================\n", file);
+	for(i = 0; i < entries; i++) {
+		/* 2 to 9 words, 10 to 70 bytes titles */
+		fputs(nextRandom() % 3 == 0 ? DONE_MARKER : PENDING_MARKER, file);
+		for(wordsCount = 2 + nextRandom() % 8; wordsCount > 0; wordsCount--) fprintf(file, " %s", words[nextRandom() % 16]);
+		fprintf(file, " #%lu\n", i);
+	}
+	fclose(file);
+}
+
+/**
+ *  \brief Stores the result of the kernel being run, with the bytes it processed per run
+ *
+ *  \param name The benchmark name
+ *  \param bytes The bytes per run
+ */
+static void addKernelResult(const char *name, const size_t bytes) {
+	addResult(name, BENCH_KERNEL_LINES);
+	results[resultsCount - 1].bytes = bytes;
+}
+
+/**
+ *  \brief Measures the TSC frequency against the monotonic clock
+ */
+static void calibrateCycles() {
+#ifdef SCAN_KERNELS_X86
+	const double start = getMonotonicTime();
+	const unsigned long startCycles = (unsigned long) __rdtsc();
+	double elapsed;
+
+	while((elapsed = getMonotonicTime() - start) < 0.1);
+	cyclesPerSecond = ((unsigned long) __rdtsc() - startCycles) / elapsed;
+#endif
+}
+
+/**
+ *  \brief The trimRange of the C library isspace (The kernels baseline)
+ */
+static const char *trimRangeCType(const char *str, size_t *length) {
+	const char *end = str + *length;
+
+	while(str < end && isspace((unsigned char) *str)) str++;
+	while(end > str && isspace((unsigned char) *(end - 1))) end--;
+
+	*length = end - str;
+	return str;
+}
+
+/**
+ *  \brief Generates the list lines the kernels get timed on
+ *
+ *  \param text The text buffer
+ *  \param lines Where to store the lines starts (And the text end)
+ *  \param padding The maximum whitespace around the lines
+ */
+static void generateKernelText(struct Buffer *text, size_t *lines, const unsigned long padding) {
+	const char spaces[4] = {' ', ' ', ' ', '\t'};
+	char line[MAX_BUFFER_SIZE];
+	size_t length;
+	unsigned long wordsCount;
+	unsigned long i;
+	unsigned long j;
+
+	text->length = 0;
+	for(i = 0; i < BENCH_KERNEL_LINES; i++) {
+		length = 0;
+		for(j = nextRandom() % (padding + 1); j > 0; j--) line[length++] = spaces[nextRandom() % 4];
+		length += sprintf(line + length, "%s", nextRandom() % 3 == 0 ? DONE_MARKER : PENDING_MARKER);
+		for(wordsCount = 2 + nextRandom() % 8; wordsCount > 0; wordsCount--) length += sprintf(line + length, " %s", words[nextRandom() % 16]);
+		length += sprintf(line + length, " #%lu", i);
+		for(j = nextRandom() % (padding + 1); j > 0; j--) line[length++] = spaces[nextRandom() % 4];
+		line[length++] = '\n';
+
+		lines[i] = text->length;
+		bufferAppend(text, line, length);
+	}
+	lines[BENCH_KERNEL_LINES] = text->length;
+}
+
+/**
+ *  \brief Times the trimming of every line (Without its newline, as the loader does)
+ *
+ *  \param name The benchmark name
+ *  \param text The text
+ *  \param lines The lines starts
+ *  \param trimmer The trimming function
+ */
+static void benchTrim(const char *name, const struct Buffer *text, const size_t *lines, const char *(*trimmer)(const char *, size_t *)) {
+	size_t trimmed;
+	size_t length;
+	unsigned long i;
+	unsigned long j;
+	double start;
+
+	for(i = 0; i < 100; i++) {
+		trimmed = 0;
+		start = getMonotonicTime();
+		for(j = 0; j < BENCH_KERNEL_LINES; j++) {
+			length = lines[j + 1] - lines[j] - 1;
+			trimmed += (size_t) trimmer(text->data + lines[j], &length) + length;
+		}
+		addSample(getMonotonicTime() - start);
+		benchSink = trimmed;
+	}
+	addKernelResult(name, text->length);
+}
+
+/**
+ *  \brief Times the splitting of the text into lines & entry fields
+ *
+ *  Does what the loader does with every line: finds its end, trims it,
+ *  checks for the markers (Or finds the separator) & trims the title.
+ *
+ *  \param name The benchmark name
+ *  \param text The text
+ *  \param baseline Whether to use memchr & the C library isspace instead of the kernels
+ */
+static void benchSplit(const char *name, const struct Buffer *text, const char baseline) {
+	const char *end = text->data + text->length;
+	const char *line;
+	const char *lineEnd;
+	const char *separator;
+	size_t done;
+	size_t length;
+	unsigned long i;
+	double start;
+
+	for(i = 0; i < 100; i++) {
+		done = 0;
+		start = getMonotonicTime();
+		for(line = text->data; line < end; line = lineEnd + 1) {
+			if(baseline) {
+				if((lineEnd = (const char *) memchr(line, '\n', end - line)) == NULL) lineEnd = end;
+				length = lineEnd - line;
+				if(trimRangeCType(line, &length) != line || length == 0) continue;
+				if((separator = (const char *) memchr(line, ' ', length)) == NULL) separator = line + length;
+			} else {
+				lineEnd = findByte(line, end, '\n');
+				length = lineEnd - line;
+				if(trimRange(line, &length) != line || length == 0) continue;
+				if(length > sizeof(DONE_MARKER) - 1 && line[sizeof(DONE_MARKER) - 1] == ' ' && (memcmp(line, DONE_MARKER, sizeof(DONE_MARKER) - 1) == 0 || memcmp(line, PENDING_MARKER, sizeof(PENDING_MARKER) - 1) == 0)) separator = line + sizeof(DONE_MARKER) - 1;
+				else separator = findByte(line, line + length, ' ');
+			}
+			done += (size_t) (separator - line) == sizeof(DONE_MARKER) - 1 && memcmp(line, DONE_MARKER, sizeof(DONE_MARKER) - 1) == 0;
+			length -= separator - line;
+			done += (size_t) (baseline ? trimRangeCType(separator, &length) : trimRange(separator, &length)) + length;
+		}
+		addSample(getMonotonicTime() - start);
+		benchSink = done;
+	}
+	addKernelResult(name, text->length);
+}
+
+/**
+ *  \brief Times the scanning kernels against the C library baselines
+ */
+static void benchKernels() {
+	const char *kernelNames[3] = {"scalar", "sse2", "avx2"};
+	struct Buffer text = {NULL, 0, 0};
+	struct Buffer padded = {NULL, 0, 0};
+	size_t *lines = (size_t *) malloc(sizeof(size_t) * (BENCH_KERNEL_LINES + 1));
+	size_t *paddedLines = (size_t *) malloc(sizeof(size_t) * (BENCH_KERNEL_LINES + 1));
+	const char *line;
+	const char *end;
+	char name[32];
+	size_t count;
+	unsigned long i;
+	double start;
+	int kernels;
+
+	if(lines == NULL || paddedLines == NULL) {
+		printf("ERROR allocating lines");
+		exit(1);
+	}
+	generateKernelText(&text, lines, 0);
+	generateKernelText(&padded, paddedLines, 64);
+
+	benchTrim("trim_ctype", &text, lines, trimRangeCType);
+	benchTrim("trim_padded_ctype", &padded, paddedLines, trimRangeCType);
+	benchSplit("split_ctype", &text, 1);
+	for(kernels = SCAN_KERNELS_SCALAR; kernels <= SCAN_KERNELS_AVX2; kernels++) {
+		if(setScanKernels(kernels) != kernels) break;
+
+		sprintf(name, "trim_%s", kernelNames[kernels]);
+		benchTrim(name, &text, lines, trimRange);
+		sprintf(name, "trim_padded_%s", kernelNames[kernels]);
+		benchTrim(name, &padded, paddedLines, trimRange);
+		sprintf(name, "split_%s", kernelNames[kernels]);
+		benchSplit(name, &text, 0);
+
+		/* Newlines of the whole text */
+		end = text.data + text.length;
+		for(i = 0; i < 100; i++) {
+			count = 0;
+			start = getMonotonicTime();
+			for(line = text.data; line < end; line = findByte(line, end, '\n') + 1) count++;
+			addSample(getMonotonicTime() - start);
+			benchSink = count;
+		}
+		sprintf(name, "newline_%s", kernelNames[kernels]);
+		addKernelResult(name, text.length);
+	}
+	setScanKernels(SCAN_KERNELS_AVX2);
+
+	bufferFree(&text);
+	bufferFree(&padded);
+	free(lines);
+	free(paddedLines);
+}
+
+/**
+ *  \brief Times the toggles & deletes at the head, middle & tail of the list
+ *
+ *  \param entries The list size
+ */
+static void benchMutations(const unsigned long entries) {
+	const char *positions[3] = {"head", "middle", "tail"};
+	char name[32];
+	unsigned long operations = entries / 4 < BENCH_OPERATIONS ? entries / 4 : BENCH_OPERATIONS;
+	unsigned long index;
+	unsigned long i;
+	int p;
+	double start;
+
+	for(p = 0; p < 3; p++) {
+		/* Toggles */
+		for(i = 0; i < operations; i++) {
+			index = p == 0 ? 1 : (p == 1 ? getTODOListLength() / 2 : getTODOListLength());
+			start = getMonotonicTime();
+			toggleEntry(index);
+			addSample(getMonotonicTime() - start);
+		}
+		sprintf(name, "toggle_%s", positions[p]);
+		addResult(name, entries);
+
+		/* Deletes */
+		for(i = 0; i < operations; i++) {
+			index = p == 0 ? 1 : (p == 1 ? getTODOListLength() / 2 : getTODOListLength());
+			start = getMonotonicTime();
+			deleteEntry(index);
+			addSample(getMonotonicTime() - start);
+		}
+		sprintf(name, "delete_%s", positions[p]);
+		addResult(name, entries);
+	}
+}
+
+/**
+ *  \brief Times the search index build & the searches
+ *
+ *  \param filename The list filename
+ *  \param entries The list size
+ *  \param runs The number of index builds
+ */
+static void benchSearch(const char *filename, const unsigned long entries, const unsigned long runs) {
+	char query[64];
+	unsigned long i;
+	double start;
+
+	/* Index build (On the first search) */
+	for(i = 0; i < runs; i++) {
+		loadTODOList(filename, NULL);
+		start = getMonotonicTime();
+		filterTODOList(words[0]);
+		addSample(getMonotonicTime() - start);
+		freeTodoList();
+	}
+	addResult("search_build", entries);
+
+	/* Two words queries (Broad) & an entry number query (Selective) */
+	loadTODOList(filename, NULL);
+	filterTODOList(words[0]);
+	for(i = 0; i < BENCH_OPERATIONS; i++) {
+		sprintf(query, "%s %s", words[nextRandom() % 16], words[nextRandom() % 16]);
+		start = getMonotonicTime();
+		filterTODOList(query);
+		addSample(getMonotonicTime() - start);
+	}
+	addResult("search_words", entries);
+	for(i = 0; i < BENCH_OPERATIONS; i++) {
+		sprintf(query, "%lu", nextRandom() % entries);
+		start = getMonotonicTime();
+		filterTODOList(query);
+		addSample(getMonotonicTime() - start);
+	}
+	addResult("search_number", entries);
+
+	/* Render a filtered frame in the middle of the matches */
+	filterTODOList("weekly report");
+	scrollTo(getTODOListLength() / 2);
+	render();
+	for(i = 0; i < BENCH_OPERATIONS; i++) {
+		scrollPage(i % 2 == 0 ? 1 : -1);
+		start = getMonotonicTime();
+		render();
+		addSample(getMonotonicTime() - start);
+	}
+	addResult("render_filtered", entries);
+	freeTodoList();
+}
+
+/**
+ *  \brief Runs all the benchmarks on a list size
+ *
+ *  \param directory The directory for the list files
+ *  \param entries The list size
+ */
+static void benchList(const char *directory, const unsigned long entries) {
+	char filename[MAX_BUFFER_SIZE];
+	char snapshot[MAX_BUFFER_SIZE];
+	const unsigned long runs = entries <= 10000 ? 50 : (entries <= 100000 ? 20 : (entries <= 1000000 ? 5 : 3));
+	unsigned long i;
+	double start;
+
+	sprintf(filename, "%s/bench-%lu.txt", directory, entries);
+	sprintf(snapshot, "%s%s", filename, SNAPSHOT_EXTENSION);
+	generateList(filename, entries);
+
+	/* Load & free (Text) */
+	for(i = 0; i < runs; i++) {
+		start = getMonotonicTime();
+		loadTODOList(filename, NULL);
+		addSample(getMonotonicTime() - start);
+		freeTodoList();
+	}
+	addResult("load", entries);
+	setTODOListLoadThreads(1);
+	for(i = 0; i < runs; i++) {
+		start = getMonotonicTime();
+		loadTODOList(filename, NULL);
+		addSample(getMonotonicTime() - start);
+		freeTodoList();
+	}
+	addResult("load_sequential", entries);
+	setTODOListLoadThreads(loadThreads);
+	for(i = 0; i < runs; i++) {
+		loadTODOList(filename, NULL);
+		start = getMonotonicTime();
+		freeTodoList();
+		addSample(getMonotonicTime() - start);
+	}
+	addResult("free", entries);
+
+	/* Load (Snapshot) */
+	setTODOListSnapshotMode(1);
+	loadTODOList(filename, NULL);
+	freeTodoList();
+	for(i = 0; i < runs; i++) {
+		start = getMonotonicTime();
+		loadTODOList(filename, NULL);
+		addSample(getMonotonicTime() - start);
+		freeTodoList();
+	}
+	addResult("load_snapshot", entries);
+	setTODOListSnapshotMode(0);
+	unlink(snapshot);
+
+	/* Save */
+	loadTODOList(filename, NULL);
+	for(i = 0; i < runs; i++) {
+		start = getMonotonicTime();
+		saveTodoList();
+		addSample(getMonotonicTime() - start);
+	}
+	addResult("save", entries);
+
+	/* Render a steady frame in the middle of the list */
+	scrollTo(getTODOListLength() / 2);
+	render();
+	for(i = 0; i < BENCH_OPERATIONS; i++) {
+		toggleEntry(getTODOListLength() / 2 + i % 10);
+		start = getMonotonicTime();
+		render();
+		addSample(getMonotonicTime() - start);
+	}
+	addResult("render", entries);
+
+	/* Toggles with the auto save (Just requesting a background save) */
+	for(i = 0; i < BENCH_OPERATIONS; i++) {
+		start = getMonotonicTime();
+		toggleEntry(getTODOListLength() / 2);
+		addSample(getMonotonicTime() - start);
+	}
+	addResult("toggle_autosave", entries);
+	flushTodoList();
+
+	/* Toggles & deletes (Without saving) */
+	setTODOListAutoSave(0);
+	benchMutations(entries);
+	setTODOListAutoSave(1);
+	freeTodoList();
+
+	/* Searches */
+	benchSearch(filename, entries, runs);
+	unlink(filename);
+}
+
+/**
+ *  \brief Prints the results
+ *
+ *  \param json Whether to print them as JSON instead of CSV
+ */
+static void printResults(const char json) {
+	char throughput[64];
+	unsigned long i;
+
+	if(!json) printf("benchmark,entries,runs,min_us,median_us,p99_us,bytes_per_cycle\n");
+	else printf("[\n");
+	for(i = 0; i < resultsCount; i++) {
+		/* The kernels throughput (At the median) */
+		throughput[0] = '\0';
+		if(results[i].bytes > 0 && cyclesPerSecond > 0) {
+			sprintf(throughput, json ? ",\"bytes_per_cycle\":%.3f" : "%.3f", results[i].bytes / (results[i].median * cyclesPerSecond));
+		}
+
+		printf(
+			json ? "  {\"benchmark\":\"%s\",\"entries\":%lu,\"runs\":%lu,\"min_us\":%.3f,\"median_us\":%.3f,\"p99_us\":%.3f%s}%s\n" : "%s,%lu,%lu,%.3f,%.3f,%.3f,%s%s\n",
+			results[i].name, results[i].entries, results[i].runs,
+			results[i].min * 1e6, results[i].median * 1e6, results[i].p99 * 1e6,
+			throughput, json && i < resultsCount - 1 ? "," : ""
+		);
+	}
+	if(json) printf("]\n");
+}
+
+/**
+ *  \brief The benchmarks entry point
+ *
+ *  \param argc The CLI arguments count
+ *  \param argv The CLI arguments values
+ *
+ *  \return The benchmarks exit status code
+ */
+int main(int argc, char **argv) {
+	/* The options */
+	unsigned long maxEntries = BENCH_DEFAULT_MAX;
+	const char *directory = "/tmp";
+	char json = 0;
+	int option;
+
+	/* The list size */
+	unsigned long entries;
+
+	while((option = getopt(argc, argv, "m:d:t:j")) != -1) {
+		switch(option) {
+			case 'm':
+				maxEntries = strtoul(optarg, NULL, 10);
+			break;
+			case 'd':
+				directory = optarg;
+			break;
+			case 't':
+				loadThreads = strtoul(optarg, NULL, 10);
+			break;
+			case 'j':
+				json = 1;
+			break;
+			default:
+				printf("usage:\n%s [-m max_entries] [-d directory] [-t load_threads] [-j]\n", argv[0]);
+				return 1;
+		}
+	}
+
+	/* Load with the requested threads & time the saves without the fsyncs */
+	setTODOListLoadThreads(loadThreads);
+	setTODOListFsyncPolicy(WRITER_FSYNC_NEVER);
+
+	/* Render headless at a fixed size */
+	setWindowSize(BENCH_ROWS, BENCH_COLS);
+	setRenderOutput(-1);
+
+	if((samples = (double *) malloc(sizeof(double) * BENCH_OPERATIONS)) == NULL) {
+		printf("ERROR allocating samples");
+		return 1;
+	}
+
+	calibrateCycles();
+	benchKernels();
+	for(entries = 1000; entries <= maxEntries; entries *= 10) benchList(directory, entries);
+	printResults(json);
+
+	free(samples);
+	free(results);
+	return 0;
+}
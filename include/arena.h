@@ -0,0 +1,125 @@
+/*
+	C90 TODO List
+	Copyright (C) 2015 Daniel Esteban Nombela <dani@dabuten.co>
+
+	This software is provided 'as-is', without any express or implied
+	warranty. In no event will the author be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+/**
+ *  \file arena.h
+ *
+ *  Header file for the arena allocator functions
+ */
+
+#ifndef _ARENA_H_
+#define _ARENA_H_
+
+/* Using Standard lib, Standard I/O, Strings & Memory mapping */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "stats.h"
+
+/**
+ *  \brief The arena chunk size
+ *         (Bigger allocations get a chunk of their own)
+ */
+#define ARENA_CHUNK_SIZE 1048576
+
+/**
+ *  \brief The arena chunk header struct
+ */
+struct ArenaChunk {
+	struct ArenaChunk *next; /**< A pointer to the next chunk */
+	size_t size;             /**< The chunk size (header included) */
+	size_t used;             /**< The used bytes (header included) */
+};
+
+/**
+ *  \brief The arena struct
+ *
+ *  A bump allocator over a list of mapped chunks.
+ *  A zeroed struct is a valid empty arena.
+ */
+struct Arena {
+	struct ArenaChunk *chunks; /**< A pointer to the current chunk */
+	void *freeList;            /**< The recycled fixed-size objects */
+};
+
+/**
+ *  \brief Allocates memory from an arena
+ *
+ *  \param arena The arena
+ *  \param size The allocation size
+ *  \param align The allocation alignment (a power of two)
+ *
+ *  \return A pointer to the allocated memory
+ */
+void *arenaAlloc(struct Arena *arena, size_t size, size_t align);
+
+/**
+ *  \brief Allocates a fixed-size object, reusing the recycled ones first
+ *
+ *  \param arena The arena
+ *  \param size The object size (must be the same on every call)
+ *
+ *  \return A pointer to the allocated object
+ */
+void *arenaAllocObject(struct Arena *arena, size_t size);
+
+/**
+ *  \brief Recycles a fixed-size object
+ *
+ *  \param arena The arena
+ *  \param object The object to be recycled
+ */
+void arenaRecycleObject(struct Arena *arena, void *object);
+
+/**
+ *  \brief Copies a string range into an arena
+ *
+ *  \param arena The arena
+ *  \param str The string range start
+ *  \param length The string range length
+ *
+ *  \return A pointer to the null-terminated copy
+ */
+char *arenaStrndup(struct Arena *arena, const char *str, size_t length);
+
+/**
+ *  \brief Moves all the memory of an arena into another one
+ *
+ *  The allocations keep their addresses & get freed along with the
+ *  destination arena. The source arena is left empty.
+ *
+ *  \param arena The destination arena
+ *  \param other The source arena
+ */
+void arenaMerge(struct Arena *arena, struct Arena *other);
+
+/**
+ *  \brief Frees all the arena memory
+ *
+ *  \param arena The arena
+ */
+void arenaFree(struct Arena *arena);
+
+#endif /* _ARENA_H_ */
@@ -30,37 +30,516 @@
 #ifndef _DATA_H_
 #define _DATA_H_
 
-/* Using CType, Standard lib, Standard I/O & Strings */
+/* Using CType, Standard lib, Standard I/O, Strings, POSIX threads & POSIX */
 #include <ctype.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <strings.h>
+#include <pthread.h>
+#include <unistd.h>
 
+#include "arena.h"
+#include "index.h"
+#include "intern.h"
+#include "journal.h"
+#include "search.h"
+#include "segment.h"
+#include "snapshot.h"
+#include "stats.h"
+#include "watch.h"
+#include "writer.h"
 #include "lib.h"
 
+/**
+ *  \brief The done entry marker
+ */
+#define DONE_MARKER "✔"
+
+/**
+ *  \brief The pending entry marker
+ */
+#define PENDING_MARKER "✘"
+
+/**
+ *  \brief The minimum entries data size for loading it in parallel
+ */
+#define PARALLEL_LOAD_MIN_SIZE 4194304
+
+/**
+ *  \brief The minimum entries data size parsed by each load thread
+ */
+#define PARALLEL_LOAD_SEGMENT_SIZE 1048576
+
+/**
+ *  \brief The maximum number of load threads
+ */
+#define PARALLEL_LOAD_MAX_THREADS 32
+
+/**
+ *  \brief The share of the list (1 / ratio) a selection has to cover for the
+ *         position index to be rebuilt after deleting it, instead of removing
+ *         the entries from it one by one
+ */
+#define SELECTION_REBUILD_RATIO 8
+
+/**
+ *  \brief The archive filename extension (Replacing the ".txt" one)
+ */
+#define ARCHIVE_EXTENSION ".archive.txt"
+
+/**
+ *  \brief The suffix added to the list title in its archive
+ */
+#define ARCHIVE_TITLE_SUFFIX " (Archive)"
+
+/**
+ *  \brief The maximum number of edits looked for when diffing an external
+ *         change (Past it, the entries get matched in order by title)
+ */
+#define SYNC_MAX_EDITS 512
+
 /**
  *  \brief The TODO entry struct
+ *
+ *  The titles of the loaded entries are views into the mapped list
+ *  file (or snapshot), so they aren't NUL terminated. Only the titles
+ *  of the entries added afterwards get copied, interned (See intern.h)
+ *  so the entries holding the same title share a single copy.
  */
 struct TODOEntry {
-	char *title;            /**< The entry title */
-	char done;              /**< The entry status */
-	struct TODOEntry *next; /**< A pointer to the next entry on the list */
+	const char *title;        /**< The entry title */
+	unsigned int titleLength; /**< The entry title length */
+	char done;                /**< The entry status */
+	unsigned long id;         /**< The entry id (Increasing along the list) */
+	struct TODOEntry *next;   /**< A pointer to the next entry on the list */
 };
 
-/** The TODO list filename **/
-static char *TODOListFilename;
+/**
+ *  \brief The TODO list load segment struct
+ *
+ *  A newline-aligned range of the entries data, parsed on its own
+ *  thread into a chain of entries held by the segment arena.
+ */
+struct TODOLoadSegment {
+	const char *start;                           /**< The data range start */
+	const char *end;                             /**< The data range end */
+	struct Arena arena;                          /**< The arena holding the parsed entries & titles */
+	struct TODOEntry *first;                     /**< The first parsed entry */
+	struct TODOEntry *last;                      /**< The last parsed entry */
+	unsigned long counters[STATS_COUNTERS_COUNT]; /**< The counters of the thread that parsed it */
+	pthread_t thread;                            /**< The thread parsing it */
+	char threaded;                               /**< Whether it's being parsed on its own thread */
+};
 
-/** The TODO list title **/
-static char *TODOListTitle;
+/**
+ *  \brief The synced entry struct
+ *
+ *  An entry of the list file as it was last read or written, so the
+ *  external changes to the file can be told apart from the local ones.
+ */
+struct TODOSyncedEntry {
+	unsigned long id;         /**< The id of the list entry it was read or written from */
+	unsigned long hash;       /**< The entry title hash */
+	unsigned int titleLength; /**< The entry title length */
+	char done;                /**< The entry status (In the file) */
+	char deleted;             /**< Whether the list entry was already deleted back then */
+};
 
-/** Pointer to the first entry in the TODO list **/
-static struct TODOEntry *TODOListFirst;
+/**
+ *  \brief The entries selection range struct
+ */
+struct TODORange {
+	unsigned long first; /**< The first 1-based entry index */
+	unsigned long last;  /**< The last 1-based entry index (Included) */
+};
 
-/** Pointer to the last entry in the TODO list **/
-static struct TODOEntry *TODOListLast;
+/**
+ *  \brief The entries selection struct
+ *
+ *  Parsed from a spec like "3,7,9-12", "10-5000" or "done". The ranges
+ *  are sorted & merged, so a sweep can walk them along with the list.
+ */
+struct TODOSelection {
+	struct TODORange *ranges; /**< The selected ranges */
+	unsigned long count;      /**< The number of ranges */
+	unsigned long capacity;   /**< The number of allocated ranges */
+	char done;                /**< Whether the done entries are selected */
+	char pending;             /**< Whether the pending entries are selected */
+	char intersect;           /**< Whether the ranges only select the entries with those statuses */
+};
+
+/**
+ *  \brief The TODO list load stats struct
+ */
+struct TODOLoadStats {
+	unsigned long bytes; /**< The number of bytes loaded */
+	double seconds;      /**< The time spent loading */
+};
 
 /**
- *  \brief Loads the TODO list from the hard disk
+ *  \brief The TODO list struct
+ *
+ *  Opaque, lists are held through the handles returned by todoListOpen.
+ */
+struct TODOList;
+
+/**
+ *  \brief The TODO list entries visitor (For todoListIterate)
+ *
+ *  \param data The data passed to todoListIterate
+ *  \param entryIndex The 1-based entry index
+ *  \param entry The entry
+ *
+ *  \return Whether to keep iterating
+ */
+typedef char (*TODOListVisitor)(void *data, unsigned long entryIndex, const struct TODOEntry *entry);
+
+/** The journal mode flag (For the lists opened afterwards) **/
+static char TODOListJournalMode;
+
+/** The auto save flag **/
+static char TODOListAutoSave;
+
+/** The snapshot mode flag **/
+static char TODOListSnapshotMode;
+
+/** The number of threads the lists get loaded with (0 for one per CPU) **/
+static unsigned int TODOListLoadThreads;
+
+/** The fsync policy (For the lists opened afterwards) **/
+static int TODOListFsyncPolicy;
+
+/** The maximum number of loaded lists (0 for no limit) **/
+static unsigned long TODOListMaxLoaded;
+
+/** The number of newest entries left out of the archiving at open (0 to disable it) **/
+static unsigned long TODOListArchiveKeep;
+
+/** The watch mode flag (For the lists loaded afterwards) **/
+static char TODOListWatchMode;
+
+/** The segment mode flag (For the lists loaded afterwards) **/
+static char TODOListSegmentMode;
+
+/** The number of loaded lists **/
+static unsigned long TODOListLoadedCount;
+
+/** The most & least recently used loaded lists **/
+static struct TODOList *TODOListNewest, *TODOListOldest;
+
+/** Guards the loaded lists **/
+static pthread_mutex_t TODOListsMutex;
+
+/**
+ *  \brief Returns the list filename for a list name
+ *         (Adding the ".txt" extension if it's missing)
+ *
+ *  \param filename The TODO list filename
+ *
+ *  \return A newly allocated list filename
+ */
+char *todoListFilename(const char *filename);
+
+/**
+ *  \brief Opens a TODO list
+ *
+ *  Maps the binary snapshot when it's fresh, parsing the list file otherwise.
+ *  Either one stays mapped until the list is closed (or evicted), as the
+ *  entries titles point straight into it.
+ *
+ *  With a maximum number of loaded lists, opening or using a list evicts
+ *  the least recently used ones that aren't in use by a call: their changes
+ *  get saved & their entries freed, to be loaded again on their next use.
+ *  So the entries returned by the list functions are only valid until
+ *  another list gets used. Each list can be used on its own thread, the
+ *  loads & the evictions only hold back the threads using those lists.
+ *
+ *  \param filename The TODO list filename (".txt" gets appended if it has no extension)
+ *  \param title The TODO list title (If the file has none, NULL to derive it from the filename)
+ *
+ *  \return The TODO list handle
+ */
+struct TODOList *todoListOpen(const char *filename, const char *title);
+
+/**
+ *  \brief Closes a TODO list
+ *
+ *  Waits for the background writer & frees the list. The changes made
+ *  with the auto save disabled are lost, unless it got flushed first.
+ *
+ *  \param list The TODO list
+ */
+void todoListClose(struct TODOList *list);
+
+/**
+ *  \brief Saves the whole TODO list into the hard disk
+ *
+ *  Replaces the list file through a temp file, after waiting for the
+ *  background writer. A segmented list just gets its dirty segments & its
+ *  manifest written. The list changes get saved by the background writer.
+ *
+ *  \param list The TODO list
+ */
+void todoListSave(struct TODOList *list);
+
+/**
+ *  \brief Waits for the background writer & saves the TODO list
+ *         if it has changes that weren't saved (After the auto
+ *         save got disabled)
+ *
+ *  \param list The TODO list
+ */
+void todoListFlush(struct TODOList *list);
+
+/**
+ *  \brief Adds an entry
+ *
+ *  \param list The TODO list
+ *  \param title The entry title (It gets trimmed & copied into the list arena)
+ *  \param length The entry title length
+ *  \param done Whether the entry is done or not
+ *
+ *  \return Whether the entry was added (The trimmed title isn't empty)
+ */
+char todoListAdd(struct TODOList *list, const char *title, size_t length, char done);
+
+/**
+ *  \brief Deletes an entry
+ *
+ *  \param list The TODO list
+ *  \param entryIndex The 1-based index of the entry to be deleted
+ *
+ *  \return Whether the entry existed
+ */
+char todoListDelete(struct TODOList *list, const unsigned long entryIndex);
+
+/**
+ *  \brief Toggles an entry
+ *
+ *  \param list The TODO list
+ *  \param entryIndex The 1-based index of the entry to be toggled
+ *
+ *  \return Whether the entry existed
+ */
+char todoListToggle(struct TODOList *list, const unsigned long entryIndex);
+
+/**
+ *  \brief Deletes a selection of entries
+ *
+ *  The selection is a comma separated set of indices, ranges ("9-12"),
+ *  "done" & "pending". The indices refer to the list before the deletion,
+ *  which happens in a single sweep & gets persisted once.
+ *
+ *  \param list The TODO list
+ *  \param spec The selection
+ *
+ *  \return The number of deleted entries (0 if the selection is invalid)
+ */
+unsigned long todoListDeleteSelection(struct TODOList *list, const char *spec);
+
+/**
+ *  \brief Toggles a selection of entries
+ *         (In a single sweep, persisted once)
+ *
+ *  \param list The TODO list
+ *  \param spec The selection (See todoListDeleteSelection)
+ *
+ *  \return The number of toggled entries (0 if the selection is invalid)
+ */
+unsigned long todoListToggleSelection(struct TODOList *list, const char *spec);
+
+/**
+ *  \brief Removes the entries holding the same title & status as an earlier one
+ *
+ *  Takes a single sweep with a hash set of the kept entries, so it's O(n).
+ *  The first entry of each title & status is kept, in place.
+ *
+ *  \param list The TODO list
+ *  \param bytes Set to the memory recycled (The removed entries structs &
+ *                the interned titles no entry holds anymore)
+ *
+ *  \return The number of removed entries
+ */
+unsigned long todoListDedupe(struct TODOList *list, size_t *bytes);
+
+/**
+ *  \brief Visits the entries in order (The list mustn't change meanwhile)
+ *
+ *  \param list The TODO list
+ *  \param visit The visitor
+ *  \param data The data passed to the visitor
+ */
+void todoListIterate(struct TODOList *list, TODOListVisitor visit, void *data);
+
+/**
+ *  \brief Returns the TODO list title
+ *
+ *  \param list The TODO list
+ *
+ *  \return A pointer to the TODO list title
+ */
+const char *todoListGetTitle(struct TODOList *list);
+
+/**
+ *  \brief Returns an entry of the TODO list
+ *
+ *  \param list The TODO list
+ *  \param entryIndex The 1-based entry index
+ *
+ *  \return A pointer to the entry or NULL if it's out of range
+ */
+const struct TODOEntry *todoListGetEntry(struct TODOList *list, const unsigned long entryIndex);
+
+/**
+ *  \brief Returns the number of entries in the TODO list
+ *
+ *  \param list The TODO list
+ *
+ *  \return The number of entries
+ */
+unsigned long todoListGetLength(struct TODOList *list);
+
+/**
+ *  \brief Returns the number of done entries in the TODO list
+ *
+ *  It's kept up to date as the entries get added, toggled & deleted.
+ *
+ *  \param list The TODO list
+ *
+ *  \return The number of done entries
+ */
+unsigned long todoListGetDoneCount(struct TODOList *list);
+
+/**
+ *  \brief Filters the TODO list by a search query
+ *
+ *  The entries holding all the words in the query (case-insensitive)
+ *  make up the list view. The search index gets built on the first
+ *  search and kept up to date as entries get added & deleted.
+ *
+ *  \param list The TODO list
+ *  \param query The search query (An empty one clears the filter)
+ */
+void todoListFilter(struct TODOList *list, const char *query);
+
+/**
+ *  \brief Returns the current search query
+ *
+ *  \param list The TODO list
+ *
+ *  \return The search query or NULL if the list isn't filtered
+ */
+const char *todoListGetFilter(struct TODOList *list);
+
+/**
+ *  \brief Returns the number of entries in the list view
+ *         (The matching entries if the list is filtered)
+ *
+ *  \param list The TODO list
+ *
+ *  \return The number of entries in the view
+ */
+unsigned long todoListGetViewLength(struct TODOList *list);
+
+/**
+ *  \brief Returns an entry of the list view
+ *
+ *  \param list The TODO list
+ *  \param viewIndex The 1-based index of the entry in the view
+ *  \param entryIndex Set to the 1-based index of the entry in the list
+ *
+ *  \return A pointer to the entry or NULL if it's out of range
+ */
+const struct TODOEntry *todoListGetViewEntry(struct TODOList *list, const unsigned long viewIndex, unsigned long *entryIndex);
+
+/**
+ *  \brief Returns the position of an entry in the list view
+ *
+ *  \param list The TODO list
+ *  \param entryIndex The 1-based index of the entry in the list
+ *
+ *  \return The 1-based index in the view of the entry
+ *           (or of the next one in the view, if it's filtered out)
+ */
+unsigned long todoListGetViewPosition(struct TODOList *list, const unsigned long entryIndex);
+
+/**
+ *  \brief Returns the stats of the last TODO list load
+ *
+ *  \param list The TODO list
+ *
+ *  \return A pointer to the load stats
+ */
+const struct TODOLoadStats *todoListGetLoadStats(struct TODOList *list);
+
+/**
+ *  \brief Moves the done entries older than the newest ones into the archive
+ *
+ *  The archive is a list file next to the list one ("name.archive.txt"),
+ *  the entries get appended to it without loading it. So the load time,
+ *  memory & saves of the list scale with its active entries only. The
+ *  entries are written into the archive before being taken out of the list,
+ *  so a crash in between can leave them in both files, but never in none.
+ *
+ *  \param list The TODO list
+ *  \param keep The number of newest entries to leave in the list, done or not
+ *
+ *  \return The number of archived entries
+ */
+unsigned long todoListArchive(struct TODOList *list, unsigned long keep);
+
+/**
+ *  \brief Returns the archive of a list
+ *         (Opening it on the first call, closed along with the list)
+ *
+ *  \param list The TODO list
+ *
+ *  \return The archive list handle
+ */
+struct TODOList *todoListGetArchive(struct TODOList *list);
+
+/**
+ *  \brief Writes a TODO list into a single file in the list text format
+ *         (Exporting a segmented list back to the classic layout)
+ *
+ *  \param list The TODO list
+ *  \param filename The filename
+ *
+ *  \return Whether the file got written
+ */
+char todoListExport(struct TODOList *list, const char *filename);
+
+/**
+ *  \brief Merges the changes made to the list file by other processes
+ *         (In watch mode, once its watch descriptor is readable)
+ *
+ *  When the file just got lines appended, only those get parsed & added.
+ *  Otherwise, once the file got written as a whole, it's diffed with the
+ *  entries it held when it was last read or written by the list, and the
+ *  changes get applied on top of the local ones: the added entries get
+ *  inserted in place, the deleted ones removed & the toggled ones get the
+ *  new status. The changes of our own writes get ignored.
+ *
+ *  \param list The TODO list
+ *
+ *  \return Whether the list changed
+ */
+char todoListSync(struct TODOList *list);
+
+/**
+ *  \brief Returns the watch descriptor of a list, to poll it
+ *
+ *  \param list The TODO list
+ *
+ *  \return The watch descriptor (-1 if the list isn't loaded in watch mode)
+ */
+int todoListGetWatchFd(struct TODOList *list);
+
+/**
+ *  \brief Loads the default TODO list (See todoListOpen)
+ *
+ *  The functions without a list handle work on the default list.
  *
  *  \param filename The TODO list filename
  *  \param title The TODO list title
@@ -68,56 +547,268 @@ static struct TODOEntry *TODOListLast;
 void loadTODOList(const char *filename, const char *title);
 
 /**
- *  \brief Saves the TODO list into the hard disk
+ *  \brief Saves the whole default TODO list into the hard disk (See todoListSave)
  */
 void saveTodoList();
 
 /**
- *  \brief Frees the TODO list memory
+ *  \brief Flushes the default TODO list (See todoListFlush)
+ */
+void flushTodoList();
+
+/**
+ *  \brief Writes the default TODO list into a single file (See todoListExport)
+ *
+ *  \param filename The filename
+ *
+ *  \return Whether the file got written
+ */
+char exportTodoList(const char *filename);
+
+/**
+ *  \brief Frees the default TODO list (See todoListClose)
  */
 void freeTodoList();
 
 /**
- *  \brief Adds a new entry parsing the user input
+ *  \brief Adds a new entry to the default TODO list parsing the user input
  *
  *  \param userInput The full user input (A[title])
+ *
+ *  \return Whether the entry was added
  */
-void addNewEntry(char *userInput);
+char addNewEntry(char *userInput);
 
 /**
- *  \brief Adds an entry
+ *  \brief Adds an entry to the default TODO list (Without persisting it)
  *
- *  \param title The entry title
+ *  \param title The entry title (It gets copied into the list arena)
  *  \param done Whether the entry is done or not
  */
-void addEntry(char *title, char done);
+void addEntry(const char *title, char done);
 
 /**
- *  \brief Deletes an entry
+ *  \brief Deletes an entry of the default TODO list
  *
- *  \param entryIndex The index of the entry to be deleted
+ *  \param entryIndex The 1-based index of the entry to be deleted
+ *
+ *  \return Whether the entry existed
  */
-void deleteEntry(const unsigned short int entryIndex);
+char deleteEntry(const unsigned long entryIndex);
 
 /**
- *  \brief Toggles an entry
+ *  \brief Toggles an entry of the default TODO list
  *
- *  \param entryIndex The index of the entry to be toggled
+ *  \param entryIndex The 1-based index of the entry to be toggled
+ *
+ *  \return Whether the entry existed
  */
-void toggleEntry(const unsigned short int entryIndex);
+char toggleEntry(const unsigned long entryIndex);
 
 /**
- *  \brief Returns the TODO list title
+ *  \brief Deletes a selection of entries of the default TODO list
+ *
+ *  \param spec The selection (See todoListDeleteSelection)
+ *
+ *  \return The number of deleted entries
+ */
+unsigned long deleteEntries(const char *spec);
+
+/**
+ *  \brief Toggles a selection of entries of the default TODO list
+ *
+ *  \param spec The selection (See todoListDeleteSelection)
+ *
+ *  \return The number of toggled entries
+ */
+unsigned long toggleEntries(const char *spec);
+
+/**
+ *  \brief Removes the duplicate entries of the default TODO list (See todoListDedupe)
+ *
+ *  \param bytes Set to the memory recycled
+ *
+ *  \return The number of removed entries
+ */
+unsigned long dedupeEntries(size_t *bytes);
+
+/**
+ *  \brief Returns the default TODO list title
  *
  *  \return A pointer to the TODO list title
  */
 const char *getTODOListTitle();
 
 /**
- *  \brief Returns the first entry in the TODO
+ *  \brief Returns the first entry in the default TODO list
  *
  *  \return A pointer to the first entry in the TODO list
  */
 const struct TODOEntry *getTODOListFirst();
 
+/**
+ *  \brief Returns an entry of the default TODO list
+ *
+ *  \param entryIndex The 1-based entry index
+ *
+ *  \return A pointer to the entry or NULL if it's out of range
+ */
+const struct TODOEntry *getTODOListEntry(const unsigned long entryIndex);
+
+/**
+ *  \brief Returns the number of entries in the default TODO list
+ *
+ *  \return The number of entries
+ */
+unsigned long getTODOListLength();
+
+/**
+ *  \brief Returns the number of done entries in the default TODO list
+ *
+ *  \return The number of done entries
+ */
+unsigned long getTODOListDoneCount();
+
+/**
+ *  \brief Filters the default TODO list by a search query (See todoListFilter)
+ *
+ *  \param query The search query (An empty one clears the filter)
+ */
+void filterTODOList(const char *query);
+
+/**
+ *  \brief Returns the current search query of the default TODO list
+ *
+ *  \return The search query or NULL if the list isn't filtered
+ */
+const char *getTODOListFilter();
+
+/**
+ *  \brief Returns the number of entries in the default TODO list view
+ *
+ *  \return The number of entries in the view
+ */
+unsigned long getTODOListViewLength();
+
+/**
+ *  \brief Returns an entry of the default TODO list view
+ *
+ *  \param viewIndex The 1-based index of the entry in the view
+ *  \param entryIndex Set to the 1-based index of the entry in the list
+ *
+ *  \return A pointer to the entry or NULL if it's out of range
+ */
+const struct TODOEntry *getTODOListViewEntry(const unsigned long viewIndex, unsigned long *entryIndex);
+
+/**
+ *  \brief Returns the position of an entry in the default TODO list view
+ *
+ *  \param entryIndex The 1-based index of the entry in the list
+ *
+ *  \return The 1-based index in the view of the entry
+ *           (or of the next one in the view, if it's filtered out)
+ */
+unsigned long getTODOListViewPosition(const unsigned long entryIndex);
+
+/**
+ *  \brief Returns the handle of the default TODO list
+ *
+ *  \return The default TODO list handle
+ */
+struct TODOList *getTODOListDefault();
+
+/**
+ *  \brief Returns the stats of the last default TODO list load
+ *
+ *  \return A pointer to the load stats
+ */
+const struct TODOLoadStats *getTODOListLoadStats();
+
+/**
+ *  \brief Enables or disables the journal mode
+ *
+ *  In journal mode, the mutations get appended to a sidecar journal
+ *  instead of rewriting the whole list file every time. It must be
+ *  set before opening the TODO lists.
+ *
+ *  \param enabled Whether the journal mode is enabled
+ */
+void setTODOListJournalMode(char enabled);
+
+/**
+ *  \brief Enables or disables saving the TODO lists after every change
+ *
+ *  \param enabled Whether the auto save is enabled
+ */
+void setTODOListAutoSave(char enabled);
+
+/**
+ *  \brief Sets the number of threads the TODO lists get loaded with
+ *
+ *  List files bigger than PARALLEL_LOAD_MIN_SIZE get their entries
+ *  split into newline-aligned segments, parsed in parallel & linked
+ *  in file order. The result is identical to a sequential load.
+ *
+ *  \param threads The number of threads (0 for one per CPU, 1 to load sequentially)
+ */
+void setTODOListLoadThreads(unsigned int threads);
+
+/**
+ *  \brief Sets when the TODO list files get fsynced
+ *         (For the lists opened afterwards)
+ *
+ *  \param policy The fsync policy (WRITER_FSYNC_ALWAYS, WRITER_FSYNC_INTERVAL or WRITER_FSYNC_NEVER)
+ */
+void setTODOListFsyncPolicy(int policy);
+
+/**
+ *  \brief Enables or disables the snapshot mode
+ *
+ *  In snapshot mode, every time a list file is saved a binary
+ *  snapshot gets written next to it, so the next load can just map it.
+ *
+ *  \param enabled Whether the snapshot mode is enabled
+ */
+void setTODOListSnapshotMode(char enabled);
+
+/**
+ *  \brief Sets the maximum number of loaded TODO lists
+ *
+ *  The least recently used lists get evicted past it (See todoListOpen).
+ *
+ *  \param max The maximum number of loaded lists (0 for no limit)
+ */
+void setTODOListMaxLoaded(unsigned long max);
+
+/**
+ *  \brief Sets how many of the newest entries the lists keep when they get opened
+ *         (Archiving the done entries older than them, see todoListArchive)
+ *
+ *  \param keep The number of newest entries to keep (0 to disable the archiving)
+ */
+void setTODOListArchiveKeep(unsigned long keep);
+
+/**
+ *  \brief Enables or disables the watch mode
+ *
+ *  In watch mode, the lists keep watching their files for the changes made
+ *  by other processes (See todoListSync). It must be set before loading them.
+ *
+ *  \param enabled Whether the watch mode is enabled
+ */
+void setTODOListWatchMode(char enabled);
+
+/**
+ *  \brief Enables or disables the segment mode
+ *
+ *  In segment mode, the lists loaded from a single file get moved into
+ *  segments of SEGMENT_MAX_ENTRIES entries (See segment.h), so each save
+ *  only rewrites the segments that changed. The lists that already got
+ *  segments load & save them either way. The segmented lists aren't
+ *  snapshotted nor watched. It must be set before loading them.
+ *
+ *  \param enabled Whether the segment mode is enabled
+ */
+void setTODOListSegmentMode(char enabled);
+
 #endif /* _DATA_H_ */
@@ -0,0 +1,116 @@
+/*
+	C90 TODO List
+	Copyright (C) 2015 Daniel Esteban Nombela <dani@dabuten.co>
+
+	This software is provided 'as-is', without any express or implied
+	warranty. In no event will the author be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+/**
+ *  \file index.h
+ *
+ *  Header file for the positional index functions
+ */
+
+#ifndef _INDEX_H_
+#define _INDEX_H_
+
+/* Using Standard lib, Standard I/O & Strings */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+/**
+ *  \brief The maximum number of items per index block
+ */
+#define INDEX_BLOCK_SIZE 256
+
+/**
+ *  \brief The positional index block struct
+ */
+struct IndexBlock {
+	unsigned long count;                  /**< The number of items in the block */
+	void *items[INDEX_BLOCK_SIZE];        /**< The block items */
+};
+
+/**
+ *  \brief The positional index struct
+ *
+ *  A chunked array of item pointers with the per-block counts
+ *  kept in a Fenwick tree, so items can be found by their
+ *  1-based position in O(log n) and removed without
+ *  renumbering the whole array. A zeroed struct is a valid
+ *  empty index.
+ */
+struct PositionIndex {
+	struct IndexBlock **blocks;   /**< The blocks */
+	unsigned long *counts;        /**< The Fenwick tree over the block counts (1-based) */
+	unsigned long blocksCount;    /**< The number of blocks in use */
+	unsigned long blocksCapacity; /**< The number of allocated block slots */
+	unsigned long emptyBlocks;    /**< The number of empty blocks */
+	unsigned long count;          /**< The total number of items */
+};
+
+/**
+ *  \brief Appends an item to the index
+ *
+ *  \param index The index
+ *  \param item The item
+ */
+void indexAppend(struct PositionIndex *index, void *item);
+
+/**
+ *  \brief Returns the item at a position
+ *
+ *  \param index The index
+ *  \param position The 1-based item position
+ *
+ *  \return The item or NULL if the position is out of range
+ */
+void *indexGet(const struct PositionIndex *index, unsigned long position);
+
+/**
+ *  \brief Removes the item at a position
+ *
+ *  \param index The index
+ *  \param position The 1-based item position
+ */
+void indexRemove(struct PositionIndex *index, unsigned long position);
+
+/**
+ *  \brief Finds the position of an item
+ *
+ *  Binary searches the index, so the items must be sorted
+ *  according to the comparison function.
+ *
+ *  \param index The index
+ *  \param item The item
+ *  \param compare The item comparison function
+ *
+ *  \return The 1-based item position or 0 if it's not in the index
+ */
+unsigned long indexFind(const struct PositionIndex *index, const void *item, int (*compare)(const void *, const void *));
+
+/**
+ *  \brief Frees the index memory
+ *
+ *  \param index The index
+ */
+void indexFree(struct PositionIndex *index);
+
+#endif /* _INDEX_H_ */
@@ -0,0 +1,119 @@
+/*
+	C90 TODO List
+	Copyright (C) 2015 Daniel Esteban Nombela <dani@dabuten.co>
+
+	This software is provided 'as-is', without any express or implied
+	warranty. In no event will the author be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+/**
+ *  \file intern.h
+ *
+ *  Header file for the title interning functions
+ *
+ *  The interned titles are shared by all the entries holding the same
+ *  text, each one counted as a reference. So they're never written into:
+ *  changing the title of an entry means interning the new one & releasing
+ *  the old one (Copy on write).
+ */
+
+#ifndef _INTERN_H_
+#define _INTERN_H_
+
+/* Using Standard lib, Standard I/O & Strings */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "arena.h"
+#include "stats.h"
+
+/**
+ *  \brief The initial number of title slots
+ */
+#define INTERN_INITIAL_SLOTS 1024
+
+/**
+ *  \brief The step between the title size classes (At least a pointer long)
+ */
+#define INTERN_SIZE_STEP 8
+
+/**
+ *  \brief The number of title size classes
+ *         (Longer titles get allocated on their own)
+ */
+#define INTERN_SIZE_CLASSES 32
+
+/**
+ *  \brief The interned title struct
+ */
+struct InternedTitle {
+	char *title;         /**< The title (Null-terminated) */
+	size_t length;       /**< The title length */
+	unsigned long hash;  /**< The title hash */
+	unsigned long refs;  /**< The number of references to it */
+};
+
+/**
+ *  \brief The intern table struct
+ *
+ *  An open addressing table of the interned titles, holding them in its
+ *  arena by size class. The released titles leave the table & their
+ *  blocks get recycled for the next titles of their class (The longer
+ *  ones get freed). A zeroed struct is a valid empty table.
+ */
+struct InternTable {
+	struct InternedTitle **slots;           /**< The open addressing title table */
+	unsigned long slotsCount;               /**< The number of title slots (a power of two) */
+	unsigned long titlesCount;              /**< The number of titles */
+	struct Arena arena;                     /**< The arena holding the titles */
+	void *freeTitles[INTERN_SIZE_CLASSES];  /**< The recycled title blocks of each size class */
+};
+
+/**
+ *  \brief Takes a reference to the interned copy of a title
+ *         (Copying it into the table the first time)
+ *
+ *  \param table The table
+ *  \param title The title range start
+ *  \param length The title range length
+ *
+ *  \return The interned title (Null-terminated)
+ */
+const char *internTitle(struct InternTable *table, const char *title, size_t length);
+
+/**
+ *  \brief Releases a reference to an interned title
+ *         (Recycling its memory along with the last one)
+ *
+ *  \param table The table
+ *  \param title The title (Nothing happens if it isn't an interned one)
+ *  \param length The title length
+ *
+ *  \return The bytes recycled (The title block & its struct, 0 if it's still referenced)
+ */
+size_t internRelease(struct InternTable *table, const char *title, size_t length);
+
+/**
+ *  \brief Frees the table memory (Along with the titles)
+ *
+ *  \param table The table
+ */
+void internFree(struct InternTable *table);
+
+#endif /* _INTERN_H_ */
@@ -0,0 +1,208 @@
+/*
+	C90 TODO List
+	Copyright (C) 2015 Daniel Esteban Nombela <dani@dabuten.co>
+
+	This software is provided 'as-is', without any express or implied
+	warranty. In no event will the author be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+/**
+ *  \file journal.h
+ *
+ *  Header file for the operation journal functions
+ *
+ *  The journal is a sidecar log of the list mutations, appended one
+ *  record per operation. It starts with a header identifying the base
+ *  file it applies to, so a journal left behind by a base file that got
+ *  rewritten afterwards is never replayed on top of it.
+ */
+
+#ifndef _JOURNAL_H_
+#define _JOURNAL_H_
+
+/* Using Errors, Standard lib, Standard I/O, Strings, POSIX I/O & Vectored I/O */
+#include <errno.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#include "lib.h"
+#include "stats.h"
+
+/**
+ *  \brief The journal filename extension
+ */
+#define JOURNAL_EXTENSION ".journal"
+
+/**
+ *  \brief The journal header magic
+ */
+#define JOURNAL_MAGIC "TODOJOURNAL1"
+
+/**
+ *  \brief The journal size under which it never gets compacted
+ */
+#define JOURNAL_COMPACT_MIN_SIZE 65536
+
+/**
+ *  \brief The base size to journal size ratio that triggers a compaction
+ */
+#define JOURNAL_COMPACT_RATIO 4
+
+/**
+ *  \brief The journal record operations
+ */
+enum JOURNAL_OPS {
+	JOURNAL_ADD = 'A',
+	JOURNAL_DELETE = 'D',
+	JOURNAL_TOGGLE = 'T',
+	JOURNAL_DELETE_SELECTION = 'd',
+	JOURNAL_TOGGLE_SELECTION = 't',
+	JOURNAL_DEDUPE = 'U'
+};
+
+/**
+ *  \brief Whether the records of an operation hold a text (The title or the selection) instead of an index
+ */
+#define JOURNAL_HAS_TEXT(op) ((op) == JOURNAL_ADD || (op) == JOURNAL_DELETE_SELECTION || (op) == JOURNAL_TOGGLE_SELECTION)
+
+/**
+ *  \brief The journal struct
+ */
+struct Journal {
+	int fd;                   /**< The journal file descriptor (-1 when closed) */
+	char *filename;           /**< The journal filename */
+	unsigned long size;       /**< The journal size */
+	struct FileIdentity base; /**< The identity of the base file it applies to */
+	int sync;                 /**< What gets fsynced (WRITE_SYNC_* constant, WRITE_SYNC_ALL syncs every record) */
+};
+
+/**
+ *  \brief The journal replay callback
+ *
+ *  \param data The data passed to journalReplay
+ *  \param op The record operation
+ *  \param index The record entry index (JOURNAL_DELETE & JOURNAL_TOGGLE)
+ *  \param title The record text range start (The title or the selection)
+ *  \param length The record text range length
+ */
+typedef void (*JournalApply)(void *data, char op, unsigned long index, const char *title, size_t length);
+
+/**
+ *  \brief Returns the journal filename for a base file
+ *
+ *  \param baseFilename The base filename
+ *
+ *  \return A newly allocated journal filename
+ */
+char *journalFilename(const char *baseFilename);
+
+/**
+ *  \brief Replays a journal on top of its base file
+ *
+ *  \param filename The journal filename
+ *  \param base The identity of the loaded base file
+ *  \param apply The callback applying each record
+ *  \param data The data passed to the callback
+ *  \param validSize Where to store the size of the valid journal prefix
+ *                   (0 if the journal is missing or belongs to another base)
+ *
+ *  \return The number of replayed records
+ */
+unsigned long journalReplay(const char *filename, const struct FileIdentity *base, JournalApply apply, void *data, unsigned long *validSize);
+
+/**
+ *  \brief Opens a journal for appending
+ *
+ *  \param journal The journal
+ *  \param baseFilename The base filename
+ *  \param validSize The size of the valid journal prefix to keep
+ *                   (0 to start a fresh one)
+ *  \param sync What to fsync (WRITE_SYNC_* constant)
+ */
+void journalOpen(struct Journal *journal, const char *baseFilename, unsigned long validSize, int sync);
+
+/**
+ *  \brief Appends a record to the journal
+ *
+ *  A record that can't be written whole gets truncated away, so the
+ *  journal never holds a torn record before the valid ones.
+ *
+ *  \param journal The journal
+ *  \param op The record operation
+ *  \param index The record entry index (JOURNAL_DELETE & JOURNAL_TOGGLE)
+ *  \param title The record text (The title or the selection)
+ *  \param length The record text length
+ *
+ *  \return Whether it got written
+ */
+char journalAppend(struct Journal *journal, char op, unsigned long index, const char *title, size_t length);
+
+/**
+ *  \brief Checks whether the journal has grown enough to be compacted
+ *
+ *  \param journal The journal
+ *
+ *  \return Whether the journal should be compacted
+ */
+char journalNeedsCompaction(const struct Journal *journal);
+
+/**
+ *  \brief Checks whether the journal holds records on top of its base file
+ *
+ *  \param journal The journal
+ *
+ *  \return Whether it has records (False if it's closed)
+ */
+char journalHasRecords(const struct Journal *journal);
+
+/**
+ *  \brief Restarts the journal after its base file got rewritten
+ *
+ *  \param journal The journal
+ *  \param baseFilename The base filename
+ */
+void journalReset(struct Journal *journal, const char *baseFilename);
+
+/**
+ *  \brief Restarts the journal after its base file got rewritten in the background
+ *
+ *  The records appended after the base file contents were taken get
+ *  kept, as they still have to be applied on top of it. The new journal
+ *  gets written next to it & renamed over it, so a crash leaves either
+ *  one whole.
+ *
+ *  \param journal The journal
+ *  \param baseFilename The base filename
+ *  \param offset The journal size when the base file contents were taken
+ */
+void journalRebase(struct Journal *journal, const char *baseFilename, unsigned long offset);
+
+/**
+ *  \brief Closes the journal
+ *         (Removing its file if it holds no records on top of the base file)
+ *
+ *  \param journal The journal
+ */
+void journalClose(struct Journal *journal);
+
+#endif /* _JOURNAL_H_ */
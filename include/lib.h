@@ -30,9 +30,24 @@
 #ifndef _LIB_H_
 #define _LIB_H_
 
-/* Using CType, Standard I/O & Strings */
+/* Using CType, Errors, Standard lib, Standard I/O, Strings, Time, POSIX I/O & Poll */
 #include <ctype.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <stdio.h>
 #include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* Using the SSE2 & AVX2 intrinsics (On x86) */
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SCAN_KERNELS_X86
+#endif
 
 /**
  *  \brief The maximum buffer size
@@ -40,6 +55,54 @@
  */
 #define MAX_BUFFER_SIZE 511
 
+/**
+ *  \brief The block size for reading files that can't be mapped
+ */
+#define LOAD_BLOCK_SIZE 65536
+
+/**
+ *  \brief The scanning kernels
+ *
+ *  The plain C ones, the 16 bytes (SSE2) & the 32 bytes (AVX2) wide ones.
+ */
+#define SCAN_KERNELS_SCALAR 0
+#define SCAN_KERNELS_SSE2 1
+#define SCAN_KERNELS_AVX2 2
+
+/**
+ *  \brief The scanning kernels struct
+ *
+ *  The whitespace bytes are the ones isspace matches in the C locale.
+ */
+struct ScanKernels {
+	const char *(*findByte)(const char *str, const char *end, const char byte); /**< Finds a byte (Or returns the end) */
+	const char *(*skipSpaces)(const char *str, const char *end);                /**< Skips the leading whitespace */
+	const char *(*skipTrailingSpaces)(const char *str, const char *end);        /**< Skips the trailing whitespace (Returns the new end) */
+};
+
+/**
+ *  \brief The file identity struct
+ *
+ *  Tells whether a file is still the same one that was read or written.
+ */
+struct FileIdentity {
+	unsigned long size;      /**< The file size */
+	unsigned long inode;     /**< The file inode */
+	unsigned long mtime;     /**< The file modification time (seconds) */
+	unsigned long mtimeNsec; /**< The file modification time (nanoseconds) */
+};
+
+/**
+ *  \brief The growable byte buffer struct
+ *
+ *  A zeroed struct is a valid empty buffer.
+ */
+struct Buffer {
+	char *data;      /**< The buffer data */
+	size_t length;   /**< The used bytes */
+	size_t capacity; /**< The allocated bytes */
+};
+
 /**
  *  \brief A really simple trimming function
  *
@@ -49,4 +112,145 @@
  */
 char *trim(char *str);
 
+/**
+ *  \brief Trims a non null-terminated string range in place
+ *
+ *  \param str The start of the range
+ *  \param length The range length (Updated with the trimmed length)
+ *
+ *  \return A pointer to the start of the trimmed range
+ */
+const char *trimRange(const char *str, size_t *length);
+
+/**
+ *  \brief Finds the first occurrence of a byte in a range
+ *
+ *  \param str The start of the range
+ *  \param end The end of the range
+ *  \param byte The byte to look for
+ *
+ *  \return A pointer to the byte or the range end if it isn't there
+ */
+const char *findByte(const char *str, const char *end, const char byte);
+
+/**
+ *  \brief Selects the scanning kernels
+ *
+ *  The widest ones the CPU supports get selected at startup.
+ *
+ *  \param kernels The kernels (Lowered to the widest ones the CPU supports)
+ *
+ *  \return The selected kernels
+ */
+int setScanKernels(int kernels);
+
+/**
+ *  \brief Maps a whole file into memory
+ *
+ *  Regular files are memory-mapped. Anything that can't be mapped
+ *  (empty files, pipes...) is read in large blocks into the heap.
+ *
+ *  \param filename The file name
+ *  \param size Where to store the file size
+ *  \param mapped Where to store whether the data was mapped or allocated
+ *
+ *  \return A pointer to the file data or NULL if the file couldn't be opened
+ */
+char *mapFile(const char *filename, size_t *size, char *mapped);
+
+/**
+ *  \brief Reads a whole file into the heap (Release it with unmapFile, as not mapped)
+ *
+ *  Unlike a mapping, the copy is left as it is when other processes
+ *  rewrite the file in place.
+ *
+ *  \param filename The filename
+ *  \param size Set to the file size
+ *
+ *  \return The file data or NULL if it couldn't be opened
+ */
+char *readFile(const char *filename, size_t *size);
+
+/**
+ *  \brief Releases a file mapped by mapFile
+ *
+ *  \param data The file data
+ *  \param size The file size
+ *  \param mapped Whether the data was mapped or allocated
+ */
+void unmapFile(char *data, size_t size, char mapped);
+
+/**
+ *  \brief Reads the identity of a file
+ *
+ *  \param filename The filename
+ *  \param identity Where to store the identity (zeroed if the file is missing)
+ */
+void getFileIdentity(const char *filename, struct FileIdentity *identity);
+
+/**
+ *  \brief Appends bytes to a buffer, growing it as needed
+ *
+ *  \param buffer The buffer
+ *  \param data The bytes to be appended
+ *  \param length The number of bytes
+ */
+void bufferAppend(struct Buffer *buffer, const char *data, size_t length);
+
+/**
+ *  \brief Writes the whole buffer into a file descriptor & empties it
+ *         (Polling a non-blocking one while it takes no more)
+ *
+ *  \param buffer The buffer
+ *  \param fd The file descriptor
+ *
+ *  \return Whether all the bytes got written
+ */
+char bufferFlush(struct Buffer *buffer, int fd);
+
+/**
+ *  \brief Sync level constants (What gets fsynced when a file is replaced)
+ */
+enum WRITE_SYNC_LEVELS {
+	WRITE_SYNC_NONE, /**< Leave it to the OS */
+	WRITE_SYNC_DATA, /**< Fsync the temp file before it gets renamed, so the file never holds partial contents */
+	WRITE_SYNC_ALL   /**< Fsync the temp file & the directory after the rename, so the new contents are durable */
+};
+
+/**
+ *  \brief Replaces a file with the buffer contents & empties it
+ *
+ *  Writes a temp file next to it & renames it over the file, so
+ *  readers (or a crash) only ever see the old or the new contents.
+ *  The file keeps its permissions.
+ *
+ *  \param filename The filename
+ *  \param buffer The buffer
+ *  \param sync What to fsync before returning (WRITE_SYNC_* constant)
+ *
+ *  \return Whether the file got replaced
+ */
+char writeFileAtomically(const char *filename, struct Buffer *buffer, const int sync);
+
+/**
+ *  \brief Fsyncs a file & its directory
+ *
+ *  \param filename The filename
+ */
+void syncFile(const char *filename);
+
+/**
+ *  \brief Frees the buffer memory
+ *
+ *  \param buffer The buffer
+ */
+void bufferFree(struct Buffer *buffer);
+
+/**
+ *  \brief Returns the current value of the monotonic clock
+ *
+ *  \return The monotonic time in seconds
+ */
+double getMonotonicTime();
+
 #endif /* _LIB_H_ */
@@ -30,12 +30,16 @@
 #ifndef _RENDER_H_
 #define _RENDER_H_
 
-/* Using Standard I/O, Strings & IOCTL */
+/* Using Standard lib, Standard I/O, Strings, IOCTL & POSIX I/O */
+#include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <sys/ioctl.h>
+#include <unistd.h>
 
 #include "data.h"
+#include "lib.h"
+#include "stats.h"
 
 /**
 *   \brief Clears the screen
@@ -66,25 +70,164 @@ enum ANSI_COLORS {
 	WHITE
 };
 
+/**
+*   \brief The window size used when the terminal size can't be read
+*/
+#define DEFAULT_WINDOW_ROWS 24
+#define DEFAULT_WINDOW_COLS 80
+
+/**
+*   \brief The row the entries viewport starts at
+*/
+#define VIEWPORT_ROW 4
+
+/**
+*   \brief The number of commands in the help
+*/
+#define HELP_COMMANDS 10
+
+/**
+*   \brief The number of unchanged cells that still get rewritten
+*          to join two changed spans (Cheaper than a cursor move)
+*/
+#define SPAN_JOIN_DISTANCE 8
+
+/**
+*   \brief The minimum time between the renders of a burst of resizes (seconds)
+*/
+#define RESIZE_RENDER_INTERVAL (1.0 / 60)
+
+/**
+ *  \brief The frame cell struct
+ */
+struct FrameCell {
+	char text[4];         /**< The UTF-8 encoded character */
+	unsigned char length; /**< The character length (0 for a blank cell) */
+	unsigned char color;  /**< The character color */
+};
+
+/**
+ *  \brief The frame struct
+ */
+struct Frame {
+	struct FrameCell *cells; /**< The frame cells (rows * cols) */
+	unsigned short rows;     /**< The frame rows */
+	unsigned short cols;     /**< The frame columns */
+};
+
 /** The current window size **/
 static struct winsize windowSize;
 
 /** The help rendering flag **/
 static char renderHelp;
 
+/** The frame being composed & the one on the screen **/
+static struct Frame nextFrame, screenFrame;
+
+/** The number of bytes written by the last frame **/
+static unsigned long frameBytes;
+
+/** The output buffer the frames get assembled into **/
+static struct Buffer frameBuffer;
+
+/** The title decoration string (A row of '=') **/
+static char *titleDecoration;
+
+/** The color the terminal is currently set to (-1 if unknown) **/
+static int terminalColor;
+
+/** The 0-based index of the first entry in the viewport **/
+static unsigned long scrollOffset;
+
+/** The file descriptor the frames get written to (-1 for headless rendering) **/
+static int renderOutput;
+
+/** The list on the screen (NULL for the default TODO list) **/
+static struct TODOList *renderList;
+
+/** The notice shown over the viewport (Empty if there's none) **/
+static char renderNotice[96];
+
 /**
  *  \brief Updates the window size
  */
 void updateWindowSize();
 
+/**
+ *  \brief Sets a fixed window size
+ *
+ *  \param rows The window rows
+ *  \param cols The window columns
+ */
+void setWindowSize(const unsigned short rows, const unsigned short cols);
+
+/**
+ *  \brief Sets where the frames get written to
+ *
+ *  \param fd The file descriptor (-1 to compose the frames without writing them)
+ */
+void setRenderOutput(const int fd);
+
+/**
+ *  \brief Sets the list on the screen
+ *         (Scrolling back to its top)
+ *
+ *  \param list The TODO list (NULL for the default TODO list)
+ */
+void setRenderList(struct TODOList *list);
+
+/**
+ *  \brief Returns the list on the screen
+ *
+ *  \return The TODO list handle
+ */
+struct TODOList *getRenderList();
+
+/**
+ *  \brief Sets the notice shown over the viewport
+ *         (Unless the list is filtered, as the search goes there)
+ *
+ *  \param notice The notice (NULL to clear it)
+ */
+void setRenderNotice(const char *notice);
+
 /**
  *  \brief Toggles help rendering
  */
 void toggleHelp();
 
+/**
+ *  \brief Scrolls the viewport by pages
+ *
+ *  \param pages The number of pages (Negative to scroll up)
+ */
+void scrollPage(const int pages);
+
+/**
+ *  \brief Scrolls the viewport to an entry
+ *         (Putting it on top, unless that's past the last page.
+ *          If it's filtered out, the next match goes on top)
+ *
+ *  \param entryIndex The 1-based entry index
+ */
+void scrollTo(const unsigned long entryIndex);
+
 /**
  *  \brief Renders the GUI
+ *
+ *  Composes the frame into a cell buffer and only writes the cells
+ *  that changed since the previous frame. The screen is only fully
+ *  repainted on the first frame and after the window gets resized.
+ *  The output gets assembled into a single buffer, written at once.
+ *  Only the entries in the viewport get formatted.
  */
 void render();
 
+/**
+ *  \brief Returns the number of bytes written by the last frame
+ *
+ *  \return The frame bytes
+ */
+unsigned long getFrameBytes();
+
 #endif /* _RENDER_H_ */
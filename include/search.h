@@ -0,0 +1,159 @@
+/*
+	C90 TODO List
+	Copyright (C) 2015 Daniel Esteban Nombela <dani@dabuten.co>
+
+	This software is provided 'as-is', without any express or implied
+	warranty. In no event will the author be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+/**
+ *  \file search.h
+ *
+ *  Header file for the search index functions
+ */
+
+#ifndef _SEARCH_H_
+#define _SEARCH_H_
+
+/* Using CType, Standard lib, Standard I/O & Strings */
+#include <ctype.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "arena.h"
+
+/**
+ *  \brief The initial number of token slots
+ */
+#define SEARCH_INITIAL_SLOTS 1024
+
+/**
+ *  \brief The maximum number of tokens in a query
+ */
+#define SEARCH_MAX_QUERY_TOKENS 16
+
+/**
+ *  \brief The search posting list struct
+ *
+ *  The items holding a token, sorted by their key.
+ */
+struct SearchPosting {
+	char *token;            /**< The lowercase token */
+	size_t length;          /**< The token length */
+	unsigned long hash;     /**< The token hash */
+	void **items;                /**< The items holding the token (NULL for the marked ones) */
+	unsigned long *keys;         /**< The items keys (Kept apart so searching them stays in cache) */
+	unsigned long count;         /**< The number of items */
+	unsigned long capacity;      /**< The allocated item slots */
+	struct SearchPosting *dirty; /**< The next posting list with marked items (or NULL) */
+	char marked;                 /**< Whether it has marked items */
+};
+
+/**
+ *  \brief The search index struct
+ *
+ *  An inverted index from the case-insensitive words of the items text
+ *  to the items holding them. The items must be added in increasing key
+ *  order, so the posting lists stay sorted & can be intersected by
+ *  galloping through them. A zeroed struct with the key function set is a valid
+ *  empty index.
+ */
+struct SearchIndex {
+	struct SearchPosting **slots;         /**< The open addressing token table */
+	unsigned long slotsCount;             /**< The number of token slots (a power of two) */
+	unsigned long tokensCount;            /**< The number of tokens */
+	unsigned long (*key)(const void *item); /**< The item key function */
+	struct SearchPosting *dirty;          /**< The posting lists with marked items */
+	struct Arena arena;                   /**< The arena holding the tokens & posting lists */
+};
+
+/**
+ *  \brief The search results struct
+ */
+struct SearchResults {
+	void **items;           /**< The matching items, sorted by their key */
+	unsigned long count;    /**< The number of items */
+	unsigned long capacity; /**< The allocated item slots */
+};
+
+/**
+ *  \brief Adds an item to the index
+ *
+ *  \param index The index
+ *  \param text The item text
+ *  \param length The item text length
+ *  \param item The item (With a key greater than all the indexed ones)
+ */
+void searchIndexAdd(struct SearchIndex *index, const char *text, size_t length, void *item);
+
+/**
+ *  \brief Removes an item from the index
+ *
+ *  \param index The index
+ *  \param text The item text (The same it was added with)
+ *  \param length The item text length
+ *  \param item The item
+ */
+void searchIndexRemove(struct SearchIndex *index, const char *text, size_t length, void *item);
+
+/**
+ *  \brief Marks an item for removal from the index
+ *
+ *  The bulk removals mark their items & compact the posting lists once,
+ *  instead of shifting them on each removal. The index can't be queried
+ *  until it gets compacted.
+ *
+ *  \param index The index
+ *  \param text The item text (The same it was added with)
+ *  \param length The item text length
+ *  \param item The item
+ */
+void searchIndexMark(struct SearchIndex *index, const char *text, size_t length, void *item);
+
+/**
+ *  \brief Removes the marked items from the index
+ *
+ *  \param index The index
+ */
+void searchIndexCompact(struct SearchIndex *index);
+
+/**
+ *  \brief Finds the items holding all the words of a query
+ *
+ *  \param index The index
+ *  \param query The query
+ *  \param results The results (Replaced with the matching items)
+ */
+void searchIndexQuery(const struct SearchIndex *index, const char *query, struct SearchResults *results);
+
+/**
+ *  \brief Frees the index memory
+ *
+ *  \param index The index
+ */
+void searchIndexFree(struct SearchIndex *index);
+
+/**
+ *  \brief Frees the results memory
+ *
+ *  \param results The results
+ */
+void searchResultsFree(struct SearchResults *results);
+
+#endif /* _SEARCH_H_ */
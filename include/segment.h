@@ -0,0 +1,225 @@
+/*
+	C90 TODO List
+	Copyright (C) 2015 Daniel Esteban Nombela <dani@dabuten.co>
+
+	This software is provided 'as-is', without any express or implied
+	warranty. In no event will the author be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+/**
+ *  \file segment.h
+ *
+ *  Header file for the segmented list storage functions
+ *
+ *  A segmented list lives in a directory next to the list file
+ *  ("name.segments") holding:
+ *
+ *  - The manifest: The list title line, followed by the number of each
+ *    segment file in list order (One per line)
+ *  - The segment files ("00000001.txt"): The entry lines of a run of
+ *    consecutive entries, in the list text format
+ *
+ *  A changed segment gets written into a new file, then the manifest gets
+ *  replaced to point to it. So a crash leaves either the old or the new
+ *  version of the list. The files left out of the manifest get removed
+ *  once it's written.
+ */
+
+#ifndef _SEGMENT_H_
+#define _SEGMENT_H_
+
+/* Using CType, Errors, Standard lib, Standard I/O, Strings & POSIX I/O */
+#include <ctype.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "lib.h"
+#include "stats.h"
+
+/**
+ *  \brief The segments directory extension (Replacing the ".txt" one)
+ */
+#define SEGMENTS_EXTENSION ".segments"
+
+/**
+ *  \brief The manifest filename (In the segments directory)
+ */
+#define SEGMENTS_MANIFEST "manifest"
+
+/**
+ *  \brief The number of entries the added entries get packed into segments by
+ */
+#define SEGMENT_MAX_ENTRIES 4096
+
+/**
+ *  \brief The segment struct
+ */
+struct Segment {
+	unsigned long firstId; /**< The id of its first entry (Or the one it had, as it's kept when it gets deleted) */
+	unsigned long count;   /**< The number of entries */
+	unsigned long file;    /**< The number of the file holding it (0 if it has none yet) */
+	char dirty;            /**< Whether it changed since its file got written */
+};
+
+/**
+ *  \brief The segments of a list struct
+ *
+ *  The entries ids increase along the list, so the segment holding an
+ *  entry is the last one starting at or before its id.
+ */
+struct Segments {
+	char *directory;        /**< The segments directory (NULL when closed) */
+	char *manifest;         /**< The manifest filename */
+	struct Segment *items;  /**< The segments, in list order */
+	unsigned long count;    /**< The number of segments */
+	unsigned long capacity; /**< The number of allocated segments */
+	unsigned long nextFile; /**< The number of the next segment file */
+	struct Buffer obsolete; /**< The numbers of the files to remove after the next manifest (unsigned long array) */
+};
+
+/**
+ *  \brief The segment file write struct
+ */
+struct SegmentFile {
+	unsigned long segment; /**< The index of the segment */
+	unsigned long file;    /**< The number of the file */
+	size_t offset;         /**< The file contents offset into the writer contents */
+	size_t length;         /**< The file contents length */
+};
+
+/**
+ *  \brief The segments writer struct
+ *
+ *  Holds the dirty segments & the manifest, taken along with the list
+ *  contents, so they can be written without holding the list.
+ *  A zeroed struct is a valid empty writer.
+ */
+struct SegmentsWriter {
+	struct Buffer files;    /**< The segment files (SegmentFile array) */
+	struct Buffer contents; /**< The segment files contents */
+	struct Buffer manifest; /**< The serialized manifest */
+	struct Buffer obsolete; /**< The numbers of the files the new manifest leaves out (unsigned long array) */
+};
+
+/**
+ *  \brief Opens the segments of a list file
+ *
+ *  Reads the manifest if there's one. Otherwise the segments start empty,
+ *  to be written on the first save.
+ *
+ *  \param segments The segments
+ *  \param listFilename The list filename
+ *  \param title Set to the newly allocated list title (If there's a manifest)
+ *
+ *  \return Whether the list got a manifest
+ */
+char segmentsOpen(struct Segments *segments, const char *listFilename, char **title);
+
+/**
+ *  \brief Reads the segment files one after the other into the heap
+ *
+ *  \param segments The segments
+ *  \param size Set to the data size
+ *  \param ends Set to the data offset each segment ends at
+ *
+ *  \return The data (Every segment ending with a newline)
+ */
+char *segmentsRead(const struct Segments *segments, size_t *size, size_t *ends);
+
+/**
+ *  \brief Adds an entry at the end of the segments
+ *         (Starting a new segment when the last one is full)
+ *
+ *  \param segments The segments
+ *  \param id The entry id
+ */
+void segmentsAppend(struct Segments *segments, unsigned long id);
+
+/**
+ *  \brief Marks the segment holding an entry as dirty
+ *
+ *  \param segments The segments
+ *  \param id The entry id
+ *  \param removed Whether the entry got removed from it
+ */
+void segmentsTouch(struct Segments *segments, unsigned long id, char removed);
+
+/**
+ *  \brief Starts taking the segments of a list for a write
+ *         (Dropping the empty ones)
+ *
+ *  \param segments The segments
+ *  \param writer The segments writer
+ */
+void segmentsTake(struct Segments *segments, struct SegmentsWriter *writer);
+
+/**
+ *  \brief Starts a new file for a dirty segment
+ *         (Its entry lines get serialized into the writer contents next)
+ *
+ *  \param segments The segments
+ *  \param writer The segments writer
+ *  \param segment The index of the segment
+ */
+void segmentsTakeFile(struct Segments *segments, struct SegmentsWriter *writer, unsigned long segment);
+
+/**
+ *  \brief Finishes taking the segments of a list, serializing the manifest
+ *
+ *  \param segments The segments
+ *  \param writer The segments writer
+ *  \param title The list title
+ */
+void segmentsTakeManifest(struct Segments *segments, struct SegmentsWriter *writer, const char *title);
+
+/**
+ *  \brief Writes the taken segment files & replaces the manifest
+ *
+ *  \param segments The segments (Only their filenames get read)
+ *  \param writer The segments writer
+ *  \param sync What to fsync (WRITE_SYNC_* constant, the data of the new files gets fsynced with any but WRITE_SYNC_NONE)
+ *
+ *  \return Whether they got written
+ */
+char segmentsWrite(const struct Segments *segments, struct SegmentsWriter *writer, int sync);
+
+/**
+ *  \brief Finishes a write & frees the writer
+ *
+ *  Removes the files left out of the new manifest. If the write failed,
+ *  the segments get dirty again & the files get removed after the next one.
+ *
+ *  \param segments The segments
+ *  \param writer The segments writer
+ *  \param written Whether the write succeeded
+ */
+void segmentsFinish(struct Segments *segments, struct SegmentsWriter *writer, char written);
+
+/**
+ *  \brief Frees the segments
+ *
+ *  \param segments The segments
+ */
+void segmentsClose(struct Segments *segments);
+
+#endif /* _SEGMENT_H_ */
@@ -0,0 +1,146 @@
+/*
+	C90 TODO List
+	Copyright (C) 2015 Daniel Esteban Nombela <dani@dabuten.co>
+
+	This software is provided 'as-is', without any express or implied
+	warranty. In no event will the author be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+/**
+ *  \file server.h
+ *
+ *  Header file for the daemon mode functions
+ *
+ *  The daemon keeps the lists loaded & serves them over a Unix socket.
+ *  The clients send one command per line, with the same grammar as the
+ *  batch mode (A title, D selection, selection, U) plus "O name" to pick the
+ *  list the next commands apply to. The names are plain list names ("name" or
+ *  "name.txt"), resolved against the directory being served: the one of the
+ *  list the daemon starts with (or the working directory). Each command gets a reply line:
+ *  "OK" when applied, "IGNORED" when not & "ERROR message" on errors.
+ *  A "Q" command closes the connection. The clients can pipeline the
+ *  commands, the replies come back in the same order.
+ */
+
+#ifndef _SERVER_H_
+#define _SERVER_H_
+
+/* Using CType, Errors, Signals, Standard lib, Standard I/O, Strings, POSIX, Epoll & Sockets */
+#include <ctype.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "data.h"
+#include "lib.h"
+#include "stats.h"
+
+/**
+ *  \brief The maximum number of events handled per event loop iteration
+ */
+#define SERVER_MAX_EVENTS 64
+
+/**
+ *  \brief The number of bytes read from a client at once
+ */
+#define SERVER_READ_SIZE 65536
+
+/**
+ *  \brief The maximum command line length
+ *         (Clients sending longer ones get disconnected)
+ */
+#define SERVER_MAX_LINE_SIZE 65536
+
+/**
+ *  \brief The reply bytes a client can have pending
+ *         (Its commands are held back until it reads them)
+ */
+#define SERVER_MAX_OUTPUT_SIZE 1048576
+
+/**
+ *  \brief The served list struct
+ */
+struct ServerList {
+	char *filename;          /**< The list filename (With the extension) */
+	struct TODOList *list;   /**< The list handle */
+	struct ServerList *next; /**< The next served list */
+};
+
+/**
+ *  \brief The server client struct
+ */
+struct ServerClient {
+	int fd;                        /**< The client socket */
+	struct Buffer input;           /**< The received bytes that aren't a full line yet */
+	struct Buffer output;          /**< The replies that couldn't be sent yet */
+	size_t outputOffset;           /**< The number of output bytes already sent */
+	struct TODOList *list;         /**< The list the commands apply to */
+	char closing;                  /**< Whether to close it once the replies are sent */
+	char held;                     /**< Whether its commands are held back until it reads the replies */
+	char ended;                    /**< Whether it's done sending */
+	unsigned int events;           /**< The events it's being polled for */
+	struct ServerClient *previous; /**< The previous connected client */
+	struct ServerClient *next;     /**< The next connected client */
+};
+
+/** The served lists **/
+static struct ServerList *serverLists;
+
+/** The directory the lists are served from (With the trailing '/', or empty) **/
+static char *serverDirectory;
+
+/** The connected clients **/
+static struct ServerClient *serverClients;
+
+/** The epoll instance **/
+static int serverEpoll;
+
+/** Whether a termination signal was received **/
+static volatile sig_atomic_t serverStopping;
+
+/**
+ *  \brief Serves the lists over a Unix socket until SIGINT or SIGTERM
+ *
+ *  All the lists are served from a single thread: a command applies
+ *  in memory & gets persisted by the list background writer (Or its
+ *  journal), so a burst of commands ends up in a single save.
+ *
+ *  \param socketPath The socket path
+ *  \param filename The list the clients start with (or NULL)
+ *  \param title The title of that list (or NULL)
+ *
+ *  \return The application exit status code
+ */
+int serverRun(const char *socketPath, const char *filename, const char *title);
+
+/**
+ *  \brief Connects to a server
+ *
+ *  \param socketPath The socket path
+ *
+ *  \return The connected socket (or -1 on error)
+ */
+int serverConnect(const char *socketPath);
+
+#endif /* _SERVER_H_ */
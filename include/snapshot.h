@@ -0,0 +1,151 @@
+/*
+	C90 TODO List
+	Copyright (C) 2015 Daniel Esteban Nombela <dani@dabuten.co>
+
+	This software is provided 'as-is', without any express or implied
+	warranty. In no event will the author be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+/**
+ *  \file snapshot.h
+ *
+ *  Header file for the binary snapshot functions
+ *
+ *  A snapshot is a binary copy of a list file that can be mapped and
+ *  used in place. It's laid out in 8 byte aligned sections:
+ *
+ *  - The header (struct SnapshotHeader)
+ *  - The null-terminated list title
+ *  - The entries title offsets into the title blob (count + 1)
+ *  - The entries done bitmap (One bit per entry)
+ *  - The title blob (The null-terminated entries titles)
+ */
+
+#ifndef _SNAPSHOT_H_
+#define _SNAPSHOT_H_
+
+/* Using Standard integers, Standard lib, Standard I/O & Strings */
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "lib.h"
+#include "stats.h"
+
+/**
+ *  \brief The snapshot filename extension
+ */
+#define SNAPSHOT_EXTENSION ".snap"
+
+/**
+ *  \brief The snapshot header magic
+ */
+#define SNAPSHOT_MAGIC "TODOSNP1"
+
+/**
+ *  \brief The snapshot header struct
+ */
+struct SnapshotHeader {
+	char magic[8];            /**< The snapshot magic */
+	uint64_t sourceSize;      /**< The source list file size */
+	uint64_t sourceInode;     /**< The source list file inode */
+	uint64_t sourceMtime;     /**< The source list file modification time (seconds) */
+	uint64_t sourceMtimeNsec; /**< The source list file modification time (nanoseconds) */
+	uint64_t count;           /**< The number of entries */
+	uint64_t titleLength;     /**< The list title length */
+	uint64_t blobSize;        /**< The title blob size */
+	uint64_t checksum;        /**< The checksum of everything after the header */
+};
+
+/**
+ *  \brief The mapped snapshot struct
+ */
+struct Snapshot {
+	char *data;               /**< The snapshot data (NULL when closed) */
+	size_t size;              /**< The snapshot size */
+	char mapped;              /**< Whether the data is mapped or allocated */
+	const char *title;        /**< The list title */
+	const uint64_t *offsets;  /**< The entries title offsets */
+	const uint64_t *done;     /**< The entries done bitmap */
+	const char *blob;         /**< The title blob */
+	unsigned long count;      /**< The number of entries */
+};
+
+/**
+ *  \brief The snapshot writer struct
+ *
+ *  A zeroed struct is a valid empty writer.
+ */
+struct SnapshotWriter {
+	struct Buffer offsets; /**< The entries title offsets */
+	struct Buffer done;    /**< The entries done bitmap */
+	struct Buffer blob;    /**< The title blob */
+	unsigned long count;   /**< The number of entries */
+};
+
+/**
+ *  \brief Returns the snapshot filename for a list file
+ *
+ *  \param listFilename The list filename
+ *
+ *  \return A newly allocated snapshot filename
+ */
+char *snapshotFilename(const char *listFilename);
+
+/**
+ *  \brief Maps a snapshot if it's valid & fresh
+ *
+ *  \param snapshot The snapshot
+ *  \param filename The snapshot filename
+ *  \param source The identity of the list file it should've been taken from
+ *
+ *  \return Whether the snapshot was mapped
+ */
+char snapshotOpen(struct Snapshot *snapshot, const char *filename, const struct FileIdentity *source);
+
+/**
+ *  \brief Unmaps a snapshot
+ *
+ *  \param snapshot The snapshot
+ */
+void snapshotClose(struct Snapshot *snapshot);
+
+/**
+ *  \brief Adds an entry to a snapshot writer
+ *
+ *  \param writer The snapshot writer
+ *  \param title The entry title
+ *  \param length The entry title length
+ *  \param done Whether the entry is done or not
+ */
+void snapshotAdd(struct SnapshotWriter *writer, const char *title, size_t length, char done);
+
+/**
+ *  \brief Writes a snapshot & frees the writer
+ *
+ *  \param writer The snapshot writer
+ *  \param filename The snapshot filename
+ *  \param source The identity of the list file it was taken from
+ *  \param title The list title
+ *
+ *  \return Whether the snapshot was written
+ */
+char snapshotWrite(struct SnapshotWriter *writer, const char *filename, const struct FileIdentity *source, const char *title);
+
+#endif /* _SNAPSHOT_H_ */
@@ -0,0 +1,132 @@
+/*
+	C90 TODO List
+	Copyright (C) 2015 Daniel Esteban Nombela <dani@dabuten.co>
+
+	This software is provided 'as-is', without any express or implied
+	warranty. In no event will the author be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+/**
+ *  \file stats.h
+ *
+ *  Header file for the hot path instrumentation functions & macros
+ */
+
+#ifndef _STATS_H_
+#define _STATS_H_
+
+/* Using Standard lib, Standard I/O, Strings & POSIX threads */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "lib.h"
+
+/**
+ *  \brief The number of latency histogram buckets
+ *         (Powers of two, in nanoseconds)
+ */
+#define STATS_BUCKETS 40
+
+/**
+ *  \brief The maximum number of trace events kept
+ */
+#define STATS_MAX_TRACE_EVENTS 1048576
+
+/**
+ *  \brief Adds a value to a counter
+ *         (Always on, it's just an increment)
+ */
+#define STATS_COUNT(counter, value) (statsCounters[counter] += (value))
+
+/**
+ *  \brief Timer constants
+ */
+enum STATS_TIMERS {
+	STATS_LOAD,
+	STATS_SAVE,
+	STATS_COMMAND,
+	STATS_RENDER,
+	STATS_TIMERS_COUNT
+};
+
+/**
+ *  \brief Counter constants
+ */
+enum STATS_COUNTERS {
+	STATS_BYTES_READ,
+	STATS_BYTES_WRITTEN,
+	STATS_ALLOCATIONS,
+	STATS_ARENA_CHUNKS,
+	STATS_FRAME_BYTES,
+	STATS_INTERNED_BYTES,
+	STATS_DEDUPED_BYTES,
+	STATS_COUNTERS_COUNT
+};
+
+/**
+ *  \brief The timer struct
+ */
+struct StatsTimer {
+	unsigned long count;                   /**< The number of timed calls */
+	double total;                          /**< The total time (seconds) */
+	double min;                            /**< The fastest call (seconds) */
+	double max;                            /**< The slowest call (seconds) */
+	unsigned long buckets[STATS_BUCKETS];  /**< The latency histogram */
+};
+
+/** The counters (Per thread, the workers add theirs with statsAddCounters) **/
+extern __thread unsigned long statsCounters[STATS_COUNTERS_COUNT];
+
+/**
+ *  \brief Enables the instrumentation
+ *
+ *  \param reportFilename Where to write the JSON report (NULL for stderr)
+ *  \param traceFilename Where to write the Chrome trace events (NULL for none)
+ */
+void statsEnable(const char *reportFilename, const char *traceFilename);
+
+/**
+ *  \brief Starts timing a call
+ *
+ *  \return The start time (0 when the instrumentation is disabled)
+ */
+double statsBegin();
+
+/**
+ *  \brief Finishes timing a call
+ *
+ *  \param timer The timer
+ *  \param start The start time returned by statsBegin
+ */
+void statsEnd(const int timer, const double start);
+
+/**
+ *  \brief Adds the counters of a finished worker thread to the current thread ones
+ *
+ *  \param counters The worker counters
+ */
+void statsAddCounters(const unsigned long *counters);
+
+/**
+ *  \brief Writes the report (and trace) if the instrumentation is enabled
+ */
+void statsReport();
+
+#endif /* _STATS_H_ */
@@ -0,0 +1,89 @@
+/*
+	C90 TODO List
+	Copyright (C) 2015 Daniel Esteban Nombela <dani@dabuten.co>
+
+	This software is provided 'as-is', without any express or implied
+	warranty. In no event will the author be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+/**
+ *  \file watch.h
+ *
+ *  Header file for the file watch functions
+ *
+ *  A watch tells when a file gets changed by other processes. It
+ *  watches the directory holding the file with inotify, so it keeps
+ *  working after the file gets replaced through a rename.
+ */
+
+#ifndef _WATCH_H_
+#define _WATCH_H_
+
+/* Using Standard lib, Standard I/O, Strings, inotify & POSIX */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+/**
+ *  \brief The events watched on the directory of the file
+ */
+#define WATCH_EVENTS (IN_MODIFY | IN_CLOSE_WRITE | IN_CREATE | IN_MOVED_TO)
+
+/**
+ *  \brief The events telling the file got written as a whole
+ *         (Instead of being in the middle of a write)
+ */
+#define WATCH_SETTLED_EVENTS (IN_CLOSE_WRITE | IN_MOVED_TO)
+
+/**
+ *  \brief The file watch struct
+ */
+struct Watch {
+	int fd;     /**< The inotify descriptor (-1 when closed) */
+	char *name; /**< The watched file name (Within its directory) */
+};
+
+/**
+ *  \brief Starts watching a file
+ *
+ *  \param watch The watch
+ *  \param filename The filename
+ *
+ *  \return Whether the file is being watched
+ */
+char watchOpen(struct Watch *watch, const char *filename);
+
+/**
+ *  \brief Reads the pending events of a watch (Without blocking)
+ *
+ *  \param watch The watch
+ *
+ *  \return The events that concerned the file (0 if none)
+ */
+unsigned int watchRead(struct Watch *watch);
+
+/**
+ *  \brief Stops watching a file
+ *
+ *  \param watch The watch
+ */
+void watchClose(struct Watch *watch);
+
+#endif /* _WATCH_H_ */
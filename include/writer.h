@@ -0,0 +1,174 @@
+/*
+	C90 TODO List
+	Copyright (C) 2015 Daniel Esteban Nombela <dani@dabuten.co>
+
+	This software is provided 'as-is', without any express or implied
+	warranty. In no event will the author be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+/**
+ *  \file writer.h
+ *
+ *  Header file for the background writer functions
+ */
+
+#ifndef _WRITER_H_
+#define _WRITER_H_
+
+/* Using Errors, Standard lib, Standard I/O, Strings, Time, POSIX threads & POSIX */
+#include <errno.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "lib.h"
+#include "stats.h"
+
+/**
+ *  \brief How long a save request waits for more changes to coalesce with (seconds)
+ */
+#define WRITER_COALESCE_DELAY 0.05
+
+/**
+ *  \brief How often the saves get synced with the interval policy (seconds)
+ */
+#define WRITER_SYNC_INTERVAL 1.0
+
+/**
+ *  \brief Fsync policy constants
+ */
+enum WRITER_FSYNC_POLICIES {
+	WRITER_FSYNC_ALWAYS,   /**< Fsync every save */
+	WRITER_FSYNC_INTERVAL, /**< Fsync the saved data before it gets renamed & its directory once per interval */
+	WRITER_FSYNC_NEVER     /**< Leave it to the OS */
+};
+
+/**
+ *  \brief The background writer struct
+ *
+ *  A thread that runs the save callback when requested, coalescing
+ *  the requests made while a save is pending into a single save.
+ *  The writer mutex must be held while changing the data it saves.
+ */
+struct Writer {
+	pthread_mutex_t mutex;                        /**< Guards the writer state & the data it saves */
+	pthread_cond_t changed;                       /**< Signaled when a save gets requested or finished */
+	pthread_t thread;                             /**< The writer thread */
+	void (*save)(void *data, int sync);           /**< The save callback (Called with the mutex held, it must release it around the disk I/O) */
+	void *data;                                   /**< The data passed to the save callback */
+	int fsyncPolicy;                              /**< The fsync policy */
+	char *syncFilename;                           /**< The file last saved (Synced with its directory once per interval) */
+	char *appendFilename;                         /**< The file appended to since the last sync (Synced along with the saves) */
+	double lastSync;                              /**< When the saves were last synced (monotonic seconds) */
+	unsigned long counters[STATS_COUNTERS_COUNT]; /**< The counters of the finished thread */
+	char started;                                 /**< Whether the thread is running */
+	char stopping;                                /**< Whether the thread has to finish */
+	char pending;                                 /**< Whether a save got requested */
+	char saving;                                  /**< Whether a save is running */
+	char flushing;                                /**< Whether someone waits for the pending save */
+	char unsynced;                                /**< Whether there are saves to be synced */
+	char syncing;                                 /**< Whether the saves are being synced (Without the mutex) */
+};
+
+/**
+ *  \brief Initializes a writer (Its thread starts on the first request)
+ *
+ *  \param writer The writer
+ *  \param save The save callback (Getting the WRITE_SYNC_* level of the policy)
+ *  \param data The data passed to the save callback
+ *  \param fsyncPolicy The fsync policy
+ */
+void writerInit(struct Writer *writer, void (*save)(void *data, int sync), void *data, int fsyncPolicy);
+
+/**
+ *  \brief Sets the file a save wrote (With the mutex held)
+ *
+ *  The interval policy syncs it along with its directory.
+ *
+ *  \param writer The writer
+ *  \param filename The filename
+ */
+void writerSaved(struct Writer *writer, const char *filename);
+
+/**
+ *  \brief Sets a file that got appended to in place (With the mutex held)
+ *
+ *  The interval policy syncs it once per interval, like the saves.
+ *
+ *  \param writer The writer
+ *  \param filename The filename
+ */
+void writerAppended(struct Writer *writer, const char *filename);
+
+/**
+ *  \brief Locks the writer mutex (Before changing the data it saves)
+ *
+ *  \param writer The writer
+ */
+void writerLock(struct Writer *writer);
+
+/**
+ *  \brief Unlocks the writer mutex
+ *
+ *  \param writer The writer
+ */
+void writerUnlock(struct Writer *writer);
+
+/**
+ *  \brief Requests a save (With the mutex held)
+ *
+ *  Starts the writer thread on the first request.
+ *
+ *  \param writer The writer
+ */
+void writerRequest(struct Writer *writer);
+
+/**
+ *  \brief Waits for the pending save & syncs the unsynced ones
+ *
+ *  \param writer The writer
+ */
+void writerFlush(struct Writer *writer);
+
+/**
+ *  \brief Waits for the running save to finish (With the mutex held)
+ *
+ *  Unlike writerFlush, it neither waits for the pending save nor syncs.
+ *
+ *  \param writer The writer
+ */
+void writerWait(struct Writer *writer);
+
+/**
+ *  \brief Flushes the writer & stops its thread
+ *
+ *  \param writer The writer
+ */
+void writerStop(struct Writer *writer);
+
+/**
+ *  \brief Stops a writer & releases its mutex & condition
+ *
+ *  \param writer The writer
+ */
+void writerDestroy(struct Writer *writer);
+
+#endif /* _WRITER_H_ */
@@ -0,0 +1,138 @@
+/*
+	C90 TODO List
+	Copyright (C) 2015 Daniel Esteban Nombela <dani@dabuten.co>
+
+	This software is provided 'as-is', without any express or implied
+	warranty. In no event will the author be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "arena.h"
+
+/**
+ *  \brief Maps a new chunk into the arena
+ *
+ *  \param arena The arena
+ *  \param size The minimum usable size
+ */
+static void arenaGrow(struct Arena *arena, size_t size) {
+	struct ArenaChunk *chunk;
+
+	/* Round the chunk up to the default size */
+	size += sizeof(struct ArenaChunk);
+	if(size < ARENA_CHUNK_SIZE) size = ARENA_CHUNK_SIZE;
+
+	/* Map the chunk */
+	chunk = (struct ArenaChunk *) mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(chunk == MAP_FAILED) {
+		printf("ERROR allocating arena chunk");
+		exit(1);
+	}
+	chunk->size = size;
+	chunk->used = sizeof(struct ArenaChunk);
+	STATS_COUNT(STATS_ARENA_CHUNKS, 1);
+
+	/* Push it to the arena */
+	chunk->next = arena->chunks;
+	arena->chunks = chunk;
+}
+
+void *arenaAlloc(struct Arena *arena, size_t size, size_t align) {
+	struct ArenaChunk *chunk = arena->chunks;
+	size_t offset;
+
+	STATS_COUNT(STATS_ALLOCATIONS, 1);
+	if(chunk != NULL) {
+		offset = (chunk->used + align - 1) & ~(align - 1);
+		if(offset + size <= chunk->size) {
+			chunk->used = offset + size;
+			return (char *) chunk + offset;
+		}
+	}
+
+	/* Out of space, map a new chunk */
+	arenaGrow(arena, size + align);
+	chunk = arena->chunks;
+	offset = (chunk->used + align - 1) & ~(align - 1);
+	chunk->used = offset + size;
+	return (char *) chunk + offset;
+}
+
+void *arenaAllocObject(struct Arena *arena, size_t size) {
+	void *object = arena->freeList;
+
+	/* Reuse a recycled object if we've got any */
+	if(object != NULL) {
+		arena->freeList = *((void **) object);
+		return object;
+	}
+
+	return arenaAlloc(arena, size < sizeof(void *) ? sizeof(void *) : size, sizeof(void *));
+}
+
+void arenaRecycleObject(struct Arena *arena, void *object) {
+	*((void **) object) = arena->freeList;
+	arena->freeList = object;
+}
+
+char *arenaStrndup(struct Arena *arena, const char *str, size_t length) {
+	char *copy = (char *) arenaAlloc(arena, length + 1, 1);
+	memcpy(copy, str, length);
+	copy[length] = '\0';
+	return copy;
+}
+
+void arenaMerge(struct Arena *arena, struct Arena *other) {
+	struct ArenaChunk *last;
+	void **object;
+
+	if(other->chunks != NULL) {
+		if(arena->chunks == NULL) {
+			arena->chunks = other->chunks;
+		} else {
+			/* Link the chunks behind the current one, so it keeps being bumped */
+			for(last = other->chunks; last->next != NULL; last = last->next);
+			last->next = arena->chunks->next;
+			arena->chunks->next = other->chunks;
+		}
+	}
+
+	/* Join the recycled objects lists */
+	if(other->freeList != NULL) {
+		for(object = (void **) other->freeList; *object != NULL; object = (void **) *object);
+		*object = arena->freeList;
+		arena->freeList = other->freeList;
+	}
+
+	other->chunks = NULL;
+	other->freeList = NULL;
+}
+
+void arenaFree(struct Arena *arena) {
+	struct ArenaChunk *chunk = arena->chunks;
+	struct ArenaChunk *next;
+
+	/* Unmap all the chunks */
+	while(chunk != NULL) {
+		next = chunk->next;
+		munmap(chunk, chunk->size);
+		chunk = next;
+	}
+
+	arena->chunks = NULL;
+	arena->freeList = NULL;
+}
@@ -23,275 +23,2591 @@
 
 #include "data.h"
 
+/**
+ *  \brief The TODO list struct
+ *
+ *  Everything about a list, so a process can hold many of them. The
+ *  loaded state (From title to matches) gets released when the list is
+ *  evicted, and loaded again on its next use.
+ */
+struct TODOList {
+	char *filename;                 /**< The list filename (NULL if it isn't open) */
+	char *defaultTitle;             /**< The title to use if the file has none (or NULL) */
+	char *title;                    /**< The list title */
+	char *data;                     /**< The mapped list file the loaded entries titles point into */
+	size_t dataSize;                /**< The size of the mapped list file */
+	char dataMapped;                /**< Whether the list file got mapped (or read into the heap) */
+	struct TODOEntry *first;        /**< The first entry */
+	struct TODOEntry *last;         /**< The last entry */
+	unsigned long doneCount;        /**< The number of done entries */
+	unsigned long nextId;           /**< The id of the next entry to be added */
+	struct Arena arena;             /**< The arena holding the entries */
+	struct InternTable titles;      /**< The titles of the added entries */
+	struct PositionIndex index;     /**< The positional index of the entries */
+	struct Journal journal;         /**< The operation journal */
+	struct Snapshot snapshot;       /**< The snapshot the list was loaded from */
+	struct SearchIndex search;      /**< The search index of the entries (Built on the first search) */
+	struct SearchResults matches;   /**< The entries matching the search query */
+	char searchBuilt;               /**< Whether the search index got built */
+	char matchesStale;              /**< Whether the matches are outdated by a change in the list */
+	char *filter;                   /**< The search query (NULL if the list isn't filtered) */
+	struct Writer writer;           /**< The background writer of the list file */
+	char compacting;                /**< Whether the background writer got asked to compact the journal */
+	char dirty;                     /**< Whether the list has changes that weren't saved */
+	char loaded;                    /**< Whether the entries are loaded */
+	char loading;                   /**< Whether the entries are being loaded or freed (Outside the lists mutex) */
+	unsigned int users;             /**< The number of calls using the list (It isn't evicted meanwhile) */
+	struct TODOList *newer;         /**< The next more recently used loaded list */
+	struct TODOList *older;         /**< The next less recently used loaded list */
+	struct TODOList *archive;       /**< The archive of the list (Opened on its first view) */
+	struct Watch watch;             /**< The watch of the list file (In watch mode) */
+	struct FileIdentity synced;     /**< The list file as it was last read or written (Its size up to the last parsed line) */
+	struct Buffer syncedEntries;    /**< The entries it held back then (TODOSyncedEntry array, in watch mode) */
+	unsigned long syncedHash;       /**< The hash of the bytes it held back then */
+	struct Segments segments;       /**< The segments of the list (If it's segmented) */
+	char segmented;                 /**< Whether the list is stored in segments */
+	char classic;                   /**< Whether the list keeps the single file layout (The archives, appended to in place) */
+	struct TODOLoadStats loadStats; /**< The stats of the last load */
+};
+
 /* Initialize the variables */
-static char *TODOListFilename = NULL;
-static char *TODOListTitle = NULL;
-static struct TODOEntry *TODOListFirst = NULL;
-static struct TODOEntry *TODOListLast = NULL;
+static char TODOListJournalMode = 0;
+static char TODOListAutoSave = 1;
+static char TODOListSnapshotMode = 0;
+static unsigned int TODOListLoadThreads = 0;
+static int TODOListFsyncPolicy = WRITER_FSYNC_INTERVAL;
+static unsigned long TODOListMaxLoaded = 0;
+static unsigned long TODOListArchiveKeep = 0;
+static char TODOListWatchMode = 0;
+static char TODOListSegmentMode = 0;
+static unsigned long TODOListLoadedCount = 0;
+static struct TODOList *TODOListNewest = NULL, *TODOListOldest = NULL;
+static pthread_mutex_t TODOListsMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t TODOListsLoaded = PTHREAD_COND_INITIALIZER;
 
-void loadTODOList(const char *filename, const char *title) {
-	/* The reading buffers */
-	char readChar;
-	char readBuf[MAX_BUFFER_SIZE];
-	unsigned short int readIndex = 0;
-	char *trimmedBuf;
-	char entryDone = -1;
-	char *entryTitle;
+/** The default TODO list (The one the functions without a handle work on) **/
+static struct TODOList TODOListDefault;
 
-	/* The file pointer */
-	FILE *file;
+/**
+ *  \brief Returns the key of an entry in the search index
+ *
+ *  \param entry The entry
+ *
+ *  \return The entry id
+ */
+static unsigned long getEntryId(const void *entry) {
+	return ((const struct TODOEntry *) entry)->id;
+}
 
-	/* The lines counter */
-	unsigned short int line = 0;
+/**
+ *  \brief Compares two entries by their position in the list
+ *
+ *  \param a The first entry
+ *  \param b The second entry
+ *
+ *  \return A negative, zero or positive value if a is before, at or after b
+ */
+static int compareEntries(const void *a, const void *b) {
+	const unsigned long idA = getEntryId(a);
+	const unsigned long idB = getEntryId(b);
 
-	/* Add extension to file name (if missing) */
-	char *extension = strchr(filename, '.');
-	TODOListFilename = (char *) malloc((sizeof(char) * strlen(filename)) + (extension == NULL ? 4 : 0) + 1);
-	if(TODOListFilename == NULL) {
-		printf("ERROR allocating TODOListFilename");
-		exit(1);
+	return idA < idB ? -1 : (idA > idB ? 1 : 0);
+}
+
+/**
+ *  \brief Hashes a range of bytes (FNV-1a)
+ *
+ *  \param hash The hash of the bytes before them (2166136261 to start one)
+ *  \param data The range start
+ *  \param length The range length
+ *
+ *  \return The hash
+ */
+static unsigned long hashBytes(unsigned long hash, const char *data, size_t length) {
+	while(length-- > 0) hash = (hash ^ (unsigned char) *data++) * 16777619UL;
+	return hash;
+}
+
+/**
+ *  \brief Allocates an entry
+ *
+ *  \param arena The arena to allocate it from
+ *  \param title The entry title (Owned by the list arena, file or snapshot)
+ *  \param length The entry title length
+ *  \param done Whether the entry is done or not
+ *
+ *  \return The unlinked entry
+ */
+static struct TODOEntry *newEntry(struct Arena *arena, const char *title, size_t length, char done) {
+	/* Allocate the entry from the arena */
+	struct TODOEntry *entry = (struct TODOEntry *) arenaAllocObject(arena, sizeof(struct TODOEntry));
+
+	/* Assign the entry data */
+	entry->title = title;
+	entry->titleLength = length;
+	entry->done = done;
+	entry->next = NULL;
+	return entry;
+}
+
+/**
+ *  \brief Links an entry at the end of a list
+ *
+ *  \param list The TODO list
+ *  \param entry The entry (Allocated from the list arena)
+ */
+static void linkEntry(struct TODOList *list, struct TODOEntry *entry) {
+	entry->id = list->nextId++;
+	entry->next = NULL;
+
+	/* Push it to the list */
+	list->doneCount += entry->done;
+	if(list->first == NULL) list->first = entry;
+	else list->last->next = entry;
+	list->last = entry;
+
+	/* Index it */
+	indexAppend(&list->index, entry);
+	if(list->searchBuilt) searchIndexAdd(&list->search, entry->title, entry->titleLength, entry);
+	list->matchesStale = 1;
+}
+
+/**
+ *  \brief Appends a copy of an entry to a list
+ *
+ *  \param list The TODO list
+ *  \param title The entry title range start
+ *  \param length The entry title range length
+ *  \param done Whether the entry is done or not
+ */
+static void appendEntry(struct TODOList *list, const char *title, size_t length, char done) {
+	/* Share the copy of the title with the entries holding the same one */
+	struct TODOEntry *entry = newEntry(&list->arena, internTitle(&list->titles, title, length), length, done);
+
+	linkEntry(list, entry);
+	if(list->segmented) segmentsAppend(&list->segments, entry->id);
+}
+
+/**
+ *  \brief Removes an entry from a list
+ *
+ *  \param list The TODO list
+ *  \param entryIndex The 1-based index of the entry to be removed
+ *
+ *  \return Whether the entry existed
+ */
+static char removeEntry(struct TODOList *list, const unsigned long entryIndex) {
+	/* Find the entry & the previous one */
+	struct TODOEntry *entry = (struct TODOEntry *) indexGet(&list->index, entryIndex);
+	struct TODOEntry *prev = entryIndex > 1 ? (struct TODOEntry *) indexGet(&list->index, entryIndex - 1) : NULL;
+
+	if(entry == NULL) return 0;
+
+	/* Unlink the entry */
+	if(prev == NULL) {
+		if((list->first = entry->next) == NULL) list->last = NULL;
+	} else {
+		if((prev->next = entry->next) == NULL) list->last = prev;
 	}
-	strcpy(TODOListFilename, filename);
-	if(extension == NULL) strcpy(TODOListFilename + strlen(TODOListFilename), ".txt\0");
-
-	/* Open the file */
-	if((file = fopen(TODOListFilename, "r")) == NULL) {
-		/* If we got no title, set it to the filename */
-		if(title == NULL) {
-			extension = strchr(TODOListFilename, '.');
-			TODOListTitle = (char *) malloc((sizeof(char) * (extension - TODOListFilename)) + 1);
-			if(TODOListTitle == NULL) {
-				printf("ERROR allocating TODOListTitle");
-				exit(1);
-			}
-			strncpy(TODOListTitle, TODOListFilename, extension - TODOListFilename);
-			TODOListTitle[0] = toupper(TODOListTitle[0]);
-			TODOListTitle[extension - TODOListFilename] = '\0';
-		} else {
-			TODOListTitle = (char *) malloc((sizeof(char) * strlen(title)) + 1);
-			if(TODOListTitle == NULL) {
-				printf("ERROR allocating TODOListTitle");
+	indexRemove(&list->index, entryIndex);
+	list->doneCount -= entry->done;
+	if(list->searchBuilt) searchIndexRemove(&list->search, entry->title, entry->titleLength, entry);
+	if(list->segmented) segmentsTouch(&list->segments, entry->id, 1);
+	list->matchesStale = 1;
+
+	/* Recycle the entry & its title unless it's shared (The file titles stay mapped until the list is freed) */
+	internRelease(&list->titles, entry->title, entry->titleLength);
+	arenaRecycleObject(&list->arena, entry);
+	return 1;
+}
+
+/**
+ *  \brief Flips the status of an entry
+ *
+ *  \param list The TODO list
+ *  \param entryIndex The 1-based index of the entry to be toggled
+ *
+ *  \return Whether the entry existed
+ */
+static char flipEntry(struct TODOList *list, const unsigned long entryIndex) {
+	/* Find the entry */
+	struct TODOEntry *entry = (struct TODOEntry *) indexGet(&list->index, entryIndex);
+
+	if(entry == NULL) return 0;
+
+	/* Toggle the entry status */
+	entry->done = !entry->done;
+	if(entry->done) list->doneCount++;
+	else list->doneCount--;
+	if(list->segmented) segmentsTouch(&list->segments, entry->id, 0);
+	return 1;
+}
+
+/**
+ *  \brief Compares two selection ranges by their first index
+ *
+ *  \param a The first range
+ *  \param b The second range
+ *
+ *  \return The qsort comparison result
+ */
+static int compareRanges(const void *a, const void *b) {
+	const struct TODORange *rangeA = (const struct TODORange *) a;
+	const struct TODORange *rangeB = (const struct TODORange *) b;
+
+	return rangeA->first < rangeB->first ? -1 : rangeA->first > rangeB->first;
+}
+
+/**
+ *  \brief Parses a selection of entries
+ *
+ *  \param selection The selection (Its ranges get allocated when it's valid)
+ *  \param spec The selection spec range start
+ *  \param length The selection spec range length
+ *
+ *  \return Whether the spec is valid
+ */
+static char parseSelection(struct TODOSelection *selection, const char *spec, size_t length) {
+	const char *end = spec + length;
+	const char *item;
+	const char *itemEnd;
+	char *numberEnd;
+	size_t itemLength;
+	struct TODORange range;
+	unsigned long i;
+	unsigned long merged;
+
+	memset(selection, 0, sizeof(struct TODOSelection));
+	for(item = spec; item <= end; item = itemEnd + 1) {
+		itemEnd = findByte(item, end, ',');
+		itemLength = itemEnd - item;
+		item = trimRange(item, &itemLength);
+
+		if(itemLength == 4 && strncasecmp(item, "done", 4) == 0) {
+			selection->done = 1;
+			continue;
+		}
+		if(itemLength == 7 && strncasecmp(item, "pending", 7) == 0) {
+			selection->pending = 1;
+			continue;
+		}
+
+		/* Parse the index or the range */
+		if(itemLength == 0 || !isdigit((unsigned char) *item)) {
+			free(selection->ranges);
+			return 0;
+		}
+		range.first = range.last = strtoul(item, &numberEnd, 10);
+		if(numberEnd < item + itemLength && *numberEnd == '-' && isdigit((unsigned char) numberEnd[1])) range.last = strtoul(numberEnd + 1, &numberEnd, 10);
+		if(numberEnd != item + itemLength) {
+			free(selection->ranges);
+			return 0;
+		}
+		if(range.first > range.last) {
+			range.first = range.last;
+			range.last = strtoul(item, NULL, 10);
+		}
+		if(range.last == 0) continue;
+		if(range.first == 0) range.first = 1;
+
+		/* Add it */
+		if(selection->count == selection->capacity) {
+			selection->capacity = selection->capacity == 0 ? 4 : selection->capacity * 2;
+			if((selection->ranges = (struct TODORange *) realloc(selection->ranges, sizeof(struct TODORange) * selection->capacity)) == NULL) {
+				printf("ERROR allocating the selection ranges");
 				exit(1);
 			}
-			strcpy(TODOListTitle, title);
 		}
-	} else {
-		/* Read the file */
-		readChar = fgetc(file);
-		while(readChar != EOF) {
-			if(line == 1) {
-				/* Parse & trim the title line */
-				if(readIndex < MAX_BUFFER_SIZE && readChar != '\n') readBuf[readIndex++] = readChar;
-				else {
-					readBuf[readIndex] = '\0';
-					trimmedBuf = trim(readBuf);
-					TODOListTitle = (char *) malloc(sizeof(char) * (strlen(trimmedBuf) + 1));
-					if(TODOListTitle == NULL) {
-						printf("ERROR allocating TODOListTitle");
-						exit(1);
-					}
-					strcpy(TODOListTitle, trimmedBuf);
-					readIndex = 0;
-					line++;
-				}
-			} else if(line < 3) {
-				/* Skip the title decoration lines */
-				if(readChar == '\n') line++;
-			} else if(entryDone == -1) {
-				/* Parse the entry done flag */
-				if(readIndex < MAX_BUFFER_SIZE && readChar != ' ') readBuf[readIndex++] = readChar;
-				else {
-					readBuf[readIndex] = '\0';
-					entryDone = strcmp("✔", readBuf) == 0;
-					readIndex = 0;
-				}
-			} else {
-				/* Parse the entry title */
-				if(readIndex < MAX_BUFFER_SIZE && readChar != '\n') readBuf[readIndex++] = readChar;
-				else {
-					readBuf[readIndex] = '\0';
-					trimmedBuf = trim(readBuf);
-					entryTitle = (char *) malloc(sizeof(char) * (strlen(trimmedBuf) + 1));
-					if(TODOListTitle == NULL) {
-						printf("ERROR allocating entry title");
-						exit(1);
-					}
-					strcpy(entryTitle, trimmedBuf);
-					addEntry(entryTitle, entryDone);
-					readIndex = 0;
-					entryDone = -1;
-				}
-			}
-			readChar = fgetc(file);
+		selection->ranges[selection->count++] = range;
+	}
+
+	if(selection->count == 0) return selection->done || selection->pending;
+
+	/* Sort & merge the overlapping or adjacent ranges */
+	qsort(selection->ranges, selection->count, sizeof(struct TODORange), compareRanges);
+	for(i = 1, merged = 0; i < selection->count; i++) {
+		if(selection->ranges[i].first <= selection->ranges[merged].last + 1) {
+			if(selection->ranges[i].last > selection->ranges[merged].last) selection->ranges[merged].last = selection->ranges[i].last;
+		} else {
+			selection->ranges[++merged] = selection->ranges[i];
 		}
+	}
+	selection->count = merged + 1;
+	return 1;
+}
+
+/**
+ *  \brief Returns the span of a list a selection covers
+ *
+ *  \param list The TODO list
+ *  \param selection The selection
+ *  \param first The first 1-based entry index of the span
+ *  \param last The last 1-based entry index of the span
+ *
+ *  \return The number of entries the selection can hold
+ */
+static unsigned long getSelectionSpan(const struct TODOList *list, const struct TODOSelection *selection, unsigned long *first, unsigned long *last) {
+	unsigned long count = 0;
+	unsigned long i;
 
-		/* Close the file */
-		fclose(file);
+	*first = 1;
+	*last = list->index.count;
+	if((selection->done || selection->pending) && !selection->intersect) return *last;
+
+	/* Just the ranges */
+	*first = selection->ranges[0].first;
+	if(selection->ranges[selection->count - 1].last < *last) *last = selection->ranges[selection->count - 1].last;
+	for(i = 0; i < selection->count && selection->ranges[i].first <= *last; i++) {
+		count += (selection->ranges[i].last < *last ? selection->ranges[i].last : *last) - selection->ranges[i].first + 1;
 	}
+	return count;
 }
 
-void saveTodoList() {
-	/* The file pointer */
-	FILE *file;
-	
-	/* The entry pointer */
-	struct TODOEntry *entry = TODOListFirst;
+/**
+ *  \brief Checks whether the entry a sweep is at is selected
+ *
+ *  \param selection The selection
+ *  \param range The range the sweep is at (Advanced along with it)
+ *  \param entryIndex The 1-based index of the entry
+ *  \param entry The entry
+ *
+ *  \return Whether the entry is selected
+ */
+static char isSelected(const struct TODOSelection *selection, unsigned long *range, const unsigned long entryIndex, const struct TODOEntry *entry) {
+	char inRange;
 
-	/* Title decorations length */
-	const unsigned short int decorationsLength = 40;
+	/* Skip the ranges the sweep left behind */
+	while(*range < selection->count && selection->ranges[*range].last < entryIndex) (*range)++;
 
-	/* The title length */
-	const unsigned short int titleLength = strlen(TODOListTitle);
+	inRange = *range < selection->count && selection->ranges[*range].first <= entryIndex;
+	if(selection->intersect) return inRange && (entry->done ? selection->done : selection->pending);
+	return inRange || (entry->done ? selection->done : selection->pending);
+}
 
-	/* Iteration counter for the list title decorations */
-	unsigned short int i;
+/**
+ *  \brief Removes a selection of entries from a list in a single sweep
+ *
+ *  The indices are counted along the sweep, so they refer to the list
+ *  before the removal. The position index gets the entries removed one
+ *  by one, or gets rebuilt once when the selection covers a big share
+ *  of the list.
+ *
+ *  \param list The TODO list
+ *  \param selection The selection
+ *
+ *  \return The number of removed entries
+ */
+static unsigned long removeEntries(struct TODOList *list, const struct TODOSelection *selection) {
+	struct TODOEntry *prev;
+	struct TODOEntry *entry;
+	struct TODOEntry *next;
+	unsigned long entryIndex;
+	unsigned long last;
+	unsigned long range = 0;
+	unsigned long removed = 0;
+	const char rebuild = getSelectionSpan(list, selection, &entryIndex, &last) > list->index.count / SELECTION_REBUILD_RATIO;
 
-	if(entry == NULL) return;
+	if(entryIndex > last) return 0;
 
-	/* Open the file */
-	if((file = fopen(TODOListFilename, "w")) == NULL) {
-		printf("ERROR writing to file: %s\n", TODOListFilename);
-	} else {
-		/* Print the title */
-		for(i = 0; i<decorationsLength; i++) fputs("=", file);
-		fprintf(file, "\n%*s\n", (decorationsLength / 2) + titleLength / 2, TODOListTitle);
-		for(i = 0; i<decorationsLength; i++) fputs("=", file);
-		fputs("\n", file);
-
-		/* Iterate through the TODO list */
-		while(entry != NULL) {
-			fprintf(file, "%s %s\n", entry->done ? "✔" : "✘", entry->title);
-			entry = entry->next;
+	/* Sweep the span */
+	prev = entryIndex > 1 ? (struct TODOEntry *) indexGet(&list->index, entryIndex - 1) : NULL;
+	for(entry = prev != NULL ? prev->next : list->first; entry != NULL && entryIndex <= last; entry = next, entryIndex++) {
+		next = entry->next;
+		if(!isSelected(selection, &range, entryIndex, entry)) {
+			prev = entry;
+			continue;
 		}
 
-		/* Close the file */
-		fclose(file);
+		/* Unlink the entry */
+		if(prev == NULL) list->first = next;
+		else prev->next = next;
+		if(!rebuild) indexRemove(&list->index, entryIndex - removed);
+		list->doneCount -= entry->done;
+		if(list->searchBuilt) searchIndexMark(&list->search, entry->title, entry->titleLength, entry);
+		if(list->segmented) segmentsTouch(&list->segments, entry->id, 1);
+
+		/* Recycle the entry & its title unless it's shared (The file titles stay mapped until the list is freed) */
+		internRelease(&list->titles, entry->title, entry->titleLength);
+		arenaRecycleObject(&list->arena, entry);
+		removed++;
+	}
+	if(entry == NULL) list->last = prev;
+	if(removed == 0) return 0;
+
+	/* Drop the marked entries from the search index at once */
+	if(list->searchBuilt) searchIndexCompact(&list->search);
+
+	/* Rebuild the position index */
+	if(rebuild) {
+		indexFree(&list->index);
+		for(entry = list->first; entry != NULL; entry = entry->next) indexAppend(&list->index, entry);
 	}
+	list->matchesStale = 1;
+	return removed;
 }
 
-void freeTodoList() {
-	/* The entry pointers */
-	struct TODOEntry *next = TODOListFirst;
+/**
+ *  \brief Flips the status of a selection of entries in a single sweep
+ *
+ *  \param list The TODO list
+ *  \param selection The selection
+ *
+ *  \return The number of toggled entries
+ */
+static unsigned long flipEntries(struct TODOList *list, const struct TODOSelection *selection) {
+	struct TODOEntry *entry;
+	unsigned long entryIndex;
+	unsigned long last;
+	unsigned long range = 0;
+	unsigned long flipped = 0;
+
+	/* Sweep the span */
+	getSelectionSpan(list, selection, &entryIndex, &last);
+	if(entryIndex > last) return 0;
+	for(entry = (struct TODOEntry *) indexGet(&list->index, entryIndex); entry != NULL && entryIndex <= last; entry = entry->next, entryIndex++) {
+		if(!isSelected(selection, &range, entryIndex, entry)) continue;
+
+		/* Toggle the entry status */
+		entry->done = !entry->done;
+		if(entry->done) list->doneCount++;
+		else list->doneCount--;
+		if(list->segmented) segmentsTouch(&list->segments, entry->id, 0);
+		flipped++;
+	}
+	return flipped;
+}
+
+/**
+ *  \brief Tells whether two entries hold the same title & status
+ *
+ *  \param a The first entry
+ *  \param b The second entry
+ *
+ *  \return Whether they do
+ */
+static char isDuplicate(const struct TODOEntry *a, const struct TODOEntry *b) {
+	return a->done == b->done && a->titleLength == b->titleLength && (a->title == b->title || memcmp(a->title, b->title, a->titleLength) == 0);
+}
+
+/**
+ *  \brief Removes the entries holding the same title & status as an earlier one
+ *
+ *  A single sweep checking each entry against an open addressing set of
+ *  the kept ones, then the position index gets rebuilt once.
+ *
+ *  \param list The TODO list
+ *  \param bytes Set to the memory recycled (The removed entries structs &
+ *                the interned titles no entry holds anymore)
+ *
+ *  \return The number of removed entries
+ */
+static unsigned long removeDuplicates(struct TODOList *list, size_t *bytes) {
+	const struct TODOEntry **kept;
+	struct TODOEntry *prev = NULL;
 	struct TODOEntry *entry;
+	struct TODOEntry *next;
+	unsigned long mask = 1;
+	unsigned long slot;
+	unsigned long removed = 0;
+
+	*bytes = 0;
+	if(list->index.count < 2) return 0;
+	while(mask < list->index.count * 2) mask <<= 1;
+	if((kept = (const struct TODOEntry **) calloc(mask, sizeof(struct TODOEntry *))) == NULL) {
+		printf("ERROR allocating the duplicates set");
+		exit(1);
+	}
+	mask--;
 
-	/* Iterate through the TODO list */
-	while(next != NULL) {
-		entry = next;
+	for(entry = list->first; entry != NULL; entry = next) {
 		next = entry->next;
-		free(entry->title);
-		free(entry);
+		for(slot = (hashBytes(2166136261UL, entry->title, entry->titleLength) ^ entry->done) & mask; kept[slot] != NULL && !isDuplicate(kept[slot], entry); slot = (slot + 1) & mask);
+		if(kept[slot] == NULL) {
+			kept[slot] = prev = entry;
+			continue;
+		}
+
+		/* Unlink the entry */
+		if(prev == NULL) list->first = next;
+		else prev->next = next;
+		list->doneCount -= entry->done;
+		if(list->searchBuilt) searchIndexMark(&list->search, entry->title, entry->titleLength, entry);
+		if(list->segmented) segmentsTouch(&list->segments, entry->id, 1);
+
+		/* Recycle the entry & its title unless it's shared (The file titles stay mapped until the list is freed) */
+		*bytes += sizeof(struct TODOEntry) + internRelease(&list->titles, entry->title, entry->titleLength);
+		arenaRecycleObject(&list->arena, entry);
+		removed++;
+	}
+	list->last = prev;
+	free(kept);
+	if(removed == 0) return 0;
+
+	/* Drop the marked entries from the search index at once */
+	if(list->searchBuilt) searchIndexCompact(&list->search);
+
+	/* Rebuild the position index */
+	indexFree(&list->index);
+	for(entry = list->first; entry != NULL; entry = entry->next) indexAppend(&list->index, entry);
+	list->matchesStale = 1;
+	return removed;
+}
+
+/**
+ *  \brief Applies a journal record to a list
+ *
+ *  \param data The TODO list
+ *  \param op The record operation
+ *  \param index The record entry index
+ *  \param title The record text range start (The title or the selection)
+ *  \param length The record text range length
+ */
+static void applyJournalRecord(void *data, char op, unsigned long index, const char *title, size_t length) {
+	struct TODOList *list = (struct TODOList *) data;
+	struct TODOSelection selection;
+	size_t bytes;
+
+	switch(op) {
+		case JOURNAL_ADD:
+			appendEntry(list, title, length, 0);
+		break;
+		case JOURNAL_DELETE:
+			removeEntry(list, index);
+		break;
+		case JOURNAL_TOGGLE:
+			flipEntry(list, index);
+		break;
+		case JOURNAL_DELETE_SELECTION:
+		case JOURNAL_TOGGLE_SELECTION:
+			if(!parseSelection(&selection, title, length)) break;
+			if(op == JOURNAL_DELETE_SELECTION) removeEntries(list, &selection);
+			else flipEntries(list, &selection);
+			free(selection.ranges);
+		break;
+		case JOURNAL_DEDUPE:
+			removeDuplicates(list, &bytes);
+		break;
 	}
+}
 
-	TODOListFirst = TODOListLast = NULL;
-	
-	/* Free the filename */
-	if(TODOListFilename != NULL) {
-		free(TODOListFilename);
-		TODOListFilename = NULL;
+/**
+ *  \brief Persists a list mutation (With the writer mutex held)
+ *
+ *  In journal mode the mutation gets appended to the journal and the
+ *  list file is only rewritten once the journal outgrows it.
+ *  Otherwise, the whole list file is rewritten. Either way, the list
+ *  file gets written by the background writer. With the auto save
+ *  disabled, the list just gets flagged as dirty.
+ *
+ *  \param list The TODO list
+ *  \param op The mutation operation
+ *  \param index The mutated entry index
+ *  \param title The added entry title
+ *  \param length The added entry title length
+ */
+static void persistChange(struct TODOList *list, char op, unsigned long index, const char *title, size_t length) {
+	if(!TODOListAutoSave) {
+		/* Leave it for todoListFlush */
+		list->dirty = 1;
+		return;
 	}
 
-	/* Free the title */
-	if(TODOListTitle != NULL) {
-		free(TODOListTitle);
-		TODOListTitle = NULL;
+	if(list->journal.fd == -1) {
+		writerRequest(&list->writer);
+		return;
+	}
+
+	/* Save the whole list if the record couldn't be appended */
+	if(!journalAppend(&list->journal, op, index, title, length)) {
+		writerRequest(&list->writer);
+		return;
+	}
+	writerAppended(&list->writer, list->journal.filename);
+	if(!list->compacting && journalNeedsCompaction(&list->journal)) {
+		list->compacting = 1;
+		writerRequest(&list->writer);
 	}
 }
 
-void addNewEntry(char *userInput) {
-	/* Parse & trim entry title */
-	char *trimmedInput = trim(userInput + 1);
-	char *title;
-	const unsigned short int titleLength = strlen(trimmedInput);
-	if(titleLength == 0) return;
-	title = (char *) malloc((sizeof(char) * titleLength) + 1);
+/**
+ *  \brief Sets the title of a list
+ *
+ *  \param list The TODO list
+ *  \param title The title (or NULL to derive it from the filename)
+ *  \param length The title length
+ */
+static void setListTitle(struct TODOList *list, const char *title, size_t length) {
 	if(title == NULL) {
-		printf("ERROR allocating entry title");
+		/* Use the capitalized filename without the extension */
+		title = list->filename;
+		length = strchr(list->filename, '.') - list->filename;
+	}
+	list->title = (char *) malloc((sizeof(char) * length) + 1);
+	if(list->title == NULL) {
+		printf("ERROR allocating the list title");
 		exit(1);
 	}
-	strcpy(title, trimmedInput);
+	memcpy(list->title, title, length);
+	list->title[length] = '\0';
+	if(title == list->filename) list->title[0] = toupper(list->title[0]);
+}
 
-	/* Add the entry */
-	addEntry(title, 0);
+/**
+ *  \brief Tells whether a line starts with an entry marker & the separator
+ *
+ *  \param line The line start (At least a marker long)
+ *
+ *  \return Whether it does
+ */
+static char isMarker(const char *line) {
+	return line[sizeof(DONE_MARKER) - 1] == ' ' && (
+		memcmp(line, DONE_MARKER, sizeof(DONE_MARKER) - 1) == 0 ||
+		memcmp(line, PENDING_MARKER, sizeof(PENDING_MARKER) - 1) == 0
+	);
+}
 
-	/* Save the TODO list */
-	saveTodoList();
+/**
+ *  \brief Parses an entry line
+ *
+ *  \param line The line start
+ *  \param length The line length
+ *  \param title Set to the entry title start
+ *  \param titleLength Set to the entry title length
+ *  \param done Set to whether the entry is done or not
+ *
+ *  \return Whether the line holds an entry
+ */
+static char parseEntryLine(const char *line, size_t length, const char **title, size_t *titleLength, char *done) {
+	const char *separator;
+
+	/* Skip the blank lines (Indented lines are parsed past their indentation) */
+	line = trimRange(line, &length);
+	if(length == 0) return 0;
+
+	/* Parse the entry done flag (Checking for the markers before scanning for the separator) */
+	if(length > sizeof(DONE_MARKER) - 1 && isMarker(line)) separator = line + sizeof(DONE_MARKER) - 1;
+	else separator = findByte(line, line + length, ' ');
+	*done = (size_t) (separator - line) == sizeof(DONE_MARKER) - 1 && memcmp(line, DONE_MARKER, sizeof(DONE_MARKER) - 1) == 0;
+
+	/* Parse & trim the entry title */
+	*titleLength = length - (separator - line);
+	*title = trimRange(separator, titleLength);
+	return 1;
 }
 
-void addEntry(char *title, char done) {
-	/* Allocate the memory */
-	struct TODOEntry *entry = (struct TODOEntry*) malloc(sizeof(struct TODOEntry));
-	if(entry == NULL) {
-		printf("ERROR allocating entry");
-		exit(1);
+/**
+ *  \brief Parses the entries of a load segment
+ *
+ *  \param data The segment (As a void pointer, so it can be a thread start routine)
+ *
+ *  \return NULL
+ */
+static void *parseSegment(void *data) {
+	struct TODOLoadSegment *segment = (struct TODOLoadSegment *) data;
+	const char *line = segment->start;
+	const char *lineEnd;
+	const char *title;
+	size_t length;
+	char done;
+	struct TODOEntry *entry;
+
+	while(line < segment->end) {
+		/* Find the end of the line */
+		lineEnd = findByte(line, segment->end, '\n');
+
+		if(parseEntryLine(line, lineEnd - line, &title, &length, &done)) {
+			/* Chain the entry (Its title pointing into the file) into the segment */
+			entry = newEntry(&segment->arena, title, length, done);
+			if(segment->first == NULL) segment->first = entry;
+			else segment->last->next = entry;
+			segment->last = entry;
+		}
+
+		line = lineEnd + 1;
 	}
 
-	/* Assign the entry data */
-	entry->title = title;
-	entry->done = done;
-	entry->next = NULL;
-	
-	/* Push it to the list */
-	if(TODOListFirst == NULL) TODOListFirst = entry;
-	else TODOListLast->next = entry;
-	TODOListLast = entry;
+	/* Hand over the counters of the thread */
+	if(segment->threaded) memcpy(segment->counters, statsCounters, sizeof(segment->counters));
+	return NULL;
 }
 
-void deleteEntry(const unsigned short int entryIndex) {
-	/* The entry pointers */
-	struct TODOEntry *entry = TODOListFirst;
-	struct TODOEntry *prev = NULL;
+/**
+ *  \brief Returns the number of threads to parse the entries with
+ *
+ *  \param size The entries data size
+ *
+ *  \return The number of threads
+ */
+static unsigned int getLoadThreads(const size_t size) {
+	long threads = TODOListLoadThreads;
+
+	if(size < PARALLEL_LOAD_MIN_SIZE) return 1;
+	if(threads == 0) threads = sysconf(_SC_NPROCESSORS_ONLN);
+	if((size_t) threads > size / PARALLEL_LOAD_SEGMENT_SIZE) threads = size / PARALLEL_LOAD_SEGMENT_SIZE;
+	if(threads > PARALLEL_LOAD_MAX_THREADS) threads = PARALLEL_LOAD_MAX_THREADS;
+	return threads > 1 ? threads : 1;
+}
 
-	/* The loop entry index */
-	unsigned short int index = 1;
+/**
+ *  \brief Parses the entries lines
+ *
+ *  Splits the data into newline-aligned segments, parses them in
+ *  parallel (The first one on this thread) & links them in order.
+ *
+ *  \param list The TODO list
+ *  \param start The entries data start
+ *  \param end The entries data end
+ */
+static void parseEntries(struct TODOList *list, const char *start, const char *end) {
+	struct TODOLoadSegment segments[PARALLEL_LOAD_MAX_THREADS];
+	const unsigned int threads = getLoadThreads(end - start);
+	const char *boundary;
+	struct TODOEntry *entry;
+	struct TODOEntry *next;
+	unsigned int i;
 
-	/* Iterate through the TODO list */
-	while(entry != NULL) {
-		if(index++ == entryIndex) {
-			/* Unlink the entry */
-			if(prev == NULL) {
-				if((TODOListFirst = entry->next) == NULL) TODOListLast = NULL;
-			} else {
-				if((prev->next = entry->next) == NULL) TODOListLast = prev;
-			}
+	/* Split the data */
+	memset(segments, 0, sizeof(struct TODOLoadSegment) * threads);
+	for(i = 0; i < threads; i++) {
+		segments[i].start = i == 0 ? start : segments[i - 1].end;
+		segments[i].end = end;
+		if(i == threads - 1) continue;
 
-			/* Free the memory */
-			free(entry->title);
-			free(entry);
-			break;
+		/* End it after the line holding the even split point */
+		boundary = start + (end - start) / threads * (i + 1);
+		if(boundary < segments[i].start) boundary = segments[i].start;
+		if((boundary = findByte(boundary, end, '\n')) < end) segments[i].end = boundary + 1;
+	}
+
+	/* Parse them */
+	for(i = 1; i < threads; i++) {
+		segments[i].threaded = 1;
+		if(pthread_create(&segments[i].thread, NULL, parseSegment, segments + i) != 0) segments[i].threaded = 0;
+	}
+	parseSegment(segments);
+
+	/* Link them in file order */
+	for(i = 0; i < threads; i++) {
+		if(segments[i].threaded) {
+			pthread_join(segments[i].thread, NULL);
+			statsAddCounters(segments[i].counters);
+		} else if(i > 0) {
+			/* The thread couldn't be created */
+			parseSegment(segments + i);
+		}
+
+		arenaMerge(&list->arena, &segments[i].arena);
+		for(entry = segments[i].first; entry != NULL; entry = next) {
+			next = entry->next;
+			linkEntry(list, entry);
+		}
+	}
+}
+
+/**
+ *  \brief Parses the three header lines of the TODO list text format
+ *
+ *  \param data The TODO list data
+ *  \param end The data end
+ *  \param title Set to the title start (NULL if there's no title line)
+ *  \param length Set to the title length
+ *
+ *  \return The entries data start
+ */
+static const char *parseHeader(const char *data, const char *end, const char **title, size_t *length) {
+	/* The line pointers */
+	const char *line = data;
+	const char *lineEnd;
+
+	/* The lines counter */
+	int lineNumber;
+
+	*title = NULL;
+	for(lineNumber = 0; lineNumber < 3 && line < end; lineNumber++) {
+		/* Find the end of the line */
+		lineEnd = findByte(line, end, '\n');
+
+		if(lineNumber == 1) {
+			/* Parse & trim the title line */
+			*length = lineEnd - line;
+			*title = trimRange(line, length);
 		}
-		prev = entry;
-		entry = entry->next;
+
+		line = lineEnd + 1;
+	}
+	return line;
+}
+
+/**
+ *  \brief Parses the TODO list text format
+ *
+ *  Scans the data for line boundaries with findByte, parses the title
+ *  from the three header lines & the entries from the rest of them.
+ *
+ *  \param list The TODO list
+ *  \param data The TODO list data (The entries titles point into it)
+ *  \param size The data size
+ */
+static void parseTODOList(struct TODOList *list, const char *data, const size_t size) {
+	const char *end = data + size;
+	const char *title;
+	size_t length;
+	const char *line = parseHeader(data, end, &title, &length);
+
+	if(title != NULL) setListTitle(list, title, length);
+	if(line < end) parseEntries(list, line, end);
+}
+
+/**
+ *  \brief Loads a TODO list from a fresh snapshot
+ *
+ *  The entries titles point straight into the mapped snapshot,
+ *  which stays mapped until the list is freed.
+ *
+ *  \param list The TODO list
+ *  \param base The identity of the list file
+ *
+ *  \return Whether the snapshot was fresh & got loaded
+ */
+static char loadSnapshot(struct TODOList *list, const struct FileIdentity *base) {
+	char *filename = snapshotFilename(list->filename);
+	unsigned long i;
+
+	if(!snapshotOpen(&list->snapshot, filename, base)) {
+		free(filename);
+		return 0;
+	}
+	free(filename);
+
+	/* Link the entries */
+	setListTitle(list, list->snapshot.title, strlen(list->snapshot.title));
+	for(i = 0; i < list->snapshot.count; i++) {
+		linkEntry(list, newEntry(
+			&list->arena, list->snapshot.blob + list->snapshot.offsets[i], list->snapshot.offsets[i + 1] - list->snapshot.offsets[i] - 1,
+			(list->snapshot.done[i / 64] >> (i % 64)) & 1
+		));
 	}
+	return 1;
+}
+
+/**
+ *  \brief Writes a snapshot of a TODO list
+ *
+ *  \param list The TODO list
+ */
+static void saveSnapshot(struct TODOList *list) {
+	struct SnapshotWriter writer = {{NULL, 0, 0}, {NULL, 0, 0}, {NULL, 0, 0}, 0};
+	struct FileIdentity source;
+	struct TODOEntry *entry;
+	char *filename;
+
+	/* Add the entries */
+	for(entry = list->first; entry != NULL; entry = entry->next) snapshotAdd(&writer, entry->title, entry->titleLength, entry->done);
+
+	/* Write it along with the identity of the list file */
+	filename = snapshotFilename(list->filename);
+	getFileIdentity(list->filename, &source);
+	snapshotWrite(&writer, filename, &source, list->title);
+	free(filename);
+}
+
+/**
+ *  \brief Serializes the title lines of the TODO list text format
+ *
+ *  \param buffer The buffer to serialize them into
+ *  \param title The list title
+ */
+static void serializeTitle(struct Buffer *buffer, const char *title) {
+	/* Title decorations length */
+	const size_t decorationsLength = 40;
 
-	/* Save the TODO list */
-	saveTodoList();
+	/* The title length & centering padding */
+	const size_t titleLength = strlen(title);
+	const size_t titleWidth = (decorationsLength / 2) + titleLength / 2;
+
+	/* The title line buffers */
+	char decoration[41];
+	char padding[21];
+
+	/* Put the title */
+	memset(decoration, '=', decorationsLength);
+	decoration[decorationsLength] = '\n';
+	memset(padding, ' ', sizeof(padding));
+	bufferAppend(buffer, decoration, decorationsLength + 1);
+	if(titleWidth > titleLength) bufferAppend(buffer, padding, titleWidth - titleLength);
+	bufferAppend(buffer, title, titleLength);
+	bufferAppend(buffer, "\n", 1);
+	bufferAppend(buffer, decoration, decorationsLength + 1);
+}
+
+/**
+ *  \brief Serializes an entry line of the TODO list text format
+ *
+ *  \param buffer The buffer to serialize it into
+ *  \param entry The entry
+ */
+static void serializeEntry(struct Buffer *buffer, const struct TODOEntry *entry) {
+	bufferAppend(buffer, entry->done ? DONE_MARKER " " : PENDING_MARKER " ", sizeof(DONE_MARKER));
+	bufferAppend(buffer, entry->title, entry->titleLength);
+	bufferAppend(buffer, "\n", 1);
 }
 
-void toggleEntry(const unsigned short int entryIndex) {
+/**
+ *  \brief Serializes the TODO list text format
+ *
+ *  \param list The TODO list
+ *  \param buffer The buffer to serialize it into
+ *  \param snapshot The snapshot writer to add the entries to (or NULL)
+ */
+static void serializeTodoList(struct TODOList *list, struct Buffer *buffer, struct SnapshotWriter *snapshot) {
 	/* The entry pointer */
-	struct TODOEntry *entry = TODOListFirst;
+	struct TODOEntry *entry;
 
-	/* The loop entry index */
-	unsigned short int index = 1;
+	/* Put the title */
+	serializeTitle(buffer, list->title);
 
-	/* Iterate through the TODO list */
-	while(entry != NULL) {
-		if(index++ == entryIndex) {
-			/* Toggle the entry status */
-			entry->done = !entry->done;
-			break;
+	/* Put the entries */
+	for(entry = list->first; entry != NULL; entry = entry->next) {
+		serializeEntry(buffer, entry);
+		if(snapshot != NULL) snapshotAdd(snapshot, entry->title, entry->titleLength, entry->done);
+	}
+}
+
+/**
+ *  \brief Adds an entry to a synced entries array
+ *
+ *  \param synced The synced entries
+ *  \param entry The entry (or NULL if it was deleted)
+ *  \param title The entry title in the file
+ *  \param length The entry title length
+ *  \param done The entry status in the file
+ */
+static void addSyncedEntry(struct Buffer *synced, const struct TODOEntry *entry, const char *title, size_t length, char done) {
+	struct TODOSyncedEntry item;
+
+	item.id = entry != NULL ? entry->id : 0;
+	item.hash = hashBytes(2166136261UL, title, length);
+	item.titleLength = length;
+	item.done = done;
+	item.deleted = entry == NULL;
+	bufferAppend(synced, (const char *) &item, sizeof(struct TODOSyncedEntry));
+}
+
+/**
+ *  \brief Takes the entries of a list as they're about to be written (In watch mode)
+ *
+ *  \param list The TODO list
+ *  \param synced The synced entries
+ */
+static void takeSyncedEntries(struct TODOList *list, struct Buffer *synced) {
+	const struct TODOEntry *entry;
+
+	if(list->watch.fd == -1) return;
+	for(entry = list->first; entry != NULL; entry = entry->next) addSyncedEntry(synced, entry, entry->title, entry->titleLength, entry->done);
+}
+
+/**
+ *  \brief Records the list file as it was just read or written (In watch mode)
+ *
+ *  \param list The TODO list
+ *  \param synced The entries it holds (Taken over)
+ *  \param identity The identity of the list file
+ */
+static void recordSynced(struct TODOList *list, struct Buffer *synced, const struct FileIdentity *identity) {
+	char *data;
+	size_t size;
+
+	bufferFree(&list->syncedEntries);
+	list->syncedEntries = *synced;
+	memset(synced, 0, sizeof(struct Buffer));
+	if(list->watch.fd == -1) return;
+
+	/* Hash its contents, to tell whether the next change just appends to them */
+	list->synced = *identity;
+	if((data = readFile(list->filename, &size)) != NULL && size == identity->size) {
+		list->syncedHash = hashBytes(2166136261UL, data, size);
+	} else {
+		/* So it doesn't pass for the same file */
+		list->synced.inode = 0;
+	}
+	free(data);
+}
+
+/**
+ *  \brief Returns the file the journal of a list applies to
+ *
+ *  \param list The TODO list
+ *
+ *  \return The manifest of a segmented list or the list file
+ */
+static const char *getBaseFilename(const struct TODOList *list) {
+	return list->segmented ? list->segments.manifest : list->filename;
+}
+
+/**
+ *  \brief Takes the dirty segments of a list & its manifest for a write
+ *
+ *  Each dirty segment gets its first entry from the position index,
+ *  past the entries of the segments before it. So only the entries of
+ *  the dirty segments get walked & serialized.
+ *
+ *  \param list The TODO list
+ *  \param writer The segments writer
+ */
+static void takeSegments(struct TODOList *list, struct SegmentsWriter *writer) {
+	const struct TODOEntry *entry;
+	unsigned long entryIndex = 1;
+	unsigned long count;
+	unsigned long i;
+
+	segmentsTake(&list->segments, writer);
+	for(i = 0; i < list->segments.count; entryIndex += list->segments.items[i++].count) {
+		if(!list->segments.items[i].dirty) continue;
+
+		/* Put its entries */
+		segmentsTakeFile(&list->segments, writer, i);
+		entry = (const struct TODOEntry *) indexGet(&list->index, entryIndex);
+		for(count = list->segments.items[i].count; count > 0 && entry != NULL; count--, entry = entry->next) serializeEntry(&writer->contents, entry);
+	}
+	segmentsTakeManifest(&list->segments, writer, list->title);
+}
+
+/**
+ *  \brief Writes a serialized TODO list into the hard disk
+ *
+ *  \param list The TODO list
+ *  \param buffer The serialized list (Gets emptied)
+ *  \param snapshot The snapshot writer with the list entries (or NULL)
+ *  \param sync What to fsync (WRITE_SYNC_* constant)
+ *
+ *  \return Whether the list file got written
+ */
+static char commitTodoList(struct TODOList *list, struct Buffer *buffer, struct SnapshotWriter *snapshot, int sync) {
+	struct FileIdentity source;
+	char *filename;
+	char written;
+
+	/* Replace the list file */
+	STATS_COUNT(STATS_BYTES_WRITTEN, buffer->length);
+	if(!(written = writeFileAtomically(list->filename, buffer, sync))) printf("ERROR writing to file: %s\n", list->filename);
+
+	/* Write the snapshot along with the identity of the new list file */
+	if(snapshot != NULL) {
+		filename = snapshotFilename(list->filename);
+		getFileIdentity(list->filename, &source);
+		if(written) snapshotWrite(snapshot, filename, &source, list->title);
+		bufferFree(&snapshot->offsets);
+		bufferFree(&snapshot->done);
+		bufferFree(&snapshot->blob);
+		free(filename);
+	}
+	return written;
+}
+
+/**
+ *  \brief Saves a TODO list from its background writer
+ *
+ *  Takes the list contents with the writer mutex held, so they're
+ *  consistent, and releases it while writing them into the hard disk.
+ *
+ *  \param data The TODO list
+ *  \param sync What to fsync (WRITE_SYNC_* constant)
+ */
+static void writeTodoList(void *data, int sync) {
+	struct TODOList *list = (struct TODOList *) data;
+	struct Buffer buffer = {NULL, 0, 0};
+	struct SnapshotWriter snapshot = {{NULL, 0, 0}, {NULL, 0, 0}, {NULL, 0, 0}, 0};
+	struct SegmentsWriter segments = {{NULL, 0, 0}, {NULL, 0, 0}, {NULL, 0, 0}, {NULL, 0, 0}};
+	struct Buffer synced = {NULL, 0, 0};
+	struct FileIdentity identity;
+	const unsigned long journalOffset = list->journal.size;
+	const double statsStart = statsBegin();
+	char written;
+
+	if(list->segmented) takeSegments(list, &segments);
+	else serializeTodoList(list, &buffer, TODOListSnapshotMode ? &snapshot : NULL);
+	takeSyncedEntries(list, &synced);
+	writerUnlock(&list->writer);
+	if(list->segmented) written = segmentsWrite(&list->segments, &segments, sync);
+	else written = commitTodoList(list, &buffer, TODOListSnapshotMode ? &snapshot : NULL, sync);
+	bufferFree(&buffer);
+	writerLock(&list->writer);
+	if(list->segmented) segmentsFinish(&list->segments, &segments, written);
+
+	/* Keep just the journal records that came after the list contents were taken */
+	if(written && list->journal.fd != -1) journalRebase(&list->journal, getBaseFilename(list), journalOffset);
+
+	/* Tell our own write apart from the external changes */
+	if(written) {
+		getFileIdentity(list->filename, &identity);
+		recordSynced(list, &synced, &identity);
+		writerSaved(&list->writer, list->segmented ? list->segments.manifest : list->filename);
+	}
+	bufferFree(&synced);
+	list->compacting = 0;
+	statsEnd(STATS_SAVE, statsStart);
+}
+
+/**
+ *  \brief Saves a TODO list (See todoListSave)
+ *
+ *  \param list The TODO list
+ *
+ *  \return Whether it got written
+ */
+static char saveList(struct TODOList *list) {
+	struct Buffer buffer = {NULL, 0, 0};
+	struct SnapshotWriter snapshot = {{NULL, 0, 0}, {NULL, 0, 0}, {NULL, 0, 0}, 0};
+	struct SegmentsWriter segments = {{NULL, 0, 0}, {NULL, 0, 0}, {NULL, 0, 0}, {NULL, 0, 0}};
+	struct Buffer synced = {NULL, 0, 0};
+	struct FileIdentity identity;
+	const int sync = list->writer.fsyncPolicy != WRITER_FSYNC_NEVER ? WRITE_SYNC_ALL : WRITE_SYNC_NONE;
+	char written;
+
+	/* The save start time */
+	const double statsStart = statsBegin();
+
+	/* Let the background save finish first */
+	writerFlush(&list->writer);
+
+	if(list->segmented) {
+		/* Just the dirty segments & the manifest */
+		takeSegments(list, &segments);
+		written = segmentsWrite(&list->segments, &segments, sync);
+		segmentsFinish(&list->segments, &segments, written);
+	} else {
+		serializeTodoList(list, &buffer, TODOListSnapshotMode ? &snapshot : NULL);
+		takeSyncedEntries(list, &synced);
+		if((written = commitTodoList(list, &buffer, TODOListSnapshotMode ? &snapshot : NULL, sync))) {
+			getFileIdentity(list->filename, &identity);
+			recordSynced(list, &synced, &identity);
 		}
-		entry = entry->next;
+		bufferFree(&synced);
+		bufferFree(&buffer);
+	}
+	statsEnd(STATS_SAVE, statsStart);
+	return written;
+}
+
+/**
+ *  \brief Loads the entries of a segmented list
+ *
+ *  The segment files get read one after the other & parsed (in parallel)
+ *  as a single list file. Then each segment gets the entries whose titles
+ *  point into its part of the data.
+ *
+ *  \param list The TODO list
+ *  \param title The list title (From the manifest)
+ *
+ *  \return The size of the segment files
+ */
+static size_t loadSegments(struct TODOList *list, const char *title) {
+	size_t *ends = (size_t *) malloc(sizeof(size_t) * (list->segments.count + 1));
+	struct Segment *segment;
+	const struct TODOEntry *entry;
+	unsigned long i;
+
+	if(ends == NULL) {
+		printf("ERROR allocating the segments ends");
+		exit(1);
 	}
+	if(title[0] != '\0') setListTitle(list, title, strlen(title));
+	list->data = segmentsRead(&list->segments, &list->dataSize, ends);
+	if(list->dataSize > 0) parseEntries(list, list->data, list->data + list->dataSize);
 
-	/* Save the TODO list */
-	saveTodoList();
+	/* Count the entries of each segment */
+	for(i = 0, entry = list->first; i < list->segments.count; i++) {
+		segment = list->segments.items + i;
+		segment->firstId = entry != NULL ? entry->id : list->nextId;
+		for(; entry != NULL && entry->title < list->data + ends[i]; entry = entry->next) segment->count++;
+	}
+	free(ends);
+	return list->dataSize;
 }
 
-const char *getTODOListTitle() {
-	return TODOListTitle;
+/**
+ *  \brief Moves a list loaded from its file into segments
+ *
+ *  The file & its snapshot get removed once the segments are written,
+ *  so the two layouts can't drift apart.
+ *
+ *  \param list The TODO list
+ *
+ *  \return Whether it got moved (It keeps using the file otherwise)
+ */
+static char convertList(struct TODOList *list) {
+	const struct TODOEntry *entry;
+	char *filename;
+
+	/* Pack the entries */
+	list->segmented = 1;
+	for(entry = list->first; entry != NULL; entry = entry->next) segmentsAppend(&list->segments, entry->id);
+	if(!saveList(list)) {
+		list->segmented = 0;
+		list->segments.count = 0;
+		return 0;
+	}
+
+	unlink(list->filename);
+	filename = snapshotFilename(list->filename);
+	unlink(filename);
+	free(filename);
+	return 1;
 }
 
-const struct TODOEntry *getTODOListFirst() {
-	return TODOListFirst;
+/**
+ *  \brief Loads the entries of an open list
+ *
+ *  \param list The TODO list
+ */
+static void loadList(struct TODOList *list) {
+	/* The file size */
+	size_t size = 0;
+
+	/* The journal */
+	struct FileIdentity base;
+	char *journal;
+	unsigned long journalSize;
+	unsigned long replayed;
+
+	/* The load start time */
+	const double startTime = getMonotonicTime();
+	const double statsStart = statsBegin();
+
+	/* The synced entries */
+	struct Buffer synced = {NULL, 0, 0};
+
+	/* The segments manifest title & whether the list gets moved into segments */
+	char *title = NULL;
+	char converting;
+
+	/* Load the segments, the snapshot or map & parse the file (Watching it first, so no change gets missed) */
+	list->loaded = 1;
+	list->dataMapped = 0;
+	list->segmented = !list->classic && segmentsOpen(&list->segments, list->filename, &title);
+	converting = !list->classic && !list->segmented && TODOListSegmentMode;
+	if(TODOListWatchMode && !list->segmented && !converting) watchOpen(&list->watch, list->filename);
+	getFileIdentity(getBaseFilename(list), &base);
+	if(list->segmented) {
+		size = loadSegments(list, title);
+	} else if(loadSnapshot(list, &base)) {
+		size = list->snapshot.size;
+	} else if((list->data = TODOListWatchMode ? readFile(list->filename, &size) : mapFile(list->filename, &size, &list->dataMapped)) != NULL) {
+		/* The entries titles point into it, so it stays mapped (The saves replace the file, they never write into it) */
+		/* In watch mode it's read instead, as other processes may write into it */
+		list->dataSize = size;
+		parseTODOList(list, list->data, size);
+
+		/* Take a snapshot for the next load */
+		if(TODOListSnapshotMode && !converting && list->title != NULL) saveSnapshot(list);
+	}
+	free(title);
+
+	/* Keep the entries of the file, to merge its external changes with the local ones */
+	takeSyncedEntries(list, &synced);
+	recordSynced(list, &synced, &base);
+	bufferFree(&synced);
+
+	/* Replay the journal on top of it */
+	journal = journalFilename(getBaseFilename(list));
+	replayed = journalReplay(journal, &base, applyJournalRecord, list, &journalSize);
+
+	/* If we got no title from the file, use the provided one or the filename */
+	if(list->title == NULL) setListTitle(list, list->defaultTitle, list->defaultTitle != NULL ? strlen(list->defaultTitle) : 0);
+
+	/* Move it into segments (Folding the journal into them) */
+	if(converting && convertList(list)) {
+		unlink(journal);
+		journalSize = replayed = 0;
+	}
+
+	if(TODOListJournalMode) {
+		/* Keep appending to the journal (Syncing each record with the always policy & once per interval with the interval one) */
+		journalOpen(&list->journal, getBaseFilename(list), journalSize, list->writer.fsyncPolicy == WRITER_FSYNC_ALWAYS ? WRITE_SYNC_ALL : list->writer.fsyncPolicy == WRITER_FSYNC_INTERVAL ? WRITE_SYNC_DATA : WRITE_SYNC_NONE);
+	} else if(replayed > 0) {
+		/* Fold a journal left behind by a journal mode session */
+		todoListSave(list);
+		unlink(journal);
+	}
+	free(journal);
+
+	/* Update the load stats */
+	list->loadStats.bytes = size + journalSize;
+	list->loadStats.seconds = getMonotonicTime() - startTime;
+	STATS_COUNT(STATS_BYTES_READ, size);
+	statsEnd(STATS_LOAD, statsStart);
+}
+
+/**
+ *  \brief Frees the entries of a loaded list
+ *         (After stopping the background writer)
+ *
+ *  \param list The TODO list
+ */
+static void unloadList(struct TODOList *list) {
+	/* Finish the background writes */
+	writerStop(&list->writer);
+
+	/* Close the journal, the watch & the segments */
+	journalClose(&list->journal);
+	watchClose(&list->watch);
+	segmentsClose(&list->segments);
+	list->segmented = 0;
+	bufferFree(&list->syncedEntries);
+	memset(&list->syncedEntries, 0, sizeof(struct Buffer));
+	memset(&list->synced, 0, sizeof(struct FileIdentity));
+
+	/* Unmap the snapshot & the list file */
+	snapshotClose(&list->snapshot);
+	if(list->data != NULL) {
+		unmapFile(list->data, list->dataSize, list->dataMapped);
+		list->data = NULL;
+	}
+
+	/* Release the search index & the current matches (The query stays) */
+	searchIndexFree(&list->search);
+	searchResultsFree(&list->matches);
+	list->searchBuilt = 0;
+	list->matchesStale = 1;
+
+	/* Release the entries index, the entries arena & the titles */
+	indexFree(&list->index);
+	arenaFree(&list->arena);
+	internFree(&list->titles);
+	list->first = list->last = NULL;
+	list->doneCount = 0;
+	list->nextId = 0;
+
+	/* Free the title */
+	free(list->title);
+	list->title = NULL;
+	list->loaded = 0;
+}
+
+/**
+ *  \brief Takes a list out of the loaded lists (With the lists mutex held)
+ *
+ *  \param list The TODO list
+ */
+static void unlinkLoadedList(struct TODOList *list) {
+	if(list->newer != NULL) list->newer->older = list->older;
+	else TODOListNewest = list->older;
+	if(list->older != NULL) list->older->newer = list->newer;
+	else TODOListOldest = list->newer;
+	list->newer = list->older = NULL;
+	TODOListLoadedCount--;
+}
+
+/**
+ *  \brief Saves the changes of a loaded list (See todoListFlush)
+ *
+ *  \param list The TODO list
+ */
+static void flushList(struct TODOList *list) {
+	/* Wait for the background writes */
+	writerFlush(&list->writer);
+	if(!list->dirty) return;
+
+	/* Save the whole list (Folding the journal into it) */
+	saveList(list);
+	if(list->journal.fd != -1) journalReset(&list->journal, getBaseFilename(list));
+	list->dirty = 0;
+}
+
+/**
+ *  \brief Takes a list out of the loaded lists & frees its entries
+ *         (With the lists mutex held, which gets released meanwhile)
+ *
+ *  The list is marked as loading, so the other threads wait for it.
+ *
+ *  \param list The TODO list
+ *  \param flush Whether to save its changes first
+ */
+static void dropList(struct TODOList *list, char flush) {
+	unlinkLoadedList(list);
+	list->loading = 1;
+	pthread_mutex_unlock(&TODOListsMutex);
+	if(flush) flushList(list);
+	unloadList(list);
+	pthread_mutex_lock(&TODOListsMutex);
+	list->loading = 0;
+	pthread_cond_broadcast(&TODOListsLoaded);
+}
+
+/**
+ *  \brief Makes sure a list is loaded, marks it as the most recently used & pins it
+ *
+ *  Loading it evicts the least recently used lists past TODOListMaxLoaded
+ *  that aren't in use, saving their changes first. The loads & the saves
+ *  run outside the lists mutex, so they only hold back the threads using
+ *  those lists. Every successful call must be matched by a releaseList.
+ *
+ *  \param list The TODO list
+ *
+ *  \return Whether the list is open
+ */
+static char useList(struct TODOList *list) {
+	struct TODOList *evicted;
+
+	if(list->filename == NULL) return 0;
+	pthread_mutex_lock(&TODOListsMutex);
+	while(list->loading) pthread_cond_wait(&TODOListsLoaded, &TODOListsMutex);
+	list->users++;
+
+	if(list->loaded) {
+		/* Move it to the front */
+		if(TODOListNewest == list) {
+			pthread_mutex_unlock(&TODOListsMutex);
+			return 1;
+		}
+		unlinkLoadedList(list);
+	} else {
+		list->loading = 1;
+		pthread_mutex_unlock(&TODOListsMutex);
+		loadList(list);
+		pthread_mutex_lock(&TODOListsMutex);
+		list->loading = 0;
+		pthread_cond_broadcast(&TODOListsLoaded);
+	}
+	list->older = TODOListNewest;
+	if(TODOListNewest != NULL) TODOListNewest->newer = list;
+	else TODOListOldest = list;
+	TODOListNewest = list;
+	TODOListLoadedCount++;
+
+	/* Evict the least recently used lists (Skipping the ones in use) */
+	evicted = TODOListOldest;
+	while(TODOListMaxLoaded > 0 && TODOListLoadedCount > TODOListMaxLoaded && evicted != NULL) {
+		if(evicted->users > 0) {
+			evicted = evicted->newer;
+		} else {
+			dropList(evicted, 1);
+			evicted = TODOListOldest;
+		}
+	}
+
+	pthread_mutex_unlock(&TODOListsMutex);
+	return 1;
+}
+
+/**
+ *  \brief Pins a list if it's loaded (Without loading it)
+ *
+ *  \param list The TODO list
+ *
+ *  \return Whether it's loaded (Then it must be released)
+ */
+static char useLoadedList(struct TODOList *list) {
+	char loaded;
+
+	pthread_mutex_lock(&TODOListsMutex);
+	while(list->loading) pthread_cond_wait(&TODOListsLoaded, &TODOListsMutex);
+	if((loaded = list->loaded)) list->users++;
+	pthread_mutex_unlock(&TODOListsMutex);
+	return loaded;
+}
+
+/**
+ *  \brief Unpins a list pinned by useList, so it can be evicted again
+ *
+ *  \param list The TODO list
+ */
+static void releaseList(struct TODOList *list) {
+	pthread_mutex_lock(&TODOListsMutex);
+	list->users--;
+	pthread_mutex_unlock(&TODOListsMutex);
+}
+
+/**
+ *  \brief Opens a list into a list struct
+ *
+ *  \param list The TODO list
+ *  \param filename The TODO list filename
+ *  \param title The TODO list title
+ *  \param classic Whether the list keeps the single file layout
+ */
+static void openList(struct TODOList *list, const char *filename, const char *title, char classic) {
+	memset(list, 0, sizeof(struct TODOList));
+	list->journal.fd = list->watch.fd = -1;
+	list->classic = classic;
+	list->filename = todoListFilename(filename);
+
+	/* Keep the provided title for the reloads */
+	if(title != NULL) {
+		if((list->defaultTitle = (char *) malloc(strlen(title) + 1)) == NULL) {
+			printf("ERROR allocating the list title");
+			exit(1);
+		}
+		strcpy(list->defaultTitle, title);
+	}
+
+	writerInit(&list->writer, writeTodoList, list, TODOListFsyncPolicy);
+	if(useList(list)) releaseList(list);
+}
+
+/**
+ *  \brief Closes the list of a list struct
+ *
+ *  \param list The TODO list
+ */
+static void closeList(struct TODOList *list) {
+	if(list->filename == NULL) return;
+
+	/* Free the entries */
+	pthread_mutex_lock(&TODOListsMutex);
+	while(list->loading) pthread_cond_wait(&TODOListsLoaded, &TODOListsMutex);
+	if(list->loaded) dropList(list, 0);
+	pthread_mutex_unlock(&TODOListsMutex);
+	writerDestroy(&list->writer);
+
+	/* Save & close the archive */
+	if(list->archive != NULL) {
+		todoListFlush(list->archive);
+		closeList(list->archive);
+		free(list->archive);
+		list->archive = NULL;
+	}
+
+	/* Free the filename, the title & the query */
+	free(list->filename);
+	list->filename = NULL;
+	free(list->defaultTitle);
+	list->defaultTitle = NULL;
+	free(list->filter);
+	list->filter = NULL;
+}
+
+char *todoListFilename(const char *filename) {
+	/* Add extension to file name (if missing) */
+	char *extension = strchr(filename, '.');
+	char *listFilename = (char *) malloc((sizeof(char) * strlen(filename)) + (extension == NULL ? 4 : 0) + 1);
+
+	if(listFilename == NULL) {
+		printf("ERROR allocating the list filename");
+		exit(1);
+	}
+	strcpy(listFilename, filename);
+	if(extension == NULL) strcat(listFilename, ".txt");
+	return listFilename;
+}
+
+struct TODOList *todoListOpen(const char *filename, const char *title) {
+	struct TODOList *list = (struct TODOList *) malloc(sizeof(struct TODOList));
+
+	if(list == NULL) {
+		printf("ERROR allocating the list");
+		exit(1);
+	}
+	openList(list, filename, title, 0);
+	if(TODOListArchiveKeep > 0) todoListArchive(list, TODOListArchiveKeep);
+	return list;
+}
+
+void todoListClose(struct TODOList *list) {
+	closeList(list);
+	free(list);
+}
+
+void todoListSave(struct TODOList *list) {
+	saveList(list);
+}
+
+void todoListFlush(struct TODOList *list) {
+	if(!useLoadedList(list)) return;
+	flushList(list);
+	releaseList(list);
+}
+
+char todoListExport(struct TODOList *list, const char *filename) {
+	struct Buffer buffer = {NULL, 0, 0};
+	char written;
+
+	if(!useList(list)) return 0;
+
+	/* Serialize it along with the changes the writer hasn't saved yet */
+	writerLock(&list->writer);
+	serializeTodoList(list, &buffer, NULL);
+	writerUnlock(&list->writer);
+	releaseList(list);
+
+	STATS_COUNT(STATS_BYTES_WRITTEN, buffer.length);
+	if(!(written = writeFileAtomically(filename, &buffer, list->writer.fsyncPolicy != WRITER_FSYNC_NEVER ? WRITE_SYNC_ALL : WRITE_SYNC_NONE))) printf("ERROR writing to file: %s\n", filename);
+	bufferFree(&buffer);
+	return written;
+}
+
+char todoListAdd(struct TODOList *list, const char *title, size_t length, char done) {
+	/* Trim the entry title */
+	title = trimRange(title, &length);
+	if(length == 0 || !useList(list)) return 0;
+
+	/* Add the entry */
+	writerLock(&list->writer);
+	appendEntry(list, title, length, done);
+
+	/* Persist the change (The journal adds are pending, so a done one gets toggled too) */
+	persistChange(list, JOURNAL_ADD, 0, title, length);
+	if(done) persistChange(list, JOURNAL_TOGGLE, list->index.count, NULL, 0);
+	writerUnlock(&list->writer);
+	releaseList(list);
+	return 1;
+}
+
+char todoListDelete(struct TODOList *list, const unsigned long entryIndex) {
+	char existed;
+
+	if(!useList(list)) return 0;
+
+	/* Remove the entry */
+	writerLock(&list->writer);
+	if((existed = removeEntry(list, entryIndex))) {
+		/* Persist the change */
+		persistChange(list, JOURNAL_DELETE, entryIndex, NULL, 0);
+	}
+	writerUnlock(&list->writer);
+	releaseList(list);
+	return existed;
+}
+
+char todoListToggle(struct TODOList *list, const unsigned long entryIndex) {
+	char existed;
+
+	if(!useList(list)) return 0;
+
+	/* Toggle the entry */
+	writerLock(&list->writer);
+	if((existed = flipEntry(list, entryIndex))) {
+		/* Persist the change */
+		persistChange(list, JOURNAL_TOGGLE, entryIndex, NULL, 0);
+	}
+	writerUnlock(&list->writer);
+	releaseList(list);
+	return existed;
+}
+
+/**
+ *  \brief Returns the archive filename for a list file
+ *         (Replacing its ".txt" extension)
+ *
+ *  \param listFilename The list filename
+ *
+ *  \return A newly allocated archive filename
+ */
+static char *archiveFilename(const char *listFilename) {
+	size_t length = strlen(listFilename);
+	char *filename = (char *) malloc(length + sizeof(ARCHIVE_EXTENSION));
+
+	if(filename == NULL) {
+		printf("ERROR allocating archive filename");
+		exit(1);
+	}
+	if(length >= 4 && strcmp(listFilename + length - 4, ".txt") == 0) length -= 4;
+	memcpy(filename, listFilename, length);
+	strcpy(filename + length, ARCHIVE_EXTENSION);
+	return filename;
+}
+
+/**
+ *  \brief Appends entry lines to the archive of a list
+ *         (Starting it with the title lines if it's new)
+ *
+ *  \param list The TODO list
+ *  \param entries The serialized entries
+ *
+ *  \return Whether they got written
+ */
+static char appendArchive(struct TODOList *list, struct Buffer *entries) {
+	char *filename = archiveFilename(list->filename);
+	struct Buffer header = {NULL, 0, 0};
+	struct stat info;
+	char *title;
+	char written;
+	int fd;
+
+	if((fd = open(filename, O_WRONLY | O_APPEND | O_CREAT, 0644)) == -1) {
+		printf("ERROR opening archive: %s\n", filename);
+		free(filename);
+		return 0;
+	}
+
+	if(fstat(fd, &info) == 0 && info.st_size == 0) {
+		if((title = (char *) malloc(strlen(list->title) + sizeof(ARCHIVE_TITLE_SUFFIX))) == NULL) {
+			printf("ERROR allocating archive title");
+			exit(1);
+		}
+		strcpy(title, list->title);
+		strcat(title, ARCHIVE_TITLE_SUFFIX);
+		serializeTitle(&header, title);
+		bufferFlush(&header, fd);
+		bufferFree(&header);
+		free(title);
+	}
+
+	STATS_COUNT(STATS_BYTES_WRITTEN, entries->length);
+	written = bufferFlush(entries, fd) && (list->writer.fsyncPolicy == WRITER_FSYNC_NEVER || fsync(fd) == 0);
+	if(!written) printf("ERROR writing to file: %s\n", filename);
+	close(fd);
+	free(filename);
+	return written;
+}
+
+/**
+ *  \brief Drops the loaded entries of a list, so they get loaded again from its file
+ *
+ *  \param list The TODO list
+ */
+static void reloadList(struct TODOList *list) {
+	todoListFlush(list);
+	pthread_mutex_lock(&TODOListsMutex);
+	while(list->loading) pthread_cond_wait(&TODOListsLoaded, &TODOListsMutex);
+	if(list->loaded) dropList(list, 0);
+	pthread_mutex_unlock(&TODOListsMutex);
+}
+
+unsigned long todoListArchive(struct TODOList *list, unsigned long keep) {
+	struct Buffer entries = {NULL, 0, 0};
+	struct TODOSelection selection;
+	struct TODORange range;
+	struct TODOEntry *entry;
+	unsigned long entryIndex;
+	unsigned long archived = 0;
+
+	if(!useList(list)) return 0;
+	if(list->index.count <= keep || list->doneCount == 0) {
+		releaseList(list);
+		return 0;
+	}
+
+	/* The done entries before the newest ones */
+	memset(&selection, 0, sizeof(struct TODOSelection));
+	range.first = 1;
+	range.last = list->index.count - keep;
+	selection.ranges = &range;
+	selection.count = 1;
+	selection.done = selection.intersect = 1;
+
+	writerLock(&list->writer);
+	for(entry = list->first, entryIndex = 1; entry != NULL && entryIndex <= range.last; entry = entry->next, entryIndex++) {
+		if(entry->done) serializeEntry(&entries, entry);
+	}
+
+	/* Write them into the archive before taking them out, so a crash can only leave them in both */
+	if(entries.length > 0 && appendArchive(list, &entries)) archived = removeEntries(list, &selection);
+	writerUnlock(&list->writer);
+	bufferFree(&entries);
+	if(archived > 0) {
+		/* Rewrite the list without them (Folding the journal into it) */
+		list->dirty = 1;
+		flushList(list);
+	}
+	releaseList(list);
+	if(archived == 0) return 0;
+
+	/* Load the archive view again on its next use */
+	if(list->archive != NULL) reloadList(list->archive);
+	return archived;
+}
+
+struct TODOList *todoListGetArchive(struct TODOList *list) {
+	char *filename;
+
+	if(list->archive == NULL && list->filename != NULL) {
+		if((list->archive = (struct TODOList *) malloc(sizeof(struct TODOList))) == NULL) {
+			printf("ERROR allocating the archive");
+			exit(1);
+		}
+		filename = archiveFilename(list->filename);
+		openList(list->archive, filename, NULL, 1);
+		free(filename);
+	}
+	return list->archive;
+}
+
+/**
+ *  \brief Tells whether two synced entries hold the same title
+ *
+ *  \param a The first entry
+ *  \param b The second entry
+ *
+ *  \return Whether they do
+ */
+static char isSameTitle(const struct TODOSyncedEntry *a, const struct TODOSyncedEntry *b) {
+	return a->hash == b->hash && a->titleLength == b->titleLength;
+}
+
+/**
+ *  \brief Matches entries by title in order, each one with the next unmatched one holding its title
+ *
+ *  Linear, but unlike the shortest edit script it takes a moved entry for
+ *  a deletion of all the entries it got moved over.
+ *
+ *  \param old The synced entries
+ *  \param oldCount The number of synced entries
+ *  \param current The entries of the new version
+ *  \param newCount The number of entries of the new version
+ *  \param matches Set to the index of the new entry matching each synced one (or -1)
+ */
+static void matchInOrder(const struct TODOSyncedEntry *old, long oldCount, const struct TODOSyncedEntry *current, long newCount, long *matches) {
+	/* An entry holding each title (By title hash), the first unmatched one & the next one holding the same title */
+	unsigned long mask = 1;
+	unsigned long slot;
+	long *keys;
+	long *firsts;
+	long *nexts;
+	long last = -1;
+	long i;
+
+	/* Index the new entries by title */
+	while(mask < (unsigned long) newCount * 2) mask <<= 1;
+	keys = (long *) malloc(sizeof(long) * mask);
+	firsts = (long *) malloc(sizeof(long) * mask);
+	nexts = (long *) malloc(sizeof(long) * newCount);
+	if(keys == NULL || firsts == NULL || nexts == NULL) {
+		printf("ERROR allocating the diff index");
+		exit(1);
+	}
+	for(slot = 0; slot < mask; slot++) keys[slot] = firsts[slot] = -1;
+	mask--;
+	for(i = newCount - 1; i >= 0; i--) {
+		for(slot = current[i].hash & mask; keys[slot] != -1 && !isSameTitle(current + keys[slot], current + i); slot = (slot + 1) & mask);
+		nexts[i] = firsts[slot];
+		keys[slot] = firsts[slot] = i;
+	}
+
+	/* Match each synced entry with the next new one holding its title after the last match */
+	for(i = 0; i < oldCount; i++) {
+		matches[i] = -1;
+		for(slot = old[i].hash & mask; keys[slot] != -1 && !isSameTitle(current + keys[slot], old + i); slot = (slot + 1) & mask);
+		while(firsts[slot] != -1 && firsts[slot] <= last) firsts[slot] = nexts[firsts[slot]];
+		if(firsts[slot] == -1) continue;
+		matches[i] = last = firsts[slot];
+		firsts[slot] = nexts[last];
+	}
+	free(keys);
+	free(firsts);
+	free(nexts);
+}
+
+/**
+ *  \brief Matches the entries of the synced list file with the ones of its new version
+ *
+ *  Skips the common head & tail, then finds the shortest edit script of
+ *  the rest (Myers' diff). Past SYNC_MAX_EDITS edits, the rest gets
+ *  matched in order instead.
+ *
+ *  \param old The synced entries
+ *  \param oldCount The number of synced entries
+ *  \param current The entries of the new version
+ *  \param newCount The number of entries of the new version
+ *  \param matches Set to the index of the new entry matching each synced one (or -1)
+ */
+static void diffSynced(const struct TODOSyncedEntry *old, long oldCount, const struct TODOSyncedEntry *current, long newCount, long *matches) {
+	/* The changed span */
+	long head;
+	long tail;
+	long n;
+	long m;
+
+	/* The furthest x reached on each diagonal k (At v[k + max + 1]) & its value after each round */
+	struct Buffer trace = {NULL, 0, 0};
+	const long *previous;
+	long *v;
+	long max;
+	long d;
+	long k;
+	long x;
+	long y;
+
+	/* Skip the common head & tail */
+	for(head = 0; head < oldCount && head < newCount && isSameTitle(old + head, current + head); head++) matches[head] = head;
+	for(tail = 0; tail < oldCount - head && tail < newCount - head && isSameTitle(old + oldCount - 1 - tail, current + newCount - 1 - tail); tail++) {
+		matches[oldCount - 1 - tail] = newCount - 1 - tail;
+	}
+	n = oldCount - head - tail;
+	m = newCount - head - tail;
+	for(x = 0; x < n; x++) matches[head + x] = -1;
+	if(n == 0 || m == 0) return;
+	old += head;
+	current += head;
+
+	/* Find the furthest reaching paths, one more edit per round */
+	max = n + m < SYNC_MAX_EDITS ? n + m : SYNC_MAX_EDITS;
+	if((v = (long *) calloc(2 * max + 3, sizeof(long))) == NULL) {
+		printf("ERROR allocating the diff paths");
+		exit(1);
+	}
+	for(d = 0; d <= max; d++) {
+		for(k = -d; k <= d; k += 2) {
+			x = k == -d || (k != d && v[k - 1 + max + 1] < v[k + 1 + max + 1]) ? v[k + 1 + max + 1] : v[k - 1 + max + 1] + 1;
+			for(y = x - k; x < n && y < m && isSameTitle(old + x, current + y); y++) x++;
+			v[k + max + 1] = x;
+			if(x >= n && y >= m) break;
+		}
+		if(k <= d) break;
+		bufferAppend(&trace, (const char *) v, sizeof(long) * (2 * max + 3));
+	}
+
+	/* Walk the path back, matching the entries along its diagonals */
+	if(d <= max) {
+		x = n;
+		y = m;
+		for(; d > 0; d--) {
+			previous = (const long *) trace.data + (d - 1) * (2 * max + 3) + max + 1;
+			k = x - y;
+			k = k == -d || (k != d && previous[k - 1] < previous[k + 1]) ? k + 1 : k - 1;
+			while(x > previous[k] && y > previous[k] - k) matches[head + --x] = head + --y;
+			x = previous[k];
+			y = x - k;
+		}
+		while(x > 0 && y > 0) matches[head + --x] = head + --y;
+	} else {
+		matchInOrder(old, n, current, m, matches + head);
+		for(x = 0; x < n; x++) if(matches[head + x] != -1) matches[head + x] += head;
+	}
+	bufferFree(&trace);
+	free(v);
+}
+
+/**
+ *  \brief Pushes an entry to the end of a chain
+ *
+ *  \param first The first entry of the chain
+ *  \param last The last entry of the chain
+ *  \param entry The entry
+ */
+static void chainEntry(struct TODOEntry **first, struct TODOEntry **last, struct TODOEntry *entry) {
+	entry->next = NULL;
+	if(*first == NULL) *first = entry;
+	else (*last)->next = entry;
+	*last = entry;
+}
+
+/**
+ *  \brief Takes the list entry a synced entry was read or written from
+ *         (Chaining the local entries that came before it)
+ *
+ *  \param synced The synced entry
+ *  \param entry The next list entry (Advanced past the taken ones)
+ *  \param first The first entry of the merged chain
+ *  \param last The last entry of the merged chain
+ *
+ *  \return The list entry or NULL if it got deleted
+ */
+static struct TODOEntry *takeSyncedEntry(const struct TODOSyncedEntry *synced, struct TODOEntry **entry, struct TODOEntry **first, struct TODOEntry **last) {
+	struct TODOEntry *taken;
+
+	if(synced->deleted) return NULL;
+
+	/* The ids grow along both, so the entries before it are the local ones */
+	while(*entry != NULL && (*entry)->id < synced->id) {
+		taken = *entry;
+		*entry = taken->next;
+		chainEntry(first, last, taken);
+	}
+	if(*entry == NULL || (*entry)->id != synced->id) return NULL;
+	taken = *entry;
+	*entry = taken->next;
+	return taken;
+}
+
+/**
+ *  \brief Merges the lines appended to a list file (With the writer mutex held)
+ *
+ *  \param list The TODO list
+ *  \param identity The identity of the list file
+ *  \param data The list file data
+ *  \param size The list file data size
+ *
+ *  \return Whether the list changed
+ */
+static char mergeAppended(struct TODOList *list, const struct FileIdentity *identity, const char *data, size_t size) {
+	const char *start = data + list->synced.size;
+	const char *end = data + size;
+	const char *line;
+	const char *lineEnd;
+	const char *title;
+	size_t length;
+	char done;
+	char changed = 0;
+
+	/* Parse the complete lines (A partial one gets parsed along with the rest of it) */
+	while(end > start && end[-1] != '\n') end--;
+	for(line = start; line < end; line = lineEnd + 1) {
+		lineEnd = findByte(line, end, '\n');
+		if(!parseEntryLine(line, lineEnd - line, &title, &length, &done)) continue;
+		appendEntry(list, title, length, done);
+		addSyncedEntry(&list->syncedEntries, list->last, title, length, done);
+		changed = 1;
+	}
+
+	/* Extend the synced contents with them */
+	list->synced = *identity;
+	list->synced.size = end - data;
+	list->syncedHash = hashBytes(list->syncedHash, start, end - start);
+	return changed;
+}
+
+/**
+ *  \brief Merges a new version of a list file (With the writer mutex held)
+ *
+ *  \param list The TODO list
+ *  \param identity The identity of the list file
+ *  \param data The list file data
+ *  \param size The list file data size
+ *
+ *  \return Whether the list changed
+ */
+static char mergeChanges(struct TODOList *list, const struct FileIdentity *identity, const char *data, size_t size) {
+	/* The new version */
+	struct TODOLoadSegment segment;
+	struct Buffer fileEntries = {NULL, 0, 0};
+	struct TODOEntry **entries;
+	const struct TODOSyncedEntry *old = (const struct TODOSyncedEntry *) list->syncedEntries.data;
+	struct TODOSyncedEntry *current;
+	const long oldCount = list->syncedEntries.length / sizeof(struct TODOSyncedEntry);
+	long newCount = 0;
+	long *matches;
+	const char *title;
+	size_t length;
+
+	/* The merged chain */
+	struct TODOEntry *entry = list->first;
+	struct TODOEntry *first = NULL;
+	struct TODOEntry *last = NULL;
+	struct TODOEntry *taken;
+	long i = 0;
+	long j = 0;
+	char changed = 0;
+
+	/* Parse the new version */
+	memset(&segment, 0, sizeof(struct TODOLoadSegment));
+	segment.start = parseHeader(data, data + size, &title, &length);
+	segment.end = data + size;
+	if(segment.start < segment.end) parseSegment(&segment);
+	for(taken = segment.first; taken != NULL; taken = taken->next) {
+		addSyncedEntry(&fileEntries, NULL, taken->title, taken->titleLength, taken->done);
+		newCount++;
+	}
+	current = (struct TODOSyncedEntry *) fileEntries.data;
+	entries = (struct TODOEntry **) malloc(sizeof(struct TODOEntry *) * (newCount + 1));
+	matches = (long *) malloc(sizeof(long) * (oldCount + 1));
+	if(entries == NULL || matches == NULL) {
+		printf("ERROR allocating the merged entries");
+		exit(1);
+	}
+	for(taken = segment.first; taken != NULL; taken = taken->next) entries[j++] = taken;
+
+	/* Take the new title */
+	if(title != NULL && (strlen(list->title) != length || memcmp(list->title, title, length) != 0)) {
+		free(list->title);
+		setListTitle(list, title, length);
+		changed = 1;
+	}
+
+	/* Apply the changes along the matched entries */
+	diffSynced(old, oldCount, current, newCount, matches);
+	for(j = 0; i < oldCount || j < newCount;) {
+		if(i < oldCount && matches[i] == -1) {
+			/* Deleted, unless it already was */
+			if((taken = takeSyncedEntry(old + i++, &entry, &first, &last)) == NULL) continue;
+			internRelease(&list->titles, taken->title, taken->titleLength);
+			arenaRecycleObject(&list->arena, taken);
+			changed = 1;
+		} else if(j < newCount && (i == oldCount || j < matches[i])) {
+			/* Added */
+			taken = entries[j];
+			entries[j] = newEntry(&list->arena, internTitle(&list->titles, taken->title, taken->titleLength), taken->titleLength, taken->done);
+			chainEntry(&first, &last, entries[j++]);
+			changed = 1;
+		} else {
+			/* Kept, with its new status if it got toggled (Unless it got deleted locally) */
+			if((entries[j] = taken = takeSyncedEntry(old + i, &entry, &first, &last)) != NULL) {
+				if(old[i].done != current[j].done && taken->done != current[j].done) {
+					taken->done = current[j].done;
+					changed = 1;
+				}
+				chainEntry(&first, &last, taken);
+			}
+			i++;
+			j++;
+		}
+	}
+
+	/* Keep the local entries that came after them */
+	while(entry != NULL) {
+		taken = entry;
+		entry = taken->next;
+		chainEntry(&first, &last, taken);
+	}
+
+	/* Link the merged entries again, so their ids & indices follow the new order */
+	if(changed) {
+		indexFree(&list->index);
+		searchIndexFree(&list->search);
+		list->searchBuilt = 0;
+		list->first = list->last = NULL;
+		list->doneCount = 0;
+		list->nextId = 0;
+		for(entry = first; entry != NULL; entry = taken) {
+			taken = entry->next;
+			linkEntry(list, entry);
+		}
+	}
+
+	/* The new version is the synced one now */
+	for(j = 0; j < newCount; j++) {
+		current[j].id = entries[j] != NULL ? entries[j]->id : 0;
+		current[j].deleted = entries[j] == NULL;
+	}
+	recordSynced(list, &fileEntries, identity);
+
+	arenaFree(&segment.arena);
+	free(entries);
+	free(matches);
+	return changed;
+}
+
+/**
+ *  \brief Tells whether a list file just got lines appended since it was synced
+ *
+ *  \param list The TODO list
+ *  \param identity The identity of the list file
+ *  \param data The list file data
+ *  \param size The list file data size
+ *
+ *  \return Whether it did
+ */
+static char isAppended(const struct TODOList *list, const struct FileIdentity *identity, const char *data, size_t size) {
+	/* The same file, still starting with the synced contents */
+	return list->synced.size > 0 && identity->inode == list->synced.inode && size > list->synced.size
+		&& hashBytes(2166136261UL, data, list->synced.size) == list->syncedHash;
+}
+
+char todoListSync(struct TODOList *list) {
+	struct FileIdentity identity;
+	char *data;
+	size_t size;
+	unsigned int events;
+	char pending;
+	char changed;
+
+	if(!useLoadedList(list)) return 0;
+	if((events = watchRead(&list->watch)) == 0) {
+		releaseList(list);
+		return 0;
+	}
+
+	/* Let the running save finish, its identity tells our own writes apart */
+	writerLock(&list->writer);
+	writerWait(&list->writer);
+	getFileIdentity(list->filename, &identity);
+	if(identity.inode == 0 || memcmp(&identity, &list->synced, sizeof(struct FileIdentity)) == 0) {
+		writerUnlock(&list->writer);
+		releaseList(list);
+		return 0;
+	}
+
+	/* Whether there are local changes the file doesn't hold yet */
+	pending = list->writer.pending || list->dirty || journalHasRecords(&list->journal);
+
+	/* Read it (Not mapped, as it may be written in place meanwhile) */
+	if((data = readFile(list->filename, &size)) != NULL) STATS_COUNT(STATS_BYTES_READ, size);
+	if(data != NULL && isAppended(list, &identity, data, size)) {
+		changed = mergeAppended(list, &identity, data, size);
+	} else if(data != NULL && (events & WATCH_SETTLED_EVENTS)) {
+		changed = mergeChanges(list, &identity, data, size);
+	} else {
+		/* Wait for the writer to finish it */
+		free(data);
+		writerUnlock(&list->writer);
+		releaseList(list);
+		return 0;
+	}
+	free(data);
+
+	/* The journal applies to the new file, unless it holds local changes (Then they get saved along with the merged list) */
+	if(!pending && list->journal.fd != -1) journalReset(&list->journal, list->filename);
+	writerUnlock(&list->writer);
+
+	if(pending) {
+		list->dirty = 1;
+		if(TODOListAutoSave) flushList(list);
+	}
+	releaseList(list);
+	return changed;
+}
+
+int todoListGetWatchFd(struct TODOList *list) {
+	return list->loaded ? list->watch.fd : -1;
+}
+
+/**
+ *  \brief Deletes or toggles a selection of entries & persists it once
+ *
+ *  \param list The TODO list
+ *  \param op The operation (JOURNAL_DELETE_SELECTION or JOURNAL_TOGGLE_SELECTION)
+ *  \param spec The selection
+ *
+ *  \return The number of deleted or toggled entries
+ */
+static unsigned long applySelection(struct TODOList *list, const char op, const char *spec) {
+	struct TODOSelection selection;
+	size_t length = strlen(spec);
+	unsigned long count;
+
+	spec = trimRange(spec, &length);
+	if(!parseSelection(&selection, spec, length)) return 0;
+
+	/* A single index is a plain delete or toggle */
+	if(selection.count == 1 && selection.ranges[0].first == selection.ranges[0].last && !selection.done && !selection.pending) {
+		count = selection.ranges[0].first;
+		free(selection.ranges);
+		return op == JOURNAL_DELETE_SELECTION ? todoListDelete(list, count) : todoListToggle(list, count);
+	}
+	if(!useList(list)) {
+		free(selection.ranges);
+		return 0;
+	}
+
+	writerLock(&list->writer);
+	if((count = op == JOURNAL_DELETE_SELECTION ? removeEntries(list, &selection) : flipEntries(list, &selection)) > 0) {
+		/* Persist the change (Journaling the selection itself) */
+		persistChange(list, op, 0, spec, length);
+	}
+	writerUnlock(&list->writer);
+	releaseList(list);
+	free(selection.ranges);
+	return count;
+}
+
+unsigned long todoListDeleteSelection(struct TODOList *list, const char *spec) {
+	return applySelection(list, JOURNAL_DELETE_SELECTION, spec);
+}
+
+unsigned long todoListToggleSelection(struct TODOList *list, const char *spec) {
+	return applySelection(list, JOURNAL_TOGGLE_SELECTION, spec);
+}
+
+unsigned long todoListDedupe(struct TODOList *list, size_t *bytes) {
+	unsigned long removed;
+
+	*bytes = 0;
+	if(!useList(list)) return 0;
+
+	/* Remove the duplicates */
+	writerLock(&list->writer);
+	if((removed = removeDuplicates(list, bytes)) > 0) {
+		/* Persist the change (Replaying it removes the same entries) */
+		persistChange(list, JOURNAL_DEDUPE, 0, NULL, 0);
+	}
+	writerUnlock(&list->writer);
+	releaseList(list);
+	STATS_COUNT(STATS_DEDUPED_BYTES, *bytes);
+	return removed;
+}
+
+void todoListIterate(struct TODOList *list, TODOListVisitor visit, void *data) {
+	const struct TODOEntry *entry;
+	unsigned long entryIndex = 1;
+
+	if(!useList(list)) return;
+	for(entry = list->first; entry != NULL && visit(data, entryIndex, entry); entry = entry->next) entryIndex++;
+	releaseList(list);
+}
+
+const char *todoListGetTitle(struct TODOList *list) {
+	const char *title;
+
+	if(!useList(list)) return NULL;
+	title = list->title;
+	releaseList(list);
+	return title;
+}
+
+const struct TODOEntry *todoListGetEntry(struct TODOList *list, const unsigned long entryIndex) {
+	const struct TODOEntry *entry;
+
+	if(!useList(list)) return NULL;
+	entry = (const struct TODOEntry *) indexGet(&list->index, entryIndex);
+	releaseList(list);
+	return entry;
+}
+
+unsigned long todoListGetLength(struct TODOList *list) {
+	unsigned long length;
+
+	if(!useList(list)) return 0;
+	length = list->index.count;
+	releaseList(list);
+	return length;
+}
+
+unsigned long todoListGetDoneCount(struct TODOList *list) {
+	unsigned long count;
+
+	if(!useList(list)) return 0;
+	count = list->doneCount;
+	releaseList(list);
+	return count;
+}
+
+/**
+ *  \brief Updates the entries matching the search query of a list
+ *         (If the list changed since they were found)
+ *
+ *  \param list The TODO list
+ */
+static void updateMatches(struct TODOList *list) {
+	struct TODOEntry *entry;
+
+	if(list->filter == NULL || !list->matchesStale) return;
+
+	/* Build the search index */
+	if(!list->searchBuilt) {
+		list->search.key = getEntryId;
+		for(entry = list->first; entry != NULL; entry = entry->next) searchIndexAdd(&list->search, entry->title, entry->titleLength, entry);
+		list->searchBuilt = 1;
+	}
+
+	searchIndexQuery(&list->search, list->filter, &list->matches);
+	list->matchesStale = 0;
+}
+
+void todoListFilter(struct TODOList *list, const char *query) {
+	size_t length = strlen(query);
+
+	if(!useList(list)) return;
+
+	/* Clear the current filter */
+	free(list->filter);
+	list->filter = NULL;
+	query = trimRange(query, &length);
+	if(length == 0) {
+		releaseList(list);
+		return;
+	}
+
+	/* Find the matches */
+	if((list->filter = (char *) malloc(length + 1)) == NULL) {
+		printf("ERROR allocating the list filter");
+		exit(1);
+	}
+	memcpy(list->filter, query, length);
+	list->filter[length] = '\0';
+	list->matchesStale = 1;
+	updateMatches(list);
+	releaseList(list);
+}
+
+const char *todoListGetFilter(struct TODOList *list) {
+	return list->filter;
+}
+
+unsigned long todoListGetViewLength(struct TODOList *list) {
+	unsigned long length;
+
+	if(!useList(list)) return 0;
+	if(list->filter == NULL) {
+		length = list->index.count;
+	} else {
+		updateMatches(list);
+		length = list->matches.count;
+	}
+	releaseList(list);
+	return length;
+}
+
+const struct TODOEntry *todoListGetViewEntry(struct TODOList *list, const unsigned long viewIndex, unsigned long *entryIndex) {
+	const struct TODOEntry *entry = NULL;
+
+	if(!useList(list)) return NULL;
+	if(list->filter == NULL) {
+		*entryIndex = viewIndex;
+		entry = (const struct TODOEntry *) indexGet(&list->index, viewIndex);
+	} else {
+		/* Find the position in the list of the match */
+		updateMatches(list);
+		if(viewIndex > 0 && viewIndex <= list->matches.count) {
+			*entryIndex = indexFind(&list->index, list->matches.items[viewIndex - 1], compareEntries);
+			entry = (const struct TODOEntry *) list->matches.items[viewIndex - 1];
+		}
+	}
+	releaseList(list);
+	return entry;
+}
+
+unsigned long todoListGetViewPosition(struct TODOList *list, const unsigned long entryIndex) {
+	const struct TODOEntry *entry;
+	unsigned long low = 0;
+	unsigned long high;
+	unsigned long middle;
+
+	if(!useList(list)) return entryIndex;
+	if(list->filter == NULL) {
+		releaseList(list);
+		return entryIndex;
+	}
+
+	/* Binary search the matches by id */
+	updateMatches(list);
+	high = list->matches.count;
+	if((entry = (const struct TODOEntry *) indexGet(&list->index, entryIndex)) == NULL) {
+		releaseList(list);
+		return entryIndex == 0 ? 0 : high;
+	}
+	while(low < high) {
+		middle = low + (high - low) / 2;
+		if(compareEntries(list->matches.items[middle], entry) < 0) low = middle + 1;
+		else high = middle;
+	}
+	releaseList(list);
+	return low + 1;
+}
+
+const struct TODOLoadStats *todoListGetLoadStats(struct TODOList *list) {
+	return &list->loadStats;
+}
+
+void loadTODOList(const char *filename, const char *title) {
+	openList(&TODOListDefault, filename, title, 0);
+	if(TODOListArchiveKeep > 0) todoListArchive(&TODOListDefault, TODOListArchiveKeep);
+}
+
+void saveTodoList() {
+	if(!useList(&TODOListDefault)) return;
+	todoListSave(&TODOListDefault);
+	releaseList(&TODOListDefault);
+}
+
+void flushTodoList() {
+	todoListFlush(&TODOListDefault);
+}
+
+char exportTodoList(const char *filename) {
+	return todoListExport(&TODOListDefault, filename);
+}
+
+void freeTodoList() {
+	closeList(&TODOListDefault);
+}
+
+char addNewEntry(char *userInput) {
+	return todoListAdd(&TODOListDefault, userInput + 1, strlen(userInput + 1), 0);
+}
+
+void addEntry(const char *title, char done) {
+	if(!useList(&TODOListDefault)) return;
+	writerLock(&TODOListDefault.writer);
+	appendEntry(&TODOListDefault, title, strlen(title), done);
+	writerUnlock(&TODOListDefault.writer);
+	releaseList(&TODOListDefault);
+}
+
+char deleteEntry(const unsigned long entryIndex) {
+	return todoListDelete(&TODOListDefault, entryIndex);
+}
+
+char toggleEntry(const unsigned long entryIndex) {
+	return todoListToggle(&TODOListDefault, entryIndex);
+}
+
+unsigned long deleteEntries(const char *spec) {
+	return todoListDeleteSelection(&TODOListDefault, spec);
+}
+
+unsigned long toggleEntries(const char *spec) {
+	return todoListToggleSelection(&TODOListDefault, spec);
+}
+
+unsigned long dedupeEntries(size_t *bytes) {
+	return todoListDedupe(&TODOListDefault, bytes);
+}
+
+const char *getTODOListTitle() {
+	return todoListGetTitle(&TODOListDefault);
+}
+
+const struct TODOEntry *getTODOListFirst() {
+	const struct TODOEntry *first;
+
+	if(!useList(&TODOListDefault)) return NULL;
+	first = TODOListDefault.first;
+	releaseList(&TODOListDefault);
+	return first;
+}
+
+const struct TODOEntry *getTODOListEntry(const unsigned long entryIndex) {
+	return todoListGetEntry(&TODOListDefault, entryIndex);
+}
+
+unsigned long getTODOListLength() {
+	return todoListGetLength(&TODOListDefault);
+}
+
+unsigned long getTODOListDoneCount() {
+	return todoListGetDoneCount(&TODOListDefault);
+}
+
+void filterTODOList(const char *query) {
+	todoListFilter(&TODOListDefault, query);
+}
+
+const char *getTODOListFilter() {
+	return todoListGetFilter(&TODOListDefault);
+}
+
+unsigned long getTODOListViewLength() {
+	return todoListGetViewLength(&TODOListDefault);
+}
+
+const struct TODOEntry *getTODOListViewEntry(const unsigned long viewIndex, unsigned long *entryIndex) {
+	return todoListGetViewEntry(&TODOListDefault, viewIndex, entryIndex);
+}
+
+unsigned long getTODOListViewPosition(const unsigned long entryIndex) {
+	return todoListGetViewPosition(&TODOListDefault, entryIndex);
+}
+
+struct TODOList *getTODOListDefault() {
+	return &TODOListDefault;
+}
+
+const struct TODOLoadStats *getTODOListLoadStats() {
+	return todoListGetLoadStats(&TODOListDefault);
+}
+
+void setTODOListJournalMode(char enabled) {
+	TODOListJournalMode = enabled;
+}
+
+void setTODOListAutoSave(char enabled) {
+	TODOListAutoSave = enabled;
+}
+
+void setTODOListLoadThreads(unsigned int threads) {
+	TODOListLoadThreads = threads;
+}
+
+void setTODOListFsyncPolicy(int policy) {
+	TODOListFsyncPolicy = policy;
+}
+
+void setTODOListSnapshotMode(char enabled) {
+	TODOListSnapshotMode = enabled;
+}
+
+void setTODOListMaxLoaded(unsigned long max) {
+	TODOListMaxLoaded = max;
+}
+
+void setTODOListArchiveKeep(unsigned long keep) {
+	TODOListArchiveKeep = keep;
+}
+
+void setTODOListWatchMode(char enabled) {
+	TODOListWatchMode = enabled;
+}
+
+void setTODOListSegmentMode(char enabled) {
+	TODOListSegmentMode = enabled;
 }
@@ -0,0 +1,204 @@
+/*
+	C90 TODO List
+	Copyright (C) 2015 Daniel Esteban Nombela <dani@dabuten.co>
+
+	This software is provided 'as-is', without any express or implied
+	warranty. In no event will the author be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "index.h"
+
+/**
+ *  \brief Adds a delta to a block count in the Fenwick tree
+ *
+ *  \param index The index
+ *  \param block The 0-based block number
+ *  \param delta The count delta
+ */
+static void updateCount(struct PositionIndex *index, unsigned long block, long delta) {
+	for(block++; block <= index->blocksCount; block += block & -block) index->counts[block] += delta;
+}
+
+/**
+ *  \brief Rebuilds the Fenwick tree from the block counts
+ *
+ *  \param index The index
+ */
+static void rebuildCounts(struct PositionIndex *index) {
+	unsigned long i;
+	unsigned long parent;
+
+	for(i = 1; i <= index->blocksCount; i++) index->counts[i] = index->blocks[i - 1]->count;
+	for(i = 1; i <= index->blocksCount; i++) {
+		parent = i + (i & -i);
+		if(parent <= index->blocksCount) index->counts[parent] += index->counts[i];
+	}
+}
+
+/**
+ *  \brief Drops the empty blocks & rebuilds the Fenwick tree
+ *
+ *  \param index The index
+ */
+static void compactBlocks(struct PositionIndex *index) {
+	unsigned long i;
+	unsigned long kept = 0;
+
+	for(i = 0; i < index->blocksCount; i++) {
+		if(index->blocks[i]->count == 0) free(index->blocks[i]);
+		else index->blocks[kept++] = index->blocks[i];
+	}
+	index->blocksCount = kept;
+	index->emptyBlocks = 0;
+	rebuildCounts(index);
+}
+
+/**
+ *  \brief Finds the block holding a position
+ *
+ *  \param index The index
+ *  \param position The 1-based position (Updated with the 0-based offset in the block)
+ *
+ *  \return The 0-based block number
+ */
+static unsigned long findBlock(const struct PositionIndex *index, unsigned long *position) {
+	unsigned long block = 0;
+	unsigned long step = 1;
+
+	/* Descend the Fenwick tree */
+	while(step * 2 <= index->blocksCount) step *= 2;
+	for(; step > 0; step /= 2) {
+		if(block + step <= index->blocksCount && index->counts[block + step] < *position) {
+			block += step;
+			*position -= index->counts[block];
+		}
+	}
+
+	(*position)--;
+	return block;
+}
+
+void indexAppend(struct PositionIndex *index, void *item) {
+	struct IndexBlock *block = index->blocksCount > 0 ? index->blocks[index->blocksCount - 1] : NULL;
+	unsigned long i;
+	unsigned long child;
+
+	if(block == NULL || block->count == INDEX_BLOCK_SIZE) {
+		/* Grow the block slots */
+		if(index->blocksCount == index->blocksCapacity) {
+			index->blocksCapacity = index->blocksCapacity > 0 ? index->blocksCapacity * 2 : 16;
+			index->blocks = (struct IndexBlock **) realloc(index->blocks, sizeof(struct IndexBlock *) * index->blocksCapacity);
+			index->counts = (unsigned long *) realloc(index->counts, sizeof(unsigned long) * (index->blocksCapacity + 1));
+			if(index->blocks == NULL || index->counts == NULL) {
+				printf("ERROR allocating index blocks");
+				exit(1);
+			}
+		}
+
+		/* Allocate a new block */
+		if((block = (struct IndexBlock *) malloc(sizeof(struct IndexBlock))) == NULL) {
+			printf("ERROR allocating index block");
+			exit(1);
+		}
+		block->count = 0;
+		index->blocks[index->blocksCount++] = block;
+
+		/* Its Fenwick node covers the previous blocks in its range */
+		i = index->blocksCount;
+		index->counts[i] = 0;
+		for(child = 1; child < (i & -i); child *= 2) index->counts[i] += index->counts[i - child];
+	} else if(block->count == 0 && index->emptyBlocks > 0) {
+		/* Refill the emptied last block (A new one was never counted as empty) */
+		index->emptyBlocks--;
+	}
+
+	block->items[block->count++] = item;
+	updateCount(index, index->blocksCount - 1, 1);
+	index->count++;
+}
+
+void *indexGet(const struct PositionIndex *index, unsigned long position) {
+	unsigned long block;
+
+	if(position == 0 || position > index->count) return NULL;
+	block = findBlock(index, &position);
+	return index->blocks[block]->items[position];
+}
+
+void indexRemove(struct PositionIndex *index, unsigned long position) {
+	struct IndexBlock *block;
+	unsigned long blockNumber;
+
+	if(position == 0 || position > index->count) return;
+	blockNumber = findBlock(index, &position);
+	block = index->blocks[blockNumber];
+
+	/* Shift the rest of the block */
+	memmove(block->items + position, block->items + position + 1, sizeof(void *) * (block->count - position - 1));
+	block->count--;
+	updateCount(index, blockNumber, -1);
+	index->count--;
+
+	/* Drop the empty blocks once they pile up */
+	if(block->count == 0 && ++index->emptyBlocks > index->blocksCount / 2) compactBlocks(index);
+}
+
+unsigned long indexFind(const struct PositionIndex *index, const void *item, int (*compare)(const void *, const void *)) {
+	const struct IndexBlock *block;
+	unsigned long low = 0;
+	unsigned long high = index->blocksCount;
+	unsigned long middle;
+	unsigned long probe;
+	unsigned long position = 0;
+	int comparison;
+
+	/* Find the first block whose last item isn't lower than the item */
+	while(low < high) {
+		middle = low + (high - low) / 2;
+
+		/* Probe the closest non empty block */
+		for(probe = middle; probe > low && index->blocks[probe]->count == 0; probe--);
+		block = index->blocks[probe];
+		if(block->count == 0 || compare(block->items[block->count - 1], item) < 0) low = middle + 1;
+		else high = probe;
+	}
+	if(low == index->blocksCount) return 0;
+
+	/* Binary search the block */
+	block = index->blocks[low];
+	for(middle = 0, high = block->count; middle < high;) {
+		probe = middle + (high - middle) / 2;
+		if((comparison = compare(block->items[probe], item)) == 0) {
+			/* Add the items in the previous blocks */
+			for(; low > 0; low -= low & -low) position += index->counts[low];
+			return position + probe + 1;
+		}
+		if(comparison < 0) middle = probe + 1;
+		else high = probe;
+	}
+	return 0;
+}
+
+void indexFree(struct PositionIndex *index) {
+	unsigned long i;
+
+	for(i = 0; i < index->blocksCount; i++) free(index->blocks[i]);
+	free(index->blocks);
+	free(index->counts);
+	memset(index, 0, sizeof(struct PositionIndex));
+}
@@ -0,0 +1,216 @@
+/*
+	C90 TODO List
+	Copyright (C) 2015 Daniel Esteban Nombela <dani@dabuten.co>
+
+	This software is provided 'as-is', without any express or implied
+	warranty. In no event will the author be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "intern.h"
+
+/**
+ *  \brief Hashes a title (FNV-1a)
+ *
+ *  \param title The title
+ *  \param length The title length
+ *
+ *  \return The hash
+ */
+static unsigned long hashTitle(const char *title, size_t length) {
+	unsigned long hash = 2166136261UL;
+
+	while(length-- > 0) hash = (hash ^ (unsigned char) *title++) * 16777619UL;
+	return hash;
+}
+
+/**
+ *  \brief Finds the slot of a title in the table
+ *
+ *  \param table The table
+ *  \param title The title
+ *  \param length The title length
+ *  \param hash The title hash
+ *
+ *  \return The slot holding the title or the empty slot it would go in
+ */
+static struct InternedTitle **findSlot(const struct InternTable *table, const char *title, size_t length, unsigned long hash) {
+	const unsigned long mask = table->slotsCount - 1;
+	unsigned long slot = hash & mask;
+	struct InternedTitle *interned;
+
+	while((interned = table->slots[slot]) != NULL) {
+		if(interned->hash == hash && interned->length == length && memcmp(interned->title, title, length) == 0) break;
+		slot = (slot + 1) & mask;
+	}
+	return table->slots + slot;
+}
+
+/**
+ *  \brief Doubles the title table
+ *
+ *  \param table The table
+ */
+static void growSlots(struct InternTable *table) {
+	struct InternedTitle **slots = table->slots;
+	const unsigned long slotsCount = table->slotsCount;
+	unsigned long i;
+
+	table->slotsCount = slotsCount > 0 ? slotsCount * 2 : INTERN_INITIAL_SLOTS;
+	if((table->slots = (struct InternedTitle **) calloc(table->slotsCount, sizeof(struct InternedTitle *))) == NULL) {
+		printf("ERROR allocating intern slots");
+		exit(1);
+	}
+
+	/* Rehash the titles */
+	for(i = 0; i < slotsCount; i++) {
+		if(slots[i] != NULL) *findSlot(table, slots[i]->title, slots[i]->length, slots[i]->hash) = slots[i];
+	}
+	free(slots);
+}
+
+/**
+ *  \brief Returns the size of the block holding a title
+ *
+ *  \param length The title length
+ *
+ *  \return The block size (Its size class, or the title size past the biggest class)
+ */
+static size_t getTitleSize(size_t length) {
+	const size_t size = (length + INTERN_SIZE_STEP) / INTERN_SIZE_STEP * INTERN_SIZE_STEP;
+
+	return size <= INTERN_SIZE_STEP * INTERN_SIZE_CLASSES ? size : length + 1;
+}
+
+/**
+ *  \brief Allocates the block of a title, reusing a recycled one of its class first
+ *
+ *  \param table The table
+ *  \param length The title length
+ *
+ *  \return The block
+ */
+static char *allocTitle(struct InternTable *table, size_t length) {
+	const size_t size = getTitleSize(length);
+	void **recycled;
+	char *block;
+
+	if(size > INTERN_SIZE_STEP * INTERN_SIZE_CLASSES) {
+		if((block = (char *) malloc(size)) == NULL) {
+			printf("ERROR allocating an interned title");
+			exit(1);
+		}
+		return block;
+	}
+
+	recycled = table->freeTitles + size / INTERN_SIZE_STEP - 1;
+	if((block = (char *) *recycled) != NULL) {
+		*recycled = *((void **) block);
+		return block;
+	}
+	return (char *) arenaAlloc(&table->arena, size, sizeof(void *));
+}
+
+/**
+ *  \brief Recycles the block of a title
+ *
+ *  \param table The table
+ *  \param title The title
+ *  \param length The title length
+ *
+ *  \return The block size
+ */
+static size_t freeTitle(struct InternTable *table, char *title, size_t length) {
+	const size_t size = getTitleSize(length);
+	void **recycled;
+
+	if(size > INTERN_SIZE_STEP * INTERN_SIZE_CLASSES) {
+		free(title);
+	} else {
+		recycled = table->freeTitles + size / INTERN_SIZE_STEP - 1;
+		*((void **) title) = *recycled;
+		*recycled = title;
+	}
+	return size;
+}
+
+const char *internTitle(struct InternTable *table, const char *title, size_t length) {
+	struct InternedTitle **slot;
+	struct InternedTitle *interned;
+	unsigned long hash;
+
+	if(table->titlesCount * 2 >= table->slotsCount) growSlots(table);
+	hash = hashTitle(title, length);
+	if((interned = *(slot = findSlot(table, title, length, hash))) != NULL) {
+		/* Share it */
+		STATS_COUNT(STATS_INTERNED_BYTES, length + 1);
+		interned->refs++;
+		return interned->title;
+	}
+
+	/* Add a copy */
+	interned = (struct InternedTitle *) arenaAllocObject(&table->arena, sizeof(struct InternedTitle));
+	interned->title = allocTitle(table, length);
+	memcpy(interned->title, title, length);
+	interned->title[length] = '\0';
+	interned->length = length;
+	interned->hash = hash;
+	interned->refs = 1;
+	*slot = interned;
+	table->titlesCount++;
+	return interned->title;
+}
+
+size_t internRelease(struct InternTable *table, const char *title, size_t length) {
+	const unsigned long mask = table->slotsCount - 1;
+	struct InternedTitle **slot;
+	struct InternedTitle *interned;
+	unsigned long hole;
+	unsigned long next;
+	size_t bytes;
+
+	if(table->titlesCount == 0) return 0;
+	slot = findSlot(table, title, length, hashTitle(title, length));
+	if((interned = *slot) == NULL || interned->title != title || --interned->refs > 0) return 0;
+
+	/* Take it out, moving back the titles that got probed past it */
+	hole = slot - table->slots;
+	for(next = (hole + 1) & mask; table->slots[next] != NULL; next = (next + 1) & mask) {
+		if(((next - (table->slots[next]->hash & mask)) & mask) < ((next - hole) & mask)) continue;
+		table->slots[hole] = table->slots[next];
+		hole = next;
+	}
+	table->slots[hole] = NULL;
+	table->titlesCount--;
+
+	/* Recycle its title & its struct */
+	bytes = freeTitle(table, interned->title, length) + sizeof(struct InternedTitle);
+	arenaRecycleObject(&table->arena, interned);
+	return bytes;
+}
+
+void internFree(struct InternTable *table) {
+	unsigned long i;
+
+	/* Free the titles allocated on their own */
+	for(i = 0; i < table->slotsCount; i++) {
+		if(table->slots[i] != NULL && getTitleSize(table->slots[i]->length) > INTERN_SIZE_STEP * INTERN_SIZE_CLASSES) free(table->slots[i]->title);
+	}
+	free(table->slots);
+	arenaFree(&table->arena);
+	memset(table, 0, sizeof(struct InternTable));
+}
@@ -0,0 +1,254 @@
+/*
+	C90 TODO List
+	Copyright (C) 2015 Daniel Esteban Nombela <dani@dabuten.co>
+
+	This software is provided 'as-is', without any express or implied
+	warranty. In no event will the author be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "journal.h"
+
+/**
+ *  \brief Formats the journal header
+ *
+ *  \param journal The journal
+ *  \param header The buffer to format it into (MAX_BUFFER_SIZE long)
+ *
+ *  \return The header length
+ */
+static int formatHeader(const struct Journal *journal, char *header) {
+	return sprintf(header, "%s %lu %lu %lu %lu\n", JOURNAL_MAGIC, journal->base.size,
+		journal->base.inode, journal->base.mtime, journal->base.mtimeNsec);
+}
+
+/**
+ *  \brief Writes the journal header
+ *
+ *  \param journal The journal
+ */
+static void writeHeader(struct Journal *journal) {
+	char header[MAX_BUFFER_SIZE];
+	const int length = formatHeader(journal, header);
+
+	if(write(journal->fd, header, length) != length) printf("ERROR writing to file: %s\n", journal->filename);
+	journal->size = length;
+}
+
+char *journalFilename(const char *baseFilename) {
+	char *filename = (char *) malloc(strlen(baseFilename) + sizeof(JOURNAL_EXTENSION));
+	if(filename == NULL) {
+		printf("ERROR allocating journal filename");
+		exit(1);
+	}
+	strcpy(filename, baseFilename);
+	strcat(filename, JOURNAL_EXTENSION);
+	return filename;
+}
+
+unsigned long journalReplay(const char *filename, const struct FileIdentity *base, JournalApply apply, void *data, unsigned long *validSize) {
+	/* The journal contents */
+	char *contents;
+	size_t size;
+	char mapped;
+
+	/* The record pointers */
+	const char *end;
+	const char *line;
+	const char *lineEnd;
+	const char *digit;
+	unsigned long index;
+
+	/* The header */
+	char header[MAX_BUFFER_SIZE];
+	struct FileIdentity journalBase;
+
+	/* The replayed records counter */
+	unsigned long records = 0;
+
+	*validSize = 0;
+	if((contents = mapFile(filename, &size, &mapped)) == NULL) return 0;
+	end = contents + size;
+
+	/* Check the header matches the loaded base */
+	if((lineEnd = (const char *) memchr(contents, '\n', size)) == NULL || lineEnd - contents >= MAX_BUFFER_SIZE) {
+		unmapFile(contents, size, mapped);
+		return 0;
+	}
+	memcpy(header, contents, lineEnd - contents);
+	header[lineEnd - contents] = '\0';
+	if(
+		strncmp(header, JOURNAL_MAGIC " ", sizeof(JOURNAL_MAGIC)) != 0
+		|| sscanf(header + sizeof(JOURNAL_MAGIC), "%lu %lu %lu %lu", &journalBase.size, &journalBase.inode, &journalBase.mtime, &journalBase.mtimeNsec) != 4
+		|| memcmp(&journalBase, base, sizeof(struct FileIdentity)) != 0
+	) {
+		unmapFile(contents, size, mapped);
+		return 0;
+	}
+
+	/* Replay the complete records (A torn last one gets discarded) */
+	line = lineEnd + 1;
+	while(line < end && (lineEnd = (const char *) memchr(line, '\n', end - line)) != NULL) {
+		if(JOURNAL_HAS_TEXT(*line)) {
+			apply(data, *line, 0, line + 1, lineEnd - line - 1);
+		} else {
+			for(index = 0, digit = line + 1; digit < lineEnd && isdigit((unsigned char) *digit); digit++) index = index * 10 + (*digit - '0');
+			apply(data, *line, index, NULL, 0);
+		}
+		records++;
+		line = lineEnd + 1;
+	}
+
+	*validSize = line - contents;
+	STATS_COUNT(STATS_BYTES_READ, size);
+	unmapFile(contents, size, mapped);
+	return records;
+}
+
+void journalOpen(struct Journal *journal, const char *baseFilename, unsigned long validSize, int sync) {
+	journal->filename = journalFilename(baseFilename);
+	journal->sync = sync;
+	getFileIdentity(baseFilename, &journal->base);
+
+	if((journal->fd = open(journal->filename, O_RDWR | O_CREAT | O_APPEND, 0644)) == -1) {
+		printf("ERROR opening journal: %s\n", journal->filename);
+		exit(1);
+	}
+
+	/* Keep the valid prefix or start over */
+	if(ftruncate(journal->fd, validSize) == -1) printf("ERROR truncating journal: %s\n", journal->filename);
+	if(validSize == 0) writeHeader(journal);
+	else journal->size = validSize;
+}
+
+char journalAppend(struct Journal *journal, char op, unsigned long index, const char *title, size_t length) {
+	/* The record buffers */
+	char record[MAX_BUFFER_SIZE];
+	struct iovec parts[3];
+	struct iovec *part = parts;
+	int partsCount = JOURNAL_HAS_TEXT(op) ? 3 : 1;
+	size_t recordLength;
+	ssize_t result;
+
+	if(JOURNAL_HAS_TEXT(op)) {
+		/* Op, text & line break */
+		parts[0].iov_base = &op;
+		parts[0].iov_len = 1;
+		parts[1].iov_base = (void *) title;
+		parts[1].iov_len = length;
+		parts[2].iov_base = "\n";
+		parts[2].iov_len = 1;
+		recordLength = length + 2;
+	} else {
+		/* Op & index */
+		parts[0].iov_base = record;
+		parts[0].iov_len = recordLength = sprintf(record, "%c%lu\n", op, index);
+	}
+
+	/* Write the whole record (Going on after a short write) */
+	while(partsCount > 0) {
+		if((result = writev(journal->fd, part, partsCount)) == -1) {
+			if(errno == EINTR) continue;
+			break;
+		}
+		for(; partsCount > 0 && (size_t) result >= part->iov_len; part++, partsCount--) result -= part->iov_len;
+		if(partsCount > 0) {
+			part->iov_base = (char *) part->iov_base + result;
+			part->iov_len -= result;
+		}
+	}
+
+	/* Leave no torn record behind */
+	if(partsCount > 0 || (journal->sync == WRITE_SYNC_ALL && fdatasync(journal->fd) == -1)) {
+		printf("ERROR writing to file: %s\n", journal->filename);
+		if(ftruncate(journal->fd, journal->size) == -1) printf("ERROR truncating journal: %s\n", journal->filename);
+		return 0;
+	}
+	journal->size += recordLength;
+	STATS_COUNT(STATS_BYTES_WRITTEN, recordLength);
+	return 1;
+}
+
+char journalNeedsCompaction(const struct Journal *journal) {
+	return journal->size >= JOURNAL_COMPACT_MIN_SIZE && journal->size * JOURNAL_COMPACT_RATIO >= journal->base.size;
+}
+
+char journalHasRecords(const struct Journal *journal) {
+	char header[MAX_BUFFER_SIZE];
+
+	return journal->fd != -1 && journal->size > (unsigned long) formatHeader(journal, header);
+}
+
+void journalReset(struct Journal *journal, const char *baseFilename) {
+	journalRebase(journal, baseFilename, journal->size);
+}
+
+void journalRebase(struct Journal *journal, const char *baseFilename, unsigned long offset) {
+	/* The new journal: the header & the records appended after the offset */
+	const size_t tailLength = offset < journal->size ? journal->size - offset : 0;
+	struct Journal rebased = *journal;
+	struct Buffer buffer = {NULL, 0, 0};
+	char header[MAX_BUFFER_SIZE];
+	char *tail = NULL;
+	size_t readLength = 0;
+	ssize_t result;
+	int fd;
+
+	if(tailLength > 0) {
+		if((tail = (char *) malloc(tailLength)) == NULL) {
+			printf("ERROR allocating journal tail");
+			exit(1);
+		}
+		while(readLength < tailLength && (result = pread(journal->fd, tail + readLength, tailLength - readLength, offset + readLength)) > 0) readLength += result;
+		if(readLength < tailLength) {
+			/* Keep the current one, rather than dropping records */
+			printf("ERROR reading journal: %s\n", journal->filename);
+			free(tail);
+			return;
+		}
+	}
+
+	/* On top of the new base file */
+	getFileIdentity(baseFilename, &rebased.base);
+	bufferAppend(&buffer, header, formatHeader(&rebased, header));
+	if(readLength > 0) bufferAppend(&buffer, tail, readLength);
+	free(tail);
+
+	/* Write it next to the current one & replace it */
+	rebased.size = buffer.length;
+	STATS_COUNT(STATS_BYTES_WRITTEN, buffer.length);
+	if(!writeFileAtomically(journal->filename, &buffer, journal->sync)) {
+		printf("ERROR writing to file: %s\n", journal->filename);
+	} else if((fd = open(journal->filename, O_RDWR | O_APPEND)) == -1) {
+		printf("ERROR opening journal: %s\n", journal->filename);
+	} else {
+		close(journal->fd);
+		*journal = rebased;
+		journal->fd = fd;
+	}
+	bufferFree(&buffer);
+}
+
+void journalClose(struct Journal *journal) {
+	/* Remove it if everything got folded into the base file */
+	if(journal->fd != -1 && !journalHasRecords(journal)) unlink(journal->filename);
+
+	if(journal->fd != -1) close(journal->fd);
+	free(journal->filename);
+	journal->fd = -1;
+	journal->filename = NULL;
+}
@@ -23,21 +23,431 @@
 
 #include "lib.h"
 
+/**
+ *  \brief The whitespace bytes (As isspace in the C locale), as bits from '\t' to ' '
+ */
+#define SPACE_BITS 0x80001FUL
+
+/**
+ *  \brief Tells whether a byte is whitespace
+ *
+ *  With a bits lookup, as a compare per whitespace byte would mispredict
+ *  on indentation mixing up spaces & tabs.
+ */
+#define IS_SPACE(c) ((unsigned char) ((c) - '\t') <= ' ' - '\t' && (SPACE_BITS >> (unsigned char) ((c) - '\t')) & 1)
+
+/**
+ *  \brief Finds a byte with the C library memchr
+ */
+static const char *findByteScalar(const char *str, const char *end, const char byte) {
+	const char *found = (const char *) memchr(str, byte, end - str);
+	return found != NULL ? found : end;
+}
+
+/**
+ *  \brief Skips the leading whitespace a byte at a time
+ */
+static const char *skipSpacesScalar(const char *str, const char *end) {
+	while(str < end && IS_SPACE(*str)) str++;
+	return str;
+}
+
+/**
+ *  \brief Skips the trailing whitespace a byte at a time
+ */
+static const char *skipTrailingSpacesScalar(const char *str, const char *end) {
+	while(end > str && IS_SPACE(*(end - 1))) end--;
+	return end;
+}
+
+#ifdef SCAN_KERNELS_X86
+
+/**
+ *  \brief Returns the mask of the whitespace bytes of a 16 bytes block
+ */
+__attribute__((target("sse2"))) static int spaceMaskSSE2(const char *str) {
+	const __m128i block = _mm_loadu_si128((const __m128i *) str);
+	const __m128i control = _mm_sub_epi8(block, _mm_set1_epi8('\t'));
+
+	/* A space or a byte in the \t to \r range (min(x, 4) == x, as there's no unsigned compare) */
+	return _mm_movemask_epi8(_mm_or_si128(
+		_mm_cmpeq_epi8(block, _mm_set1_epi8(' ')),
+		_mm_cmpeq_epi8(_mm_min_epu8(control, _mm_set1_epi8('\r' - '\t')), control)
+	));
+}
+
+/**
+ *  \brief Finds a byte 16 bytes at a time
+ */
+__attribute__((target("sse2"))) static const char *findByteSSE2(const char *str, const char *end, const char byte) {
+	const __m128i needle = _mm_set1_epi8(byte);
+	int mask;
+
+	if(end - str < 16) return findByteScalar(str, end, byte);
+	for(;; str += 16) {
+		/* The last block overlaps the previous one (Instead of a bytewise tail) */
+		if(end - str < 16) str = end - 16;
+		mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) str), needle));
+		if(mask != 0) return str + __builtin_ctz(mask);
+		if(str == end - 16) return end;
+	}
+}
+
+/**
+ *  \brief Skips the leading whitespace 16 bytes at a time
+ */
+__attribute__((target("sse2"))) static const char *skipSpacesSSE2(const char *str, const char *end) {
+	int mask;
+
+	if(end - str < 16) return skipSpacesScalar(str, end);
+	for(;; str += 16) {
+		if(end - str < 16) str = end - 16;
+		if((mask = ~spaceMaskSSE2(str) & 0xFFFF) != 0) return str + __builtin_ctz(mask);
+		if(str == end - 16) return end;
+	}
+}
+
+/**
+ *  \brief Skips the trailing whitespace 16 bytes at a time
+ */
+__attribute__((target("sse2"))) static const char *skipTrailingSpacesSSE2(const char *str, const char *end) {
+	int mask;
+
+	if(end - str < 16) return skipTrailingSpacesScalar(str, end);
+	for(;; end -= 16) {
+		if(end - str < 16) end = str + 16;
+
+		/* The new end is right after the highest non whitespace byte */
+		if((mask = ~spaceMaskSSE2(end - 16) & 0xFFFF) != 0) return end - 16 + 32 - __builtin_clz(mask);
+		if(end == str + 16) return str;
+	}
+}
+
+/**
+ *  \brief Returns the mask of the whitespace bytes of a 32 bytes block
+ */
+__attribute__((target("avx2"))) static unsigned int spaceMaskAVX2(const char *str) {
+	const __m256i block = _mm256_loadu_si256((const __m256i *) str);
+	const __m256i control = _mm256_sub_epi8(block, _mm256_set1_epi8('\t'));
+
+	return (unsigned int) _mm256_movemask_epi8(_mm256_or_si256(
+		_mm256_cmpeq_epi8(block, _mm256_set1_epi8(' ')),
+		_mm256_cmpeq_epi8(_mm256_min_epu8(control, _mm256_set1_epi8('\r' - '\t')), control)
+	));
+}
+
+/**
+ *  \brief Finds a byte 32 bytes at a time
+ */
+__attribute__((target("avx2"))) static const char *findByteAVX2(const char *str, const char *end, const char byte) {
+	const __m256i needle = _mm256_set1_epi8(byte);
+	unsigned int mask;
+
+	if(end - str < 32) return findByteSSE2(str, end, byte);
+	for(;; str += 32) {
+		if(end - str < 32) str = end - 32;
+		mask = (unsigned int) _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *) str), needle));
+		if(mask != 0) return str + __builtin_ctz(mask);
+		if(str == end - 32) return end;
+	}
+}
+
+/**
+ *  \brief Skips the leading whitespace 32 bytes at a time
+ */
+__attribute__((target("avx2"))) static const char *skipSpacesAVX2(const char *str, const char *end) {
+	unsigned int mask;
+
+	if(end - str < 32) return skipSpacesSSE2(str, end);
+	for(;; str += 32) {
+		if(end - str < 32) str = end - 32;
+		if((mask = ~spaceMaskAVX2(str)) != 0) return str + __builtin_ctz(mask);
+		if(str == end - 32) return end;
+	}
+}
+
+/**
+ *  \brief Skips the trailing whitespace 32 bytes at a time
+ */
+__attribute__((target("avx2"))) static const char *skipTrailingSpacesAVX2(const char *str, const char *end) {
+	unsigned int mask;
+
+	if(end - str < 32) return skipTrailingSpacesSSE2(str, end);
+	for(;; end -= 32) {
+		if(end - str < 32) end = str + 32;
+		if((mask = ~spaceMaskAVX2(end - 32)) != 0) return end - 32 + 32 - __builtin_clz(mask);
+		if(end == str + 32) return str;
+	}
+}
+
+#endif /* SCAN_KERNELS_X86 */
+
+/** The selected scanning kernels **/
+static struct ScanKernels scanKernels = {findByteScalar, skipSpacesScalar, skipTrailingSpacesScalar};
+
+int setScanKernels(int kernels) {
+#ifdef SCAN_KERNELS_X86
+	/* Lower the kernels to the ones the CPU supports */
+	__builtin_cpu_init();
+	if(kernels >= SCAN_KERNELS_AVX2 && !__builtin_cpu_supports("avx2")) kernels = SCAN_KERNELS_SSE2;
+	if(kernels >= SCAN_KERNELS_SSE2 && !__builtin_cpu_supports("sse2")) kernels = SCAN_KERNELS_SCALAR;
+
+	switch(kernels) {
+		case SCAN_KERNELS_AVX2:
+			scanKernels.findByte = findByteAVX2;
+			scanKernels.skipSpaces = skipSpacesAVX2;
+			scanKernels.skipTrailingSpaces = skipTrailingSpacesAVX2;
+		return kernels;
+		case SCAN_KERNELS_SSE2:
+			scanKernels.findByte = findByteSSE2;
+			scanKernels.skipSpaces = skipSpacesSSE2;
+			scanKernels.skipTrailingSpaces = skipTrailingSpacesSSE2;
+		return kernels;
+	}
+#endif
+
+	scanKernels.findByte = findByteScalar;
+	scanKernels.skipSpaces = skipSpacesScalar;
+	scanKernels.skipTrailingSpaces = skipTrailingSpacesScalar;
+	return SCAN_KERNELS_SCALAR;
+}
+
+/**
+ *  \brief Selects the widest scanning kernels the CPU supports (At startup)
+ */
+__attribute__((constructor)) static void selectScanKernels() {
+	setScanKernels(SCAN_KERNELS_AVX2);
+}
+
 char *trim(char *str) {
-	char *end;
+	size_t length = strlen(str);
 
-	/* Trim leading space */
-	while(isspace(*str)) str++;
+	/* Trim the range & write the new null terminator */
+	str = (char *) trimRange(str, &length);
+	str[length] = '\0';
 
-	/* All spaces? */
-	if(*str == 0) return str;
+	return str;
+}
 
-	/* Trim trailing space */
-	end = str + strlen(str) - 1;
-	while(end > str && isspace(*end)) end--;
+const char *trimRange(const char *str, size_t *length) {
+	const char *end = str + *length;
 
-	/* Write new null terminator */
-	*(end + 1) = 0;
+	/* Trim leading space (Most ranges have none, so check the first byte before calling the kernel) */
+	if(str < end && IS_SPACE(*str)) str = scanKernels.skipSpaces(str, end);
 
+	/* Trim trailing space */
+	if(end > str && IS_SPACE(*(end - 1))) end = scanKernels.skipTrailingSpaces(str, end);
+
+	*length = end - str;
 	return str;
 }
+
+const char *findByte(const char *str, const char *end, const char byte) {
+	return scanKernels.findByte(str, end, byte);
+}
+
+void getFileIdentity(const char *filename, struct FileIdentity *identity) {
+	struct stat status;
+
+	memset(identity, 0, sizeof(struct FileIdentity));
+	if(stat(filename, &status) == -1) return;
+	identity->size = status.st_size;
+	identity->inode = status.st_ino;
+	identity->mtime = status.st_mtim.tv_sec;
+	identity->mtimeNsec = status.st_mtim.tv_nsec;
+}
+
+void bufferAppend(struct Buffer *buffer, const char *data, size_t length) {
+	char *resized;
+
+	/* Grow the buffer */
+	if(buffer->length + length > buffer->capacity) {
+		buffer->capacity = buffer->capacity > 0 ? buffer->capacity * 2 : LOAD_BLOCK_SIZE;
+		while(buffer->length + length > buffer->capacity) buffer->capacity *= 2;
+		if((resized = (char *) realloc(buffer->data, buffer->capacity)) == NULL) {
+			printf("ERROR allocating buffer");
+			exit(1);
+		}
+		buffer->data = resized;
+	}
+
+	memcpy(buffer->data + buffer->length, data, length);
+	buffer->length += length;
+}
+
+char bufferFlush(struct Buffer *buffer, int fd) {
+	struct pollfd poller;
+	size_t written = 0;
+	ssize_t result = 0;
+
+	while(written < buffer->length) {
+		if((result = write(fd, buffer->data + written, buffer->length - written)) == -1) {
+			if(errno == EINTR) continue;
+			if(errno != EAGAIN && errno != EWOULDBLOCK) break;
+
+			/* Wait for a non-blocking fd to take more */
+			poller.fd = fd;
+			poller.events = POLLOUT;
+			if(poll(&poller, 1, -1) == -1 && errno != EINTR) break;
+			continue;
+		}
+		written += result;
+	}
+
+	buffer->length = 0;
+	return result != -1;
+}
+
+/**
+ *  \brief Flushes the directory entries of a file to the disk
+ *
+ *  \param filename The filename
+ */
+static void syncDirectory(const char *filename) {
+	const char *slash = strrchr(filename, '/');
+	char *directory;
+	int fd;
+
+	if(slash == NULL) {
+		directory = NULL;
+	} else {
+		if((directory = (char *) malloc(slash - filename + 2)) == NULL) {
+			printf("ERROR allocating directory name");
+			exit(1);
+		}
+		memcpy(directory, filename, slash - filename + 1);
+		directory[slash - filename + 1] = '\0';
+	}
+
+	if((fd = open(directory != NULL ? directory : ".", O_RDONLY)) != -1) {
+		fsync(fd);
+		close(fd);
+	}
+	free(directory);
+}
+
+char writeFileAtomically(const char *filename, struct Buffer *buffer, const int sync) {
+	char *tempFilename = (char *) malloc(strlen(filename) + 5);
+	struct stat status;
+	int fd;
+	char written = 0;
+
+	if(tempFilename == NULL) {
+		printf("ERROR allocating temp filename");
+		exit(1);
+	}
+	sprintf(tempFilename, "%s.tmp", filename);
+
+	/* Write the temp file (With the permissions of the one it replaces) */
+	if((fd = open(tempFilename, O_WRONLY | O_CREAT | O_TRUNC, stat(filename, &status) == 0 ? status.st_mode & 07777 : 0666)) != -1) {
+		written = bufferFlush(buffer, fd);
+		if(written && sync != WRITE_SYNC_NONE) written = fsync(fd) == 0;
+		if(close(fd) == -1) written = 0;
+
+		/* Replace the file */
+		if(written) written = rename(tempFilename, filename) == 0;
+		if(!written) unlink(tempFilename);
+	}
+	buffer->length = 0;
+	if(written && sync == WRITE_SYNC_ALL) syncDirectory(filename);
+
+	free(tempFilename);
+	return written;
+}
+
+void syncFile(const char *filename) {
+	int fd;
+
+	if((fd = open(filename, O_RDONLY)) != -1) {
+		fsync(fd);
+		close(fd);
+	}
+	syncDirectory(filename);
+}
+
+void bufferFree(struct Buffer *buffer) {
+	free(buffer->data);
+	buffer->data = NULL;
+	buffer->length = buffer->capacity = 0;
+}
+
+double getMonotonicTime() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/**
+ *  \brief Reads a whole file in large blocks into the heap
+ *
+ *  \param fd The file descriptor (Gets closed)
+ *  \param size Set to the file size
+ *
+ *  \return The file data
+ */
+static char *readBlocks(int fd, size_t *size) {
+	/* The read buffer */
+	char *data;
+	char *resized;
+	size_t capacity = LOAD_BLOCK_SIZE;
+	ssize_t readBytes;
+
+	*size = 0;
+	if((data = (char *) malloc(capacity)) == NULL) {
+		printf("ERROR allocating the read buffer");
+		exit(1);
+	}
+	while((readBytes = read(fd, data + *size, capacity - *size)) > 0) {
+		*size += readBytes;
+		if(*size == capacity) {
+			capacity *= 2;
+			if((resized = (char *) realloc(data, capacity)) == NULL) {
+				printf("ERROR allocating the read buffer");
+				exit(1);
+			}
+			data = resized;
+		}
+	}
+	close(fd);
+	return data;
+}
+
+char *mapFile(const char *filename, size_t *size, char *mapped) {
+	/* The file descriptor & status */
+	int fd;
+	struct stat status;
+
+	/* The mapped file */
+	char *data;
+
+	/* Open the file */
+	if((fd = open(filename, O_RDONLY)) == -1) return NULL;
+
+	/* Try to map it */
+	if(fstat(fd, &status) == 0 && S_ISREG(status.st_mode) && status.st_size > 0) {
+		data = (char *) mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(data != MAP_FAILED) {
+			madvise(data, status.st_size, MADV_SEQUENTIAL);
+			close(fd);
+			*size = status.st_size;
+			*mapped = 1;
+			return data;
+		}
+	}
+
+	/* Fallback to reading it in blocks */
+	*mapped = 0;
+	return readBlocks(fd, size);
+}
+
+char *readFile(const char *filename, size_t *size) {
+	int fd;
+
+	if((fd = open(filename, O_RDONLY)) == -1) return NULL;
+	return readBlocks(fd, size);
+}
+
+void unmapFile(char *data, size_t size, char mapped) {
+	if(mapped) munmap(data, size);
+	else free(data);
+}
@@ -27,20 +27,54 @@
  *  Main file for the C90 TODO List
  */
 
-/* Using CType, Signals, Standard I/O & Strings */
+/* Using CType, Errors, Signals, Standard lib, Standard I/O, Strings, POSIX, Poll, Sockets & Signalfd */
 #include <ctype.h>
+#include <errno.h>
 #include <signal.h>
+#include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/signalfd.h>
 
 #include "data.h"
 #include "lib.h"
 #include "render.h"
+#include "server.h"
+#include "stats.h"
+
+/**
+ *  \brief Command result constants
+ */
+enum COMMAND_RESULTS {
+	COMMAND_IGNORED,
+	COMMAND_APPLIED,
+	COMMAND_QUIT
+};
+
+/**
+ *  \brief Reports the load throughput of the TODO list
+ *         (If TODO_LOAD_STATS is set)
+ */
+void reportLoadStats() {
+	const struct TODOLoadStats *stats;
+
+	if(getenv("TODO_LOAD_STATS") == NULL) return;
+	stats = getTODOListLoadStats();
+	fprintf(stderr, "Loaded %lu bytes in %.3fms (%.2f MB/s)\n", stats->bytes, stats->seconds * 1000,
+		stats->seconds > 0 ? stats->bytes / stats->seconds / 1048576 : 0);
+}
 
 /**
  *  \brief At exit handler
  */
 void atExit() {
+	/* Wait for the pending saves */
+	flushTodoList();
+
 	/* Free the memory */
 	freeTodoList();
 
@@ -52,26 +86,453 @@ void atExit() {
 
 	/* Clear the screen */
 	CLEAR_SCREEN();
+
+	/* Write the instrumentation report (if enabled) */
+	statsReport();
+
+	/* Report the load throughput (if requested) */
+	reportLoadStats();
 }
 
 /**
- *  \brief Signals handler
- *  \param sig The signal ID
+ *  \brief Processes a command
+ *
+ *  \param userInput The command (Without the trailing '\n' character)
+ *
+ *  \return The command result
  */
-void signalsHandler(int sig) {
-	switch(sig) {
-		case SIGWINCH:
-			/* Update the window size */
-			updateWindowSize();
+int processCommand(char *userInput) {
+	/* The list on the screen (The list or its archive) */
+	struct TODOList *list = getRenderList();
 
-			/* Re-Render the GUI */
-			render();
+	/* The command result */
+	int result = COMMAND_IGNORED;
+
+	/* The removed duplicates & the memory they gave back */
+	unsigned long removed;
+	size_t bytes;
+	char notice[96];
+
+	/* The dispatch start time */
+	const double statsStart = statsBegin();
+
+	/* The notice of the previous command goes away */
+	setRenderNotice(NULL);
+
+	switch(toupper(userInput[0])) {
+		case 'Q':
+			result = COMMAND_QUIT;
+		break;
+		case 'A':
+			if(todoListAdd(list, userInput + 1, strlen(userInput + 1), 0)) {
+				scrollTo(todoListGetLength(list));
+				result = COMMAND_APPLIED;
+			}
+		break;
+		case 'D':
+			if(todoListDeleteSelection(list, userInput + 1) > 0) result = COMMAND_APPLIED;
+		break;
+		case 'H':
+			toggleHelp();
+		break;
+		case 'N':
+			scrollPage(1);
+		break;
+		case 'P':
+			scrollPage(-1);
+		break;
+		case 'J':
+			scrollTo(strtoul(userInput + 1, NULL, 10));
+		break;
+		case 'S':
+			/* Filter the list & scroll to the first match */
+			todoListFilter(list, userInput + 1);
+			scrollTo(1);
+		break;
+		case 'U':
+			/* Remove the duplicates & tell the memory they gave back */
+			if((removed = todoListDedupe(list, &bytes)) > 0) result = COMMAND_APPLIED;
+			sprintf(notice, "Removed %lu duplicates (%lu bytes freed)", removed, (unsigned long) bytes);
+			setRenderNotice(notice);
 		break;
-		case SIGINT:
-			/* Gracefully exit the program */
-			exit(0);
+		case 'V':
+			/* Switch between the list & its archive */
+			setRenderList(list == getTODOListDefault() ? todoListGetArchive(list) : NULL);
 		break;
+		case '\033':
+			/* Page Up / Page Down keys */
+			if(strncmp(userInput, "\033[5~", 4) == 0) scrollPage(-1);
+			else if(strncmp(userInput, "\033[6~", 4) == 0) scrollPage(1);
+		break;
+		default:
+			if(todoListToggleSelection(list, userInput) > 0) result = COMMAND_APPLIED;
+		break;
+	}
+
+	statsEnd(STATS_COMMAND, statsStart);
+	return result;
+}
+
+/**
+ *  \brief Reads a command line from a file
+ *
+ *  \param file The file
+ *  \param userInput The user input buffer (MAX_BUFFER_SIZE bytes)
+ *
+ *  \return Whether a line was read
+ */
+char readCommand(FILE *file, char *userInput) {
+	size_t length;
+
+	if(fgets(userInput, MAX_BUFFER_SIZE, file) == NULL) return 0;
+
+	/* Remove the trailing line break */
+	length = strlen(userInput);
+	while(length > 0 && (userInput[length - 1] == '\n' || userInput[length - 1] == '\r')) userInput[--length] = '\0';
+	return 1;
+}
+
+/**
+ *  \brief Runs the commands from a file in batch mode
+ *
+ *  \param file The file
+ *  \param stats The batch stats (applied, ignored)
+ *
+ *  \return Whether a quit command was found
+ */
+char runBatchFile(FILE *file, unsigned long *stats) {
+	char userInput[MAX_BUFFER_SIZE];
+	int result;
+
+	while(readCommand(file, userInput)) {
+		if((result = processCommand(userInput)) == COMMAND_QUIT) return 1;
+		stats[result]++;
+	}
+	return 0;
+}
+
+/**
+ *  \brief Runs the full command lines of the user input
+ *
+ *  \param input The user input (The incomplete last line is kept)
+ *  \param flush Whether to run the last line too, even if it isn't terminated
+ *
+ *  \return Whether a quit command was found
+ */
+char runInputLines(struct Buffer *input, char flush) {
+	char *line = input->data;
+	char *end = input->data + input->length;
+	char *lineEnd;
+
+	while(line < end) {
+		if((lineEnd = (char *) findByte(line, end, '\n')) == end && !flush) break;
+
+		/* Remove the trailing line break */
+		*lineEnd = '\0';
+		if(lineEnd > line && lineEnd[-1] == '\r') lineEnd[-1] = '\0';
+		if(processCommand(line) == COMMAND_QUIT) return 1;
+		line = lineEnd + 1;
 	}
+
+	/* Keep the incomplete line for the next read */
+	input->length = line < end ? (size_t) (end - line) : 0;
+	if(input->length > 0) memmove(input->data, line, input->length);
+	return 0;
+}
+
+/**
+ *  \brief Runs the interactive mode event loop
+ *
+ *  Polls stdin & a signalfd, so the signals get handled on the loop instead
+ *  of in an async handler. A burst of resizes gets coalesced: the window
+ *  size is read & the GUI re-rendered at most once per RESIZE_RENDER_INTERVAL,
+ *  however many SIGWINCH arrive. The input gets rendered once per read.
+ *  The changes other processes make to the list file get merged & rendered
+ *  as the watch of the list reports them.
+ *
+ *  \param signals The signalfd (For SIGWINCH & SIGINT)
+ */
+void runEventLoop(int signals) {
+	/* The polled descriptors */
+	struct pollfd fds[3];
+
+	/* The received signal */
+	struct signalfd_siginfo info;
+
+	/* The user input */
+	struct Buffer input = {NULL, 0, 0};
+	char data[LOAD_BLOCK_SIZE];
+	ssize_t result;
+
+	/* The loop state */
+	double lastRender = 0;
+	double now;
+	int timeout;
+	char resizing = 0;
+	char dirty = 1;
+	char quit = 0;
+
+	fds[0].fd = 0;
+	fds[0].events = POLLIN;
+	fds[1].fd = signals;
+	fds[1].events = POLLIN;
+	fds[2].events = POLLIN;
+
+	while(!quit) {
+		/* Render the GUI (Along with the pending resize, once its interval is over) */
+		now = getMonotonicTime();
+		if(resizing && (dirty || now >= lastRender + RESIZE_RENDER_INTERVAL)) {
+			updateWindowSize();
+			resizing = 0;
+			dirty = 1;
+		}
+		if(dirty) {
+			render();
+			lastRender = now;
+			dirty = 0;
+		}
+
+		/* Wait for the input, the signals, the list file changes or the end of the resize interval */
+		timeout = resizing ? (int) ((lastRender + RESIZE_RENDER_INTERVAL - now) * 1000) + 1 : -1;
+		fds[2].fd = todoListGetWatchFd(getTODOListDefault());
+		if(poll(fds, 3, timeout) == -1) {
+			if(errno == EINTR) continue;
+			break;
+		}
+
+		/* Handle the signals */
+		if(fds[1].revents & POLLIN) {
+			while(read(signals, &info, sizeof(struct signalfd_siginfo)) == sizeof(struct signalfd_siginfo)) {
+				if(info.ssi_signo == SIGINT) quit = 1;
+				else if(info.ssi_signo == SIGWINCH) resizing = 1;
+			}
+		}
+
+		/* Merge the changes made to the list file by other processes */
+		if(fds[2].fd != -1 && (fds[2].revents & POLLIN) && todoListSync(getTODOListDefault())) dirty = 1;
+
+		/* Run the user input (It's ready, so the read doesn't block) */
+		if(!quit && fds[0].revents) {
+			if((result = read(0, data, LOAD_BLOCK_SIZE)) > 0) {
+				bufferAppend(&input, data, result);
+				quit = runInputLines(&input, 0);
+				dirty = 1;
+			} else if(result == 0 || (errno != EINTR && errno != EAGAIN)) {
+				/* Run the last line & quit at the end of the input */
+				runInputLines(&input, 1);
+				quit = 1;
+			}
+		}
+	}
+
+	bufferFree(&input);
+}
+
+/**
+ *  \brief Runs the commands in batch mode
+ *
+ *  Applies all the commands in memory, without rendering,
+ *  and saves the TODO list once at the end.
+ *
+ *  \param commands The -c commands
+ *  \param commandsCount The number of -c commands
+ *  \param script The script filename (or NULL)
+ *  \param readStdin Whether to read commands from stdin
+ *
+ *  \return The application exit status code
+ */
+int runBatch(char **commands, int commandsCount, const char *script, char readStdin) {
+	/* The applied & ignored commands counters */
+	unsigned long stats[2] = {0, 0};
+
+	/* The quit flag */
+	char quit = 0;
+
+	/* The script file */
+	FILE *file;
+
+	/* The run start time */
+	const double startTime = getMonotonicTime();
+
+	/* Apply everything in memory */
+	setTODOListAutoSave(0);
+
+	/* Run the -c commands */
+	for(; !quit && commandsCount > 0; commands++, commandsCount--) {
+		int result = processCommand(*commands);
+		if(result == COMMAND_QUIT) quit = 1;
+		else stats[result]++;
+	}
+
+	/* Run the script */
+	if(!quit && script != NULL) {
+		if((file = fopen(script, "r")) == NULL) {
+			fprintf(stderr, "ERROR reading file: %s\n", script);
+			freeTodoList();
+			return 1;
+		}
+		quit = runBatchFile(file, stats);
+		fclose(file);
+	}
+
+	/* Run the commands from stdin */
+	if(!quit && readStdin) runBatchFile(stdin, stats);
+
+	/* Save the TODO list once */
+	flushTodoList();
+	reportLoadStats();
+	freeTodoList();
+
+	/* Print the summary */
+	printf("{\"applied\":%lu,\"ignored\":%lu,\"seconds\":%.6f}\n", stats[COMMAND_APPLIED], stats[COMMAND_IGNORED], getMonotonicTime() - startTime);
+
+	/* Write the instrumentation report (if enabled) */
+	statsReport();
+	return 0;
+}
+
+/**
+ *  \brief Sends the queued commands to the server & empties the request
+ *
+ *  Reads the replies while sending, as the server holds the commands
+ *  back until the replies get read.
+ *
+ *  \param request The request buffer
+ *  \param replies The buffer the replies get appended to
+ *  \param fd The server socket
+ */
+void sendRequest(struct Buffer *request, struct Buffer *replies, int fd) {
+	struct pollfd poller;
+	char data[SERVER_READ_SIZE];
+	size_t offset = 0;
+	ssize_t result;
+
+	poller.fd = fd;
+	poller.events = POLLIN | POLLOUT;
+	while(offset < request->length) {
+		if(poll(&poller, 1, -1) == -1) {
+			if(errno == EINTR) continue;
+			break;
+		}
+
+		if(poller.revents & POLLIN) {
+			/* The server is gone if it closed the connection */
+			if((result = read(fd, data, SERVER_READ_SIZE)) == 0) break;
+			if(result > 0) bufferAppend(replies, data, result);
+		}
+
+		if(poller.revents & (POLLOUT | POLLERR | POLLHUP)) {
+			if((result = send(fd, request->data + offset, request->length - offset, MSG_DONTWAIT | MSG_NOSIGNAL)) == -1) {
+				if(errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK) break;
+			} else {
+				offset += result;
+			}
+		}
+	}
+	request->length = 0;
+}
+
+/**
+ *  \brief Queues a command for the server
+ *
+ *  \param request The request buffer
+ *  \param replies The buffer the replies get appended to
+ *  \param command The command (Without the trailing '\n' character)
+ *  \param fd The server socket (The request gets sent once it's big enough)
+ *
+ *  \return Whether it was a quit command
+ */
+char queueCommand(struct Buffer *request, struct Buffer *replies, const char *command, int fd) {
+	bufferAppend(request, command, strlen(command));
+	bufferAppend(request, "\n", 1);
+	if(request->length >= SERVER_READ_SIZE) sendRequest(request, replies, fd);
+	return toupper(command[0]) == 'Q';
+}
+
+/**
+ *  \brief Forwards the commands to a server
+ *
+ *  Pipelines all the commands, reading the replies as they come,
+ *  so the whole batch takes a single round trip.
+ *
+ *  \param socketPath The server socket path
+ *  \param filename The TODO list filename
+ *  \param commands The -c commands
+ *  \param commandsCount The number of -c commands
+ *  \param script The script filename (or NULL)
+ *  \param readStdin Whether to read commands from stdin
+ *
+ *  \return The application exit status code
+ */
+int runClient(const char *socketPath, const char *filename, char **commands, int commandsCount, const char *script, char readStdin) {
+	/* The applied & ignored commands counters */
+	unsigned long stats[2] = {0, 0};
+
+	/* The request & the replies */
+	struct Buffer request = {NULL, 0, 0};
+	struct Buffer replies = {NULL, 0, 0};
+	char data[SERVER_READ_SIZE];
+	char userInput[MAX_BUFFER_SIZE];
+	const char *line;
+	const char *lineEnd;
+	ssize_t result;
+
+	/* The quit flag & the exit status */
+	char quit = 0;
+	int status = 0;
+
+	/* The script file */
+	FILE *file = NULL;
+
+	/* The run start time */
+	const double startTime = getMonotonicTime();
+
+	/* Connect to the server */
+	int fd = serverConnect(socketPath);
+	if(fd == -1) {
+		fprintf(stderr, "ERROR connecting to: %s\n", socketPath);
+		return 1;
+	}
+	if(script != NULL && (file = fopen(script, "r")) == NULL) {
+		fprintf(stderr, "ERROR reading file: %s\n", script);
+		close(fd);
+		return 1;
+	}
+
+	/* Pick the list & send the commands */
+	bufferAppend(&request, "O ", 2);
+	queueCommand(&request, &replies, filename, fd);
+	for(; !quit && commandsCount > 0; commands++, commandsCount--) quit = queueCommand(&request, &replies, *commands, fd);
+	while(!quit && file != NULL && readCommand(file, userInput)) quit = queueCommand(&request, &replies, userInput, fd);
+	while(!quit && readStdin && readCommand(stdin, userInput)) quit = queueCommand(&request, &replies, userInput, fd);
+	sendRequest(&request, &replies, fd);
+	bufferFree(&request);
+	if(file != NULL) fclose(file);
+	shutdown(fd, SHUT_WR);
+
+	/* Count the replies (The first one is for picking the list) */
+	while((result = read(fd, data, SERVER_READ_SIZE)) != 0) {
+		if(result == -1) {
+			if(errno == EINTR) continue;
+			break;
+		}
+		bufferAppend(&replies, data, result);
+	}
+	close(fd);
+	for(line = replies.data; line < replies.data + replies.length; line = lineEnd + 1) {
+		lineEnd = findByte(line, replies.data + replies.length, '\n');
+		if(strncmp(line, "ERROR", 5) == 0) {
+			fprintf(stderr, "%.*s\n", (int) (lineEnd - line), line);
+			status = 1;
+		} else if(line > replies.data) {
+			stats[strncmp(line, "OK", 2) == 0 ? COMMAND_APPLIED : COMMAND_IGNORED]++;
+		}
+	}
+	bufferFree(&replies);
+
+	/* Print the summary */
+	printf("{\"applied\":%lu,\"ignored\":%lu,\"seconds\":%.6f}\n", stats[COMMAND_APPLIED], stats[COMMAND_IGNORED], getMonotonicTime() - startTime);
+	return status;
 }
 
 /**
@@ -83,21 +544,166 @@ void signalsHandler(int sig) {
  *  \return The application exit status code
  */
 int main(int argc, char **argv) {
-	/* The sigaction for signal handling */
-	struct sigaction sa;
+	/* The signals taken by the event loop */
+	sigset_t signalsMask;
+	int signals;
 
-	/* The quit flag */
-	char quit = 0;
+	/* The parsed option */
+	int option;
+
+	/* The batch mode options */
+	char batch = 0;
+	char readStdin = 0;
+	const char *script = NULL;
+	char **commands = (char **) malloc(sizeof(char *) * argc);
+	int commandsCount = 0;
+
+	/* The batch exit status */
+	int status;
+
+	/* The export option */
+	const char *exportFilename = NULL;
+
+	/* The daemon mode options */
+	const char *serveSocket = NULL;
+	const char *connectSocket = NULL;
+
+	/* The instrumentation options */
+	char stats = 0;
+	const char *statsFilename = NULL;
+	const char *traceFilename = NULL;
+
+	/* The long options */
+	const struct option longOptions[] = {
+		{"stats", optional_argument, NULL, 'S'},
+		{"trace", required_argument, NULL, 'T'},
+		{"threads", required_argument, NULL, 't'},
+		{"fsync", required_argument, NULL, 'F'},
+		{"serve", required_argument, NULL, 'L'},
+		{"connect", required_argument, NULL, 'C'},
+		{"max-loaded", required_argument, NULL, 'M'},
+		{"archive", required_argument, NULL, 'R'},
+		{"segments", no_argument, NULL, 'G'},
+		{"export", required_argument, NULL, 'E'},
+		{NULL, 0, NULL, 0}
+	};
+
+	if(commands == NULL) {
+		printf("ERROR allocating commands");
+		exit(1);
+	}
+
+	/* Parse the options */
+	while((option = getopt_long(argc, argv, "jsbf:c:t:", longOptions, NULL)) != -1) {
+		switch(option) {
+			case 'S':
+				stats = 1;
+				statsFilename = optarg;
+			break;
+			case 'T':
+				stats = 1;
+				traceFilename = optarg;
+			break;
+			case 'F':
+				if(strcmp(optarg, "always") == 0) setTODOListFsyncPolicy(WRITER_FSYNC_ALWAYS);
+				else if(strcmp(optarg, "interval") == 0) setTODOListFsyncPolicy(WRITER_FSYNC_INTERVAL);
+				else if(strcmp(optarg, "never") == 0) setTODOListFsyncPolicy(WRITER_FSYNC_NEVER);
+				else argc = 0;
+			break;
+			case 'L':
+				serveSocket = optarg;
+			break;
+			case 'C':
+				connectSocket = optarg;
+			break;
+			case 'M':
+				setTODOListMaxLoaded(strtoul(optarg, NULL, 10));
+			break;
+			case 'R':
+				setTODOListArchiveKeep(strtoul(optarg, NULL, 10));
+			break;
+			case 'G':
+				setTODOListSegmentMode(1);
+			break;
+			case 'E':
+				exportFilename = optarg;
+			break;
+			case 't':
+				setTODOListLoadThreads(strtoul(optarg, NULL, 10));
+			break;
+			case 'j':
+				setTODOListJournalMode(1);
+			break;
+			case 's':
+				setTODOListSnapshotMode(1);
+			break;
+			case 'b':
+				batch = readStdin = 1;
+			break;
+			case 'f':
+				batch = 1;
+				script = optarg;
+			break;
+			case 'c':
+				batch = 1;
+				commands[commandsCount++] = optarg;
+			break;
+			default:
+				argc = 0;
+			break;
+		}
+	}
 
 	/* If we didn't get the expected parameters... */
-	if(argc < 2 || argc > 3) {
+	if(argc - optind < (serveSocket != NULL ? 0 : 1) || argc - optind > 2 || (serveSocket != NULL && connectSocket != NULL) || (exportFilename != NULL && (batch || serveSocket != NULL || connectSocket != NULL))) {
 		/* Print the usage and exit */
-		printf("usage:\n%s filename [title]\n", argv[0]);
+		printf("usage:\n%s [-j] [-s] [-b] [-f script] [-c command]... [-t threads] [--fsync=always|interval|never] [--archive=entries] [--segments] [--stats[=file]] [--trace=file] filename [title]\n", argv[0]);
+		printf("%s [-j] [-s] [-t threads] [--fsync=always|interval|never] [--max-loaded=lists] [--archive=entries] [--segments] [--stats[=file]] [--trace=file] --serve=socket [filename [title]]\n", argv[0]);
+		printf("%s [-b] [-f script] [-c command]... --connect=socket list\n", argv[0]);
+		printf("%s [-j] [-t threads] [--segments] --export=file filename [title]\n", argv[0]);
+		free(commands);
 		return 1;
 	}
 
-	/* Load the TODO list */
-	loadTODOList(argv[1], argc > 2 ? argv[2] : NULL);
+	/* Forward the commands to a server (Reading them from stdin if there are none) */
+	if(connectSocket != NULL) {
+		status = runClient(connectSocket, argv[optind], commands, commandsCount, script, readStdin || !batch);
+		free(commands);
+		return status;
+	}
+
+	/* Enable the instrumentation */
+	if(stats) statsEnable(statsFilename, traceFilename);
+
+	/* Serve the lists */
+	if(serveSocket != NULL) {
+		free(commands);
+		status = serverRun(serveSocket, optind < argc ? argv[optind] : NULL, argc - optind > 1 ? argv[optind + 1] : NULL);
+		statsReport();
+		return status;
+	}
+
+	/* Load the TODO list (Watching its file for external changes in the interactive mode) */
+	setTODOListWatchMode(!batch && exportFilename == NULL);
+	loadTODOList(argv[optind], argc - optind > 1 ? argv[optind + 1] : NULL);
+
+	/* Write it into a single file */
+	if(exportFilename != NULL) {
+		status = exportTodoList(exportFilename) ? 0 : 1;
+		reportLoadStats();
+		freeTodoList();
+		free(commands);
+		statsReport();
+		return status;
+	}
+
+	/* Run the commands in batch mode */
+	if(batch) {
+		status = runBatch(commands, commandsCount, script, readStdin);
+		free(commands);
+		return status;
+	}
+	free(commands);
 
 	/* Set the initial window size */
 	updateWindowSize();
@@ -108,20 +714,12 @@ int main(int argc, char **argv) {
 	/* Set the default background color */
 	BGCOLOR(BLACK);
 
-	/* Set the signals handler */
-	sa.sa_handler = signalsHandler;
-	sa.sa_flags = SA_RESTART;
-	sigemptyset(&sa.sa_mask);
-
-	/* Set the SIGWINCH handler */
-	if(sigaction(SIGWINCH, &sa, NULL) == -1) {
-		printf("ERROR setting the SIGWINCH handler\n");
-		exit(1);
-	}
-
-	/* Set the SIGINT handler */
-	if(sigaction(SIGINT, &sa, NULL) == -1) {
-		printf("ERROR setting the SIGINT handler\n");
+	/* Take SIGWINCH & SIGINT through a signalfd (Blocking them before any thread is started) */
+	sigemptyset(&signalsMask);
+	sigaddset(&signalsMask, SIGWINCH);
+	sigaddset(&signalsMask, SIGINT);
+	if(pthread_sigmask(SIG_BLOCK, &signalsMask, NULL) != 0 || (signals = signalfd(-1, &signalsMask, SFD_NONBLOCK | SFD_CLOEXEC)) == -1) {
+		printf("ERROR setting the signals handler\n");
 		exit(1);
 	}
 
@@ -129,39 +727,8 @@ int main(int argc, char **argv) {
 	atexit(atExit);
 
 	/* Main loop */
-	while(!quit) {
-		/* The user input buffer */
-		char userInput[MAX_BUFFER_SIZE];
-		
-		/* Render the GUI */
-		render();
-
-		/* Get the user input */
-		fgets(userInput, sizeof(userInput), stdin);
-		
-		/* Remove the trailing '\n' character */
-		userInput[strlen(userInput) - 1] = '\0';
-
-		/* Process the user input */
-		switch(toupper(userInput[0])) {
-			case 'Q':
-				quit = 1;
-			break;
-			case 'A':
-				addNewEntry(userInput);
-			break;
-			case 'D':
-				userInput[0] = '0';
-				deleteEntry(atoi(userInput));
-			break;
-			case 'H':
-				toggleHelp();
-			break;
-			default:
-				toggleEntry(atoi(userInput));
-			break;
-		}
-	}
+	runEventLoop(signals);
+	close(signals);
 
 	return 0;
 }
@@ -26,10 +26,62 @@
 /* Initialize the variables */
 static struct winsize windowSize;
 static char renderHelp = 1;
+static struct Frame nextFrame = {NULL, 0, 0};
+static struct Frame screenFrame = {NULL, 0, 0};
+static unsigned long frameBytes = 0;
+static struct Buffer frameBuffer = {NULL, 0, 0};
+static char *titleDecoration = NULL;
+static int terminalColor = -1;
+static unsigned long scrollOffset = 0;
+static int renderOutput = 1;
+static struct TODOList *renderList = NULL;
+static char renderNotice[96] = "";
+
+/**
+ *  \brief The help commands
+ */
+static const char *helpCommands[HELP_COMMANDS][2] = {
+	{"[n]", "Toggle entries [n] (3,7,9-12)"},
+	{"A [title]", "Add new entry"},
+	{"D [n]", "Delete entries [n] (Or done)"},
+	{"N / P", "Next / Previous page"},
+	{"J [n]", "Jump to entry [n]"},
+	{"S [words]", "Search (S clears it)"},
+	{"H", "Toggle help"},
+	{"V", "Toggle archive view"},
+	{"U", "Remove duplicate entries"},
+	{"Q", "Quit"}
+};
 
 void updateWindowSize() {
 	/* Update the window size */
-	ioctl(0, TIOCGWINSZ, &windowSize);
+	if(ioctl(0, TIOCGWINSZ, &windowSize) == -1 || windowSize.ws_row == 0 || windowSize.ws_col == 0) {
+		windowSize.ws_row = DEFAULT_WINDOW_ROWS;
+		windowSize.ws_col = DEFAULT_WINDOW_COLS;
+	}
+}
+
+void setWindowSize(const unsigned short rows, const unsigned short cols) {
+	windowSize.ws_row = rows;
+	windowSize.ws_col = cols;
+}
+
+void setRenderList(struct TODOList *list) {
+	renderList = list;
+	scrollOffset = 0;
+}
+
+struct TODOList *getRenderList() {
+	return renderList != NULL ? renderList : getTODOListDefault();
+}
+
+void setRenderOutput(const int fd) {
+	renderOutput = fd;
+}
+
+void setRenderNotice(const char *notice) {
+	renderNotice[0] = '\0';
+	if(notice != NULL) strncat(renderNotice, notice, sizeof(renderNotice) - 1);
 }
 
 void toggleHelp() {
@@ -37,59 +89,322 @@ void toggleHelp() {
 	renderHelp = !renderHelp;
 }
 
+/**
+ *  \brief Returns the row the prompt gets rendered at
+ *
+ *  \return The 0-based prompt row
+ */
+static int getPromptRow() {
+	return windowSize.ws_row > 2 ? windowSize.ws_row - 2 : 0;
+}
+
+/**
+ *  \brief Returns the row the help gets rendered at
+ *
+ *  \return The 0-based help row (The prompt row when the help is hidden)
+ */
+static int getHelpRow() {
+	return getPromptRow() - (renderHelp ? HELP_COMMANDS + 1 : 0);
+}
+
+/**
+ *  \brief Returns the number of entries that fit in the viewport
+ *
+ *  \return The viewport rows
+ */
+static unsigned long getViewportRows() {
+	const int rows = getHelpRow() - 1 - VIEWPORT_ROW;
+	return rows > 0 ? rows : 0;
+}
+
+/**
+ *  \brief Keeps the scroll offset within the list
+ */
+static void clampScroll() {
+	const unsigned long length = todoListGetViewLength(getRenderList());
+	const unsigned long rows = getViewportRows();
+
+	if(length <= rows) scrollOffset = 0;
+	else if(scrollOffset > length - rows) scrollOffset = length - rows;
+}
+
+void scrollPage(const int pages) {
+	const unsigned long delta = getViewportRows() * (pages < 0 ? -pages : pages);
+
+	if(pages < 0) scrollOffset = scrollOffset > delta ? scrollOffset - delta : 0;
+	else scrollOffset += delta;
+	clampScroll();
+}
+
+void scrollTo(const unsigned long entryIndex) {
+	const unsigned long viewIndex = todoListGetViewPosition(getRenderList(), entryIndex);
+
+	if(viewIndex == 0) return;
+	scrollOffset = viewIndex - 1;
+	clampScroll();
+}
+
+/**
+ *  \brief Appends bytes to the frame output
+ *
+ *  \param str The bytes to be appended
+ *  \param length The number of bytes
+ */
+static void emit(const char *str, size_t length) {
+	bufferAppend(&frameBuffer, str, length);
+}
+
+/**
+ *  \brief Appends a cursor move to the frame output
+ *
+ *  \param row The 0-based row
+ *  \param col The 0-based column
+ */
+static void emitCursor(unsigned short row, unsigned short col) {
+	char buf[32];
+	emit(buf, sprintf(buf, "\033[%d;%dH", row + 1, col + 1));
+}
+
+/**
+ *  \brief Appends a color change to the frame output
+ *         (Unless the terminal is already set to that color)
+ *
+ *  \param color The color
+ */
+static void emitColor(unsigned char color) {
+	char buf[16];
+	if(terminalColor == color) return;
+	emit(buf, sprintf(buf, "\033[%d;1m", 30 + color));
+	terminalColor = color;
+}
+
+/**
+ *  \brief Resizes a frame, blanking all it's cells
+ *
+ *  \param frame The frame
+ */
+static void resizeFrame(struct Frame *frame) {
+	frame->rows = windowSize.ws_row;
+	frame->cols = windowSize.ws_col;
+	free(frame->cells);
+	frame->cells = (struct FrameCell *) calloc((size_t) frame->rows * frame->cols, sizeof(struct FrameCell));
+	if(frame->cells == NULL) {
+		printf("ERROR allocating frame");
+		exit(1);
+	}
+}
+
+/**
+ *  \brief Puts a text into the frame being composed
+ *
+ *  \param row The 0-based row
+ *  \param col The 0-based column
+ *  \param color The text color
+ *  \param text The text
+ *  \param length The text length
+ *
+ *  \return The column after the text
+ */
+static int putText(int row, int col, unsigned char color, const char *text, size_t length) {
+	const char *end = text + length;
+	struct FrameCell *cell;
+	unsigned char charLength;
+
+	if(row < 0 || row >= nextFrame.rows) return col;
+	while(text < end && col < nextFrame.cols) {
+		/* Get the UTF-8 sequence length */
+		charLength = 1;
+		if((*text & 0xE0) == 0xC0) charLength = 2;
+		else if((*text & 0xF0) == 0xE0) charLength = 3;
+		else if((*text & 0xF8) == 0xF0) charLength = 4;
+		if(text + charLength > end) charLength = end - text;
+
+		/* Copy it into the cell */
+		if(col >= 0) {
+			cell = nextFrame.cells + row * nextFrame.cols + col;
+			memcpy(cell->text, text, charLength);
+			cell->length = charLength;
+			cell->color = color;
+		}
+		text += charLength;
+		col++;
+	}
+	return col;
+}
+
+/**
+ *  \brief Appends the frame cells that changed since the last frame
+ */
+static void emitChanges() {
+	/* The cell pointers */
+	const struct FrameCell *next;
+	const struct FrameCell *screen;
+
+	/* The span state */
+	int row;
+	int col;
+	int spanEnd;
+	int unchanged;
+
+	for(row = 0; row < nextFrame.rows; row++) {
+		next = nextFrame.cells + row * nextFrame.cols;
+		screen = screenFrame.cells + row * screenFrame.cols;
+		col = 0;
+		while(col < nextFrame.cols) {
+			/* Skip the unchanged cells */
+			if(memcmp(next + col, screen + col, sizeof(struct FrameCell)) == 0) {
+				col++;
+				continue;
+			}
+
+			/* Find the end of the changed span */
+			for(spanEnd = col + 1, unchanged = 0; spanEnd < nextFrame.cols && unchanged < SPAN_JOIN_DISTANCE; spanEnd++) {
+				if(memcmp(next + spanEnd, screen + spanEnd, sizeof(struct FrameCell)) == 0) unchanged++;
+				else unchanged = 0;
+			}
+			spanEnd -= unchanged;
+
+			/* Write it */
+			emitCursor(row, col);
+			for(; col < spanEnd; col++) {
+				if(next[col].length == 0) {
+					emit(" ", 1);
+					continue;
+				}
+				emitColor(next[col].color);
+				emit(next[col].text, next[col].length);
+			}
+		}
+	}
+}
+
 void render() {
-	/* The entry pointer */
-	const struct TODOEntry *entry = getTODOListFirst();
+	/* The list on the screen */
+	struct TODOList *list = getRenderList();
+
+	/* The entry pointer & index (In the view & in the list) */
+	const struct TODOEntry *entry;
+	unsigned long index;
+	unsigned long entryIndex;
 
-	/* The entry index */
-	unsigned short int index = 1;
+	/* The search query */
+	const char *filter = todoListGetFilter(list);
 
 	/* The title & it's length */
-	const char *title = getTODOListTitle();
-	char titleLength = strlen(title);
-
-	/* Iteration counter for the list title decorations */
-	unsigned short int i;
-
-	/* Clear the screen */
-	CLEAR_SCREEN();
-
-	/* Print the title */
-	FGCOLOR(CYAN);
-	for(i=0; i<windowSize.ws_col; i++) printf("=");
-	printf("\n%*s\n", (windowSize.ws_col / 2) + (titleLength / 2), title);
-	for(i=0; i<windowSize.ws_col; i++) printf("=");
-	printf("\n\n");
-	
-	/* Iterate through the TODO list */
-	while(entry != NULL) {
-		if(entry->done) FGCOLOR(GREEN);
-		else FGCOLOR(RED);
-		printf("%3d: %s %s\n", index++, entry->done ? "✔" : "✘", entry->title);
-		entry = entry->next;
+	const char *title = todoListGetTitle(list);
+	const int titleLength = strlen(title);
+
+	/* The entry & scroll position line buffer */
+	char line[64];
+	unsigned long viewportRows;
+	unsigned long length;
+
+	/* The frame layout */
+	int row;
+	int col;
+	int helpRow;
+	int promptRow;
+
+	/* The frame struct swap */
+	struct Frame swap;
+
+	/* The render start time */
+	const double statsStart = statsBegin();
+
+	/* Compose the frame from scratch */
+	if(nextFrame.rows != windowSize.ws_row || nextFrame.cols != windowSize.ws_col) {
+		resizeFrame(&nextFrame);
+
+		/* Precompute the title decoration */
+		free(titleDecoration);
+		if((titleDecoration = (char *) malloc(nextFrame.cols)) == NULL) {
+			printf("ERROR allocating title decoration");
+			exit(1);
+		}
+		memset(titleDecoration, '=', nextFrame.cols);
+	} else {
+		memset(nextFrame.cells, 0, sizeof(struct FrameCell) * nextFrame.rows * nextFrame.cols);
+	}
+	promptRow = getPromptRow();
+	helpRow = getHelpRow();
+
+	/* Put the title */
+	putText(0, 0, CYAN, titleDecoration, nextFrame.cols);
+	putText(2, 0, CYAN, titleDecoration, nextFrame.cols);
+	putText(1, (nextFrame.cols / 2) + (titleLength / 2) - titleLength, CYAN, title, titleLength);
+
+	/* Put the done & total entries counts */
+	length = sprintf(line, "%lu/%lu done", todoListGetDoneCount(list), todoListGetLength(list));
+	putText(1, nextFrame.cols - length, CYAN, line, length);
+
+	/* Find the first visible entry */
+	clampScroll();
+	viewportRows = getViewportRows();
+	length = todoListGetViewLength(list);
+	index = scrollOffset + 1;
+
+	/* Put the search query & the number of matches */
+	if(filter != NULL) {
+		col = putText(VIEWPORT_ROW - 1, 0, YELLOW, "Search: ", 8);
+		col = putText(VIEWPORT_ROW - 1, col, WHITE, filter, strlen(filter));
+		putText(VIEWPORT_ROW - 1, col, YELLOW, line, sprintf(line, " (%lu matches)", length));
+	} else if(renderNotice[0] != '\0') {
+		putText(VIEWPORT_ROW - 1, 0, YELLOW, renderNotice, strlen(renderNotice));
+	}
+
+	/* Put the scroll position (if the list doesn't fit) */
+	if(length > viewportRows && viewportRows > 0) {
+		const int lineLength = sprintf(line, "%lu-%lu/%lu", index, index + viewportRows - 1, length);
+		putText(VIEWPORT_ROW - 1, nextFrame.cols - lineLength, CYAN, line, lineLength);
+	}
+
+	/* Put the visible entries (Keeping their global numbering) */
+	for(row = VIEWPORT_ROW; (unsigned long) (row - VIEWPORT_ROW) < viewportRows; row++) {
+		if((entry = todoListGetViewEntry(list, index++, &entryIndex)) == NULL) break;
+		col = putText(row, 0, entry->done ? GREEN : RED, line, sprintf(line, "%3lu: %s ", entryIndex, entry->done ? DONE_MARKER : PENDING_MARKER));
+		putText(row, col, entry->done ? GREEN : RED, entry->title, entry->titleLength);
 	}
 
-	/* Move the cursor to the bottom of the screen */
-	printf("\033[%df\n", windowSize.ws_row - (renderHelp ? 7 : 2));
-	
 	if(renderHelp) {
-		/* Print help */
-		const char *commands[5][2] = {
-			{"[n]", "Toggle entry [n]"},
-			{"A [title]", "Add new entry"},
-			{"D [n]", "Delete entry [n]"},
-			{"H", "Toggle help"},
-			{"Q", "Quit"}
-		};
-
-		for(i=0; i<5; i++) {
-			FGCOLOR(YELLOW);
-			printf("%*s%-13s", (windowSize.ws_col / 2) - 15, "", commands[i][0]);
-			FGCOLOR(CYAN);
-			printf("%s\n", commands[i][1]);
+		/* Put the help */
+		for(row = 0; row < HELP_COMMANDS; row++) {
+			col = (nextFrame.cols / 2) - 15;
+			putText(helpRow + row, col, YELLOW, helpCommands[row][0], strlen(helpCommands[row][0]));
+			putText(helpRow + row, col + 13, CYAN, helpCommands[row][1], strlen(helpCommands[row][1]));
 		}
 	}
 
-	FGCOLOR(WHITE);
-	printf("\n> ");
+	if(screenFrame.rows != nextFrame.rows || screenFrame.cols != nextFrame.cols) {
+		/* Fully repaint the screen on the first frame & after resizing */
+		resizeFrame(&screenFrame);
+		emit("\033[H\033[2J", 7);
+	}
+
+	/* Write the changes */
+	emitChanges();
+
+	/* The prompt row holds the echoed user input, so it's always rewritten */
+	emitCursor(promptRow, 0);
+	emitColor(WHITE);
+	emit("> \033[K", 5);
+
+	/* Write the whole frame at once (After anything still buffered in stdout) */
+	frameBytes = frameBuffer.length;
+	STATS_COUNT(STATS_FRAME_BYTES, frameBytes);
+	if(renderOutput != -1) {
+		fflush(stdout);
+		bufferFlush(&frameBuffer, renderOutput);
+	} else {
+		frameBuffer.length = 0;
+	}
+
+	/* The composed frame is now on the screen */
+	swap = screenFrame;
+	screenFrame = nextFrame;
+	nextFrame = swap;
+	statsEnd(STATS_RENDER, statsStart);
+}
+
+unsigned long getFrameBytes() {
+	return frameBytes;
 }
@@ -0,0 +1,329 @@
+/*
+	C90 TODO List
+	Copyright (C) 2015 Daniel Esteban Nombela <dani@dabuten.co>
+
+	This software is provided 'as-is', without any express or implied
+	warranty. In no event will the author be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "search.h"
+
+/**
+ *  \brief Returns whether a byte is part of a word
+ *         (UTF-8 sequences are always part of a word)
+ *
+ *  \param c The byte
+ *
+ *  \return Whether it's part of a word
+ */
+static int isWordByte(unsigned char c) {
+	return c >= 0x80 || isalnum(c);
+}
+
+/**
+ *  \brief Finds the next word in a text
+ *
+ *  \param text The text position (Updated to the end of the word)
+ *  \param end The text end
+ *  \param length The word length
+ *
+ *  \return The word start or NULL if there are no more words
+ */
+static const char *nextWord(const char **text, const char *end, size_t *length) {
+	const char *word = *text;
+
+	while(word < end && !isWordByte(*word)) word++;
+	if(word == end) return NULL;
+	for(*text = word; *text < end && isWordByte(**text); (*text)++);
+	*length = *text - word;
+	return word;
+}
+
+/**
+ *  \brief Hashes a word case-insensitively (FNV-1a)
+ *
+ *  \param word The word
+ *  \param length The word length
+ *
+ *  \return The hash
+ */
+static unsigned long hashWord(const char *word, size_t length) {
+	unsigned long hash = 2166136261UL;
+
+	while(length-- > 0) hash = (hash ^ (unsigned char) tolower((unsigned char) *word++)) * 16777619UL;
+	return hash;
+}
+
+/**
+ *  \brief Finds the slot of a word in the token table
+ *
+ *  \param index The index
+ *  \param word The word
+ *  \param length The word length
+ *  \param hash The word hash
+ *
+ *  \return The slot holding the word or the empty slot it would go in
+ */
+static struct SearchPosting **findSlot(const struct SearchIndex *index, const char *word, size_t length, unsigned long hash) {
+	const unsigned long mask = index->slotsCount - 1;
+	unsigned long slot = hash & mask;
+	struct SearchPosting *posting;
+	size_t i;
+
+	while((posting = index->slots[slot]) != NULL) {
+		if(posting->hash == hash && posting->length == length) {
+			for(i = 0; i < length && posting->token[i] == tolower((unsigned char) word[i]); i++);
+			if(i == length) break;
+		}
+		slot = (slot + 1) & mask;
+	}
+	return index->slots + slot;
+}
+
+/**
+ *  \brief Doubles the token table
+ *
+ *  \param index The index
+ */
+static void growSlots(struct SearchIndex *index) {
+	struct SearchPosting **slots = index->slots;
+	const unsigned long slotsCount = index->slotsCount;
+	unsigned long i;
+
+	index->slotsCount = slotsCount > 0 ? slotsCount * 2 : SEARCH_INITIAL_SLOTS;
+	if((index->slots = (struct SearchPosting **) calloc(index->slotsCount, sizeof(struct SearchPosting *))) == NULL) {
+		printf("ERROR allocating search slots");
+		exit(1);
+	}
+
+	/* Rehash the tokens */
+	for(i = 0; i < slotsCount; i++) {
+		if(slots[i] != NULL) *findSlot(index, slots[i]->token, slots[i]->length, slots[i]->hash) = slots[i];
+	}
+	free(slots);
+}
+
+/**
+ *  \brief Gallops through a posting list
+ *
+ *  Probes exponentially growing steps from a position & binary
+ *  searches the last step, so walking a list in key order costs
+ *  O(log gap) per lookup.
+ *
+ *  \param posting The posting list
+ *  \param from The position to start from
+ *  \param key The item key
+ *
+ *  \return The position of the first item with a key not lower than the given one
+ */
+static unsigned long findKey(const struct SearchPosting *posting, unsigned long from, unsigned long key) {
+	unsigned long low = from;
+	unsigned long high;
+	unsigned long middle;
+	unsigned long step = 1;
+
+	/* Find a step past the key */
+	while(low + step < posting->count && posting->keys[low + step] < key) {
+		low += step;
+		step *= 2;
+	}
+	high = low + step < posting->count ? low + step : posting->count;
+
+	/* Binary search it */
+	while(low < high) {
+		middle = low + (high - low) / 2;
+		if(posting->keys[middle] < key) low = middle + 1;
+		else high = middle;
+	}
+	return low;
+}
+
+void searchIndexAdd(struct SearchIndex *index, const char *text, size_t length, void *item) {
+	const char *end = text + length;
+	const char *word;
+	struct SearchPosting **slot;
+	struct SearchPosting *posting;
+	unsigned long hash;
+	const unsigned long key = index->key(item);
+	size_t i;
+
+	while((word = nextWord(&text, end, &length)) != NULL) {
+		/* Find the word posting list */
+		if(index->tokensCount * 2 >= index->slotsCount) growSlots(index);
+		hash = hashWord(word, length);
+		if((posting = *(slot = findSlot(index, word, length, hash))) == NULL) {
+			/* Add a new token */
+			posting = (struct SearchPosting *) arenaAlloc(&index->arena, sizeof(struct SearchPosting), sizeof(void *));
+			posting->token = arenaStrndup(&index->arena, word, length);
+			for(i = 0; i < length; i++) posting->token[i] = tolower((unsigned char) posting->token[i]);
+			posting->length = length;
+			posting->hash = hash;
+			posting->items = NULL;
+			posting->keys = NULL;
+			posting->count = posting->capacity = 0;
+			posting->dirty = NULL;
+			posting->marked = 0;
+			*slot = posting;
+			index->tokensCount++;
+		}
+
+		/* Append the item (Once, even if it holds the word several times) */
+		if(posting->count > 0 && posting->items[posting->count - 1] == item) continue;
+		if(posting->count == posting->capacity) {
+			posting->capacity = posting->capacity > 0 ? posting->capacity * 2 : 4;
+			posting->items = (void **) realloc(posting->items, sizeof(void *) * posting->capacity);
+			posting->keys = (unsigned long *) realloc(posting->keys, sizeof(unsigned long) * posting->capacity);
+			if(posting->items == NULL || posting->keys == NULL) {
+				printf("ERROR allocating search posting list");
+				exit(1);
+			}
+		}
+		posting->items[posting->count] = item;
+		posting->keys[posting->count++] = key;
+	}
+}
+
+void searchIndexRemove(struct SearchIndex *index, const char *text, size_t length, void *item) {
+	const char *end = text + length;
+	const char *word;
+	struct SearchPosting *posting;
+	unsigned long position;
+	unsigned long key;
+
+	if(index->slotsCount == 0) return;
+	key = index->key(item);
+	while((word = nextWord(&text, end, &length)) != NULL) {
+		if((posting = *findSlot(index, word, length, hashWord(word, length))) == NULL) continue;
+
+		/* Remove the item (Unless it was already removed for a repeated word) */
+		position = findKey(posting, 0, key);
+		if(position == posting->count || posting->keys[position] != key) continue;
+		memmove(posting->items + position, posting->items + position + 1, sizeof(void *) * (posting->count - position - 1));
+		memmove(posting->keys + position, posting->keys + position + 1, sizeof(unsigned long) * (posting->count - position - 1));
+		posting->count--;
+	}
+}
+
+void searchIndexMark(struct SearchIndex *index, const char *text, size_t length, void *item) {
+	const char *end = text + length;
+	const char *word;
+	struct SearchPosting *posting;
+	unsigned long position;
+	unsigned long key;
+
+	if(index->slotsCount == 0) return;
+	key = index->key(item);
+	while((word = nextWord(&text, end, &length)) != NULL) {
+		if((posting = *findSlot(index, word, length, hashWord(word, length))) == NULL) continue;
+
+		/* Mark the item (Its key stays, so the list stays sorted until it gets compacted) */
+		position = findKey(posting, 0, key);
+		if(position == posting->count || posting->items[position] != item) continue;
+		posting->items[position] = NULL;
+		if(!posting->marked) {
+			posting->marked = 1;
+			posting->dirty = index->dirty;
+			index->dirty = posting;
+		}
+	}
+}
+
+void searchIndexCompact(struct SearchIndex *index) {
+	struct SearchPosting *posting;
+	unsigned long i;
+	unsigned long count;
+
+	for(posting = index->dirty; posting != NULL; posting = posting->dirty) {
+		/* Shift the kept items over the marked ones in a single pass */
+		for(i = count = 0; i < posting->count; i++) {
+			if(posting->items[i] == NULL) continue;
+			posting->items[count] = posting->items[i];
+			posting->keys[count++] = posting->keys[i];
+		}
+		posting->count = count;
+		posting->marked = 0;
+	}
+	index->dirty = NULL;
+}
+
+void searchIndexQuery(const struct SearchIndex *index, const char *query, struct SearchResults *results) {
+	const struct SearchPosting *postings[SEARCH_MAX_QUERY_TOKENS];
+	unsigned long positions[SEARCH_MAX_QUERY_TOKENS];
+	const struct SearchPosting *shortest = NULL;
+	const char *end = query + strlen(query);
+	const char *word;
+	size_t length;
+	unsigned long key;
+	unsigned long position;
+	unsigned long i;
+	int postingsCount = 0;
+	int j;
+
+	results->count = 0;
+	if(index->slotsCount == 0) return;
+
+	/* Find the posting lists of the query words */
+	while(postingsCount < SEARCH_MAX_QUERY_TOKENS && (word = nextWord(&query, end, &length)) != NULL) {
+		if((postings[postingsCount] = *findSlot(index, word, length, hashWord(word, length))) == NULL) return;
+		if(shortest == NULL || postings[postingsCount]->count < shortest->count) shortest = postings[postingsCount];
+		positions[postingsCount++] = 0;
+	}
+	if(shortest == NULL) return;
+
+	/* Make room for the worst case */
+	if(results->capacity < shortest->count) {
+		results->capacity = shortest->count;
+		free(results->items);
+		if((results->items = (void **) malloc(sizeof(void *) * results->capacity)) == NULL) {
+			printf("ERROR allocating search results");
+			exit(1);
+		}
+	}
+
+	/* Intersect the shortest posting list with the rest (Walking them all in key order) */
+	for(i = 0; i < shortest->count; i++) {
+		key = shortest->keys[i];
+		for(j = 0; j < postingsCount; j++) {
+			if(postings[j] == shortest) continue;
+			position = positions[j] = findKey(postings[j], positions[j], key);
+			if(position == postings[j]->count) return;
+			if(postings[j]->keys[position] != key) break;
+		}
+		if(j == postingsCount) results->items[results->count++] = shortest->items[i];
+	}
+}
+
+void searchIndexFree(struct SearchIndex *index) {
+	unsigned long i;
+
+	for(i = 0; i < index->slotsCount; i++) {
+		if(index->slots[i] == NULL) continue;
+		free(index->slots[i]->items);
+		free(index->slots[i]->keys);
+	}
+	free(index->slots);
+	arenaFree(&index->arena);
+	index->slots = NULL;
+	index->dirty = NULL;
+	index->slotsCount = index->tokensCount = 0;
+}
+
+void searchResultsFree(struct SearchResults *results) {
+	free(results->items);
+	memset(results, 0, sizeof(struct SearchResults));
+}
@@ -0,0 +1,309 @@
+/*
+	C90 TODO List
+	Copyright (C) 2015 Daniel Esteban Nombela <dani@dabuten.co>
+
+	This software is provided 'as-is', without any express or implied
+	warranty. In no event will the author be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "segment.h"
+
+/**
+ *  \brief Returns the filename of a segment file
+ *
+ *  \param segments The segments
+ *  \param file The number of the file
+ *
+ *  \return A newly allocated segment filename
+ */
+static char *segmentFilename(const struct Segments *segments, unsigned long file) {
+	char *filename = (char *) malloc(strlen(segments->directory) + 32);
+
+	if(filename == NULL) {
+		printf("ERROR allocating segment filename");
+		exit(1);
+	}
+	sprintf(filename, "%s/%08lu.txt", segments->directory, file);
+	return filename;
+}
+
+/**
+ *  \brief Adds an empty segment at the end
+ *
+ *  \param segments The segments
+ *
+ *  \return The segment
+ */
+static struct Segment *addSegment(struct Segments *segments) {
+	struct Segment *segment;
+
+	if(segments->count == segments->capacity) {
+		segments->capacity = segments->capacity == 0 ? 16 : segments->capacity * 2;
+		if((segments->items = (struct Segment *) realloc(segments->items, sizeof(struct Segment) * segments->capacity)) == NULL) {
+			printf("ERROR allocating the segments");
+			exit(1);
+		}
+	}
+	segment = segments->items + segments->count++;
+	memset(segment, 0, sizeof(struct Segment));
+	return segment;
+}
+
+/**
+ *  \brief Removes segment files
+ *
+ *  \param segments The segments
+ *  \param files The numbers of the files (unsigned long array)
+ */
+static void removeFiles(const struct Segments *segments, const struct Buffer *files) {
+	const unsigned long *file = (const unsigned long *) files->data;
+	const unsigned long *end = file + files->length / sizeof(unsigned long);
+	char *filename;
+
+	for(; file < end; file++) {
+		filename = segmentFilename(segments, *file);
+		unlink(filename);
+		free(filename);
+	}
+}
+
+char segmentsOpen(struct Segments *segments, const char *listFilename, char **title) {
+	size_t length = strlen(listFilename);
+	char *data;
+	size_t size;
+	char mapped;
+	const char *line;
+	const char *lineEnd;
+	const char *end;
+	unsigned long file;
+
+	/* The directory & manifest filenames (Replacing the ".txt" extension) */
+	memset(segments, 0, sizeof(struct Segments));
+	segments->nextFile = 1;
+	if(length >= 4 && strcmp(listFilename + length - 4, ".txt") == 0) length -= 4;
+	segments->directory = (char *) malloc(length + sizeof(SEGMENTS_EXTENSION));
+	segments->manifest = (char *) malloc(length + sizeof(SEGMENTS_EXTENSION) + sizeof(SEGMENTS_MANIFEST));
+	if(segments->directory == NULL || segments->manifest == NULL) {
+		printf("ERROR allocating segments filenames");
+		exit(1);
+	}
+	memcpy(segments->directory, listFilename, length);
+	strcpy(segments->directory + length, SEGMENTS_EXTENSION);
+	sprintf(segments->manifest, "%s/%s", segments->directory, SEGMENTS_MANIFEST);
+
+	/* Read the manifest */
+	*title = NULL;
+	if((data = mapFile(segments->manifest, &size, &mapped)) == NULL) return 0;
+	end = data + size;
+	lineEnd = findByte(data, end, '\n');
+	if((*title = (char *) malloc(lineEnd - data + 1)) == NULL) {
+		printf("ERROR allocating the list title");
+		exit(1);
+	}
+	memcpy(*title, data, lineEnd - data);
+	(*title)[lineEnd - data] = '\0';
+
+	/* Add a segment per file number */
+	for(line = lineEnd + 1; line < end; line = lineEnd + 1) {
+		lineEnd = findByte(line, end, '\n');
+		for(file = 0; line < lineEnd && isdigit((unsigned char) *line); line++) file = file * 10 + (*line - '0');
+		if(file == 0) continue;
+		addSegment(segments)->file = file;
+		if(file >= segments->nextFile) segments->nextFile = file + 1;
+	}
+	unmapFile(data, size, mapped);
+	return 1;
+}
+
+char *segmentsRead(const struct Segments *segments, size_t *size, size_t *ends) {
+	struct Buffer data = {NULL, 0, 0};
+	struct stat status;
+	char *filename;
+	size_t fileEnd;
+	ssize_t readBytes;
+	unsigned long i;
+	int fd;
+
+	for(i = 0; i < segments->count; i++) {
+		filename = segmentFilename(segments, segments->items[i].file);
+		if((fd = open(filename, O_RDONLY)) == -1 || fstat(fd, &status) == -1) {
+			printf("ERROR reading segment: %s\n", filename);
+		} else {
+			/* Make room for it & a closing newline */
+			fileEnd = data.length + status.st_size;
+			if(data.capacity < fileEnd + 1) {
+				data.capacity = data.capacity * 2 > fileEnd + 1 ? data.capacity * 2 : fileEnd + 1;
+				if((data.data = (char *) realloc(data.data, data.capacity)) == NULL) {
+					printf("ERROR allocating the read buffer");
+					exit(1);
+				}
+			}
+			while(data.length < fileEnd && (readBytes = read(fd, data.data + data.length, fileEnd - data.length)) > 0) data.length += readBytes;
+		}
+		if(fd != -1) close(fd);
+		free(filename);
+
+		/* So its last line doesn't run into the next segment */
+		if(data.length > 0 && data.data[data.length - 1] != '\n') bufferAppend(&data, "\n", 1);
+		ends[i] = data.length;
+	}
+	*size = data.length;
+	return data.data;
+}
+
+void segmentsAppend(struct Segments *segments, unsigned long id) {
+	struct Segment *segment = segments->count > 0 ? segments->items + segments->count - 1 : NULL;
+
+	if(segment == NULL || segment->count >= SEGMENT_MAX_ENTRIES) {
+		segment = addSegment(segments);
+		segment->firstId = id;
+	}
+	segment->count++;
+	segment->dirty = 1;
+}
+
+void segmentsTouch(struct Segments *segments, unsigned long id, char removed) {
+	unsigned long low = 0;
+	unsigned long high = segments->count;
+	unsigned long middle;
+
+	if(segments->count == 0) return;
+
+	/* Find the last segment starting at or before the id */
+	while(high - low > 1) {
+		middle = low + (high - low) / 2;
+		if(segments->items[middle].firstId <= id) low = middle;
+		else high = middle;
+	}
+	segments->items[low].dirty = 1;
+	if(removed) segments->items[low].count--;
+}
+
+void segmentsTake(struct Segments *segments, struct SegmentsWriter *writer) {
+	unsigned long i;
+	unsigned long kept;
+
+	for(i = kept = 0; i < segments->count; i++) {
+		if(segments->items[i].count > 0) {
+			segments->items[kept++] = segments->items[i];
+			continue;
+		}
+
+		/* Drop it (Its entries ids fall into the previous one) */
+		if(segments->items[i].file != 0) bufferAppend(&writer->obsolete, (const char *) &segments->items[i].file, sizeof(unsigned long));
+	}
+	segments->count = kept;
+}
+
+void segmentsTakeFile(struct Segments *segments, struct SegmentsWriter *writer, unsigned long segment) {
+	struct Segment *item = segments->items + segment;
+	struct SegmentFile file;
+
+	/* Replace its file with a new one */
+	if(item->file != 0) bufferAppend(&writer->obsolete, (const char *) &item->file, sizeof(unsigned long));
+	item->file = segments->nextFile++;
+	item->dirty = 0;
+
+	file.segment = segment;
+	file.file = item->file;
+	file.offset = writer->contents.length;
+	file.length = 0;
+	bufferAppend(&writer->files, (const char *) &file, sizeof(struct SegmentFile));
+}
+
+void segmentsTakeManifest(struct Segments *segments, struct SegmentsWriter *writer, const char *title) {
+	struct SegmentFile *files = (struct SegmentFile *) writer->files.data;
+	const unsigned long count = writer->files.length / sizeof(struct SegmentFile);
+	char number[32];
+	unsigned long i;
+
+	/* Close the contents of the files */
+	for(i = 0; i < count; i++) files[i].length = (i + 1 < count ? files[i + 1].offset : writer->contents.length) - files[i].offset;
+
+	/* Put the title & the files */
+	bufferAppend(&writer->manifest, title, strlen(title));
+	bufferAppend(&writer->manifest, "\n", 1);
+	for(i = 0; i < segments->count; i++) bufferAppend(&writer->manifest, number, sprintf(number, "%08lu\n", segments->items[i].file));
+}
+
+char segmentsWrite(const struct Segments *segments, struct SegmentsWriter *writer, int sync) {
+	const struct SegmentFile *files = (const struct SegmentFile *) writer->files.data;
+	const unsigned long count = writer->files.length / sizeof(struct SegmentFile);
+	struct Buffer contents;
+	char *filename;
+	char written = 1;
+	unsigned long i;
+	int fd;
+
+	if(mkdir(segments->directory, 0755) == -1 && errno != EEXIST) {
+		printf("ERROR creating directory: %s\n", segments->directory);
+		return 0;
+	}
+
+	/* Write the new files */
+	STATS_COUNT(STATS_BYTES_WRITTEN, writer->contents.length + writer->manifest.length);
+	for(i = 0; written && i < count; i++) {
+		filename = segmentFilename(segments, files[i].file);
+		contents.data = writer->contents.data + files[i].offset;
+		contents.length = contents.capacity = files[i].length;
+		if((fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644)) == -1) {
+			written = 0;
+		} else {
+			written = bufferFlush(&contents, fd) && (sync == WRITE_SYNC_NONE || fsync(fd) == 0);
+			if(close(fd) == -1) written = 0;
+		}
+		if(!written) printf("ERROR writing to file: %s\n", filename);
+		free(filename);
+	}
+
+	/* Point the manifest to them */
+	if(written && !(written = writeFileAtomically(segments->manifest, &writer->manifest, sync))) printf("ERROR writing to file: %s\n", segments->manifest);
+	return written;
+}
+
+void segmentsFinish(struct Segments *segments, struct SegmentsWriter *writer, char written) {
+	const struct SegmentFile *files = (const struct SegmentFile *) writer->files.data;
+	const unsigned long count = writer->files.length / sizeof(struct SegmentFile);
+	unsigned long i;
+
+	if(written) {
+		/* Remove the files the manifest no longer points to */
+		removeFiles(segments, &segments->obsolete);
+		removeFiles(segments, &writer->obsolete);
+		segments->obsolete.length = 0;
+	} else {
+		/* The manifest still points to them, so they get removed after the next write */
+		bufferAppend(&segments->obsolete, writer->obsolete.data, writer->obsolete.length);
+
+		/* Write the segments again (Their new files get replaced too) */
+		for(i = 0; i < count; i++) segments->items[files[i].segment].dirty = 1;
+	}
+
+	bufferFree(&writer->files);
+	bufferFree(&writer->contents);
+	bufferFree(&writer->manifest);
+	bufferFree(&writer->obsolete);
+}
+
+void segmentsClose(struct Segments *segments) {
+	free(segments->directory);
+	free(segments->manifest);
+	free(segments->items);
+	bufferFree(&segments->obsolete);
+	memset(segments, 0, sizeof(struct Segments));
+}
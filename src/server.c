@@ -0,0 +1,530 @@
+/*
+	C90 TODO List
+	Copyright (C) 2015 Daniel Esteban Nombela <dani@dabuten.co>
+
+	This software is provided 'as-is', without any express or implied
+	warranty. In no event will the author be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+/**
+ *  \file server.c
+ *
+ *  Daemon mode functions
+ */
+
+#include "server.h"
+
+/* Initialize the variables */
+static struct ServerList *serverLists = NULL;
+static char *serverDirectory = NULL;
+static struct ServerClient *serverClients = NULL;
+static int serverEpoll = -1;
+static volatile sig_atomic_t serverStopping = 0;
+
+/**
+ *  \brief Termination signals handler
+ *  \param sig The signal ID
+ */
+static void stopServer(int sig) {
+	(void) sig;
+	serverStopping = 1;
+}
+
+/**
+ *  \brief Returns a served list, opening it on its first use
+ *
+ *  \param name The list filename (The extension can be missing)
+ *  \param title The list title (or NULL)
+ *
+ *  \return The list handle
+ */
+static struct TODOList *getServedList(const char *name, const char *title) {
+	char *filename = todoListFilename(name);
+	struct ServerList *served;
+
+	for(served = serverLists; served != NULL; served = served->next) {
+		if(strcmp(served->filename, filename) == 0) {
+			free(filename);
+			return served->list;
+		}
+	}
+
+	/* Open it */
+	if((served = (struct ServerList *) malloc(sizeof(struct ServerList))) == NULL) {
+		printf("ERROR allocating a served list");
+		exit(1);
+	}
+	served->filename = filename;
+	served->list = todoListOpen(filename, title);
+	served->next = serverLists;
+	serverLists = served;
+	return served->list;
+}
+
+/**
+ *  \brief Returns the path of a list picked by a client
+ *
+ *  Only plain list names are accepted ("name" or "name.txt"): no '/',
+ *  no leading '.' & no other extension, so the clients can't get any
+ *  other file parsed & overwritten as a list.
+ *
+ *  \param name The list name
+ *
+ *  \return The list path in the served directory (or NULL if the name isn't valid)
+ */
+static char *getServedPath(const char *name) {
+	const size_t length = strlen(name);
+	const char *dot = strchr(name, '.');
+	size_t directoryLength;
+	char *path;
+
+	if(name[0] == '.' || strchr(name, '/') != NULL) return NULL;
+	if(dot != NULL && (length < 4 || strcmp(name + length - 4, ".txt") != 0)) return NULL;
+
+	directoryLength = strlen(serverDirectory);
+	if((path = (char *) malloc(directoryLength + length + 5)) == NULL) {
+		printf("ERROR allocating a served list path");
+		exit(1);
+	}
+	memcpy(path, serverDirectory, directoryLength);
+	memcpy(path + directoryLength, name, length);
+	strcpy(path + directoryLength + length, dot == NULL ? ".txt" : "");
+	return path;
+}
+
+/**
+ *  \brief Updates the events a client gets polled for
+ *
+ *  Closing clients stop being polled for reading, as they aren't read
+ *  anymore, and so do the ones done sending or with their commands held
+ *  back. The ones with pending replies get polled for writing.
+ *
+ *  \param client The client
+ */
+static void pollClient(struct ServerClient *client) {
+	const unsigned int events = (client->closing || client->ended || client->held ? 0 : EPOLLIN) | (client->output.length > 0 ? EPOLLOUT : 0);
+	struct epoll_event event;
+
+	if(client->events == events) return;
+	memset(&event, 0, sizeof(struct epoll_event));
+	event.events = events;
+	event.data.ptr = client;
+	epoll_ctl(serverEpoll, EPOLL_CTL_MOD, client->fd, &event);
+	client->events = events;
+}
+
+/**
+ *  \brief Disconnects a client
+ *
+ *  \param client The client
+ */
+static void closeClient(struct ServerClient *client) {
+	if(client->previous != NULL) client->previous->next = client->next;
+	else serverClients = client->next;
+	if(client->next != NULL) client->next->previous = client->previous;
+
+	/* Closing it takes it out of the epoll instance */
+	close(client->fd);
+	bufferFree(&client->input);
+	bufferFree(&client->output);
+	free(client);
+}
+
+/**
+ *  \brief Sends as many pending replies as the client socket takes
+ *
+ *  \param client The client
+ */
+static void sendReplies(struct ServerClient *client) {
+	ssize_t result;
+
+	while(client->outputOffset < client->output.length) {
+		if((result = write(client->fd, client->output.data + client->outputOffset, client->output.length - client->outputOffset)) == -1) {
+			if(errno == EINTR) continue;
+			if(errno == EAGAIN || errno == EWOULDBLOCK) {
+				/* Send the rest once it's writable */
+				pollClient(client);
+				return;
+			}
+
+			/* The client is gone, drop the replies */
+			client->closing = 1;
+			break;
+		}
+		client->outputOffset += result;
+	}
+
+	client->output.length = 0;
+	client->outputOffset = 0;
+	pollClient(client);
+}
+
+/**
+ *  \brief Queues a reply line for a client
+ *
+ *  \param client The client
+ *  \param text The reply (Without the trailing '\n' character)
+ */
+static void reply(struct ServerClient *client, const char *text) {
+	bufferAppend(&client->output, text, strlen(text));
+	bufferAppend(&client->output, "\n", 1);
+}
+
+/**
+ *  \brief Runs a command from a client
+ *
+ *  \param client The client
+ *  \param command The command (Without the trailing '\n' character)
+ */
+static void runCommand(struct ServerClient *client, char *command) {
+	/* The list name & path */
+	const char *name;
+	char *path;
+	size_t length;
+
+	/* The memory the removed duplicates gave back */
+	size_t bytes;
+
+	/* The dispatch start time */
+	const double statsStart = statsBegin();
+
+	switch(toupper(command[0])) {
+		case 'Q':
+			client->closing = 1;
+		break;
+		case 'O':
+			/* Pick the list */
+			length = strlen(command + 1);
+			name = trimRange(command + 1, &length);
+			if(length == 0) {
+				reply(client, "ERROR missing list name");
+				break;
+			}
+			command[name - command + length] = '\0';
+			if((path = getServedPath(name)) == NULL) {
+				reply(client, "ERROR invalid list name");
+				break;
+			}
+			client->list = getServedList(path, NULL);
+			free(path);
+			reply(client, "OK");
+		break;
+		default:
+			if(client->list == NULL) reply(client, "ERROR no list opened");
+			else if(toupper(command[0]) == 'A') reply(client, todoListAdd(client->list, command + 1, strlen(command + 1), 0) ? "OK" : "IGNORED");
+			else if(toupper(command[0]) == 'D') reply(client, todoListDeleteSelection(client->list, command + 1) > 0 ? "OK" : "IGNORED");
+			else if(toupper(command[0]) == 'U') reply(client, todoListDedupe(client->list, &bytes) > 0 ? "OK" : "IGNORED");
+			else reply(client, todoListToggleSelection(client->list, command) > 0 ? "OK" : "IGNORED");
+		break;
+	}
+
+	statsEnd(STATS_COMMAND, statsStart);
+}
+
+/**
+ *  \brief Runs the full command lines received from a client
+ *
+ *  \param client The client
+ *  \param flush Whether to run the last line too, even if it isn't terminated
+ */
+static void runCommands(struct ServerClient *client, char flush) {
+	char *line = client->input.data;
+	char *end = client->input.data + client->input.length;
+	char *lineEnd;
+
+	client->held = 0;
+	while(!client->closing && line < end) {
+		if((lineEnd = (char *) findByte(line, end, '\n')) == end && !flush) break;
+
+		/* Hold the rest back until the client reads the replies */
+		if(client->output.length >= SERVER_MAX_OUTPUT_SIZE) {
+			client->held = 1;
+			break;
+		}
+
+		/* Remove the trailing line break */
+		*lineEnd = '\0';
+		if(lineEnd > line && lineEnd[-1] == '\r') lineEnd[-1] = '\0';
+		runCommand(client, line);
+		line = lineEnd + 1;
+	}
+
+	/* Keep the incomplete line for the next read */
+	if(client->closing || line >= end) {
+		client->input.length = 0;
+		return;
+	}
+	client->input.length = end - line;
+	memmove(client->input.data, line, client->input.length);
+	if(!client->held && client->input.length > SERVER_MAX_LINE_SIZE) {
+		reply(client, "ERROR command too long");
+		client->closing = 1;
+	}
+}
+
+/**
+ *  \brief Reads & runs the commands a client sent
+ *
+ *  Runs the held back commands first & stops reading once the replies
+ *  pile up, so a client that doesn't read them can't grow its buffers.
+ *
+ *  \param client The client
+ */
+static void readClient(struct ServerClient *client) {
+	char data[SERVER_READ_SIZE];
+	ssize_t result;
+
+	if(client->held) runCommands(client, client->ended);
+
+	while(!client->closing && !client->ended && !client->held) {
+		if((result = read(client->fd, data, SERVER_READ_SIZE)) == -1) {
+			if(errno == EINTR) continue;
+			if(errno != EAGAIN && errno != EWOULDBLOCK) client->closing = 1;
+			break;
+		}
+
+		if(result == 0) {
+			/* The client is done sending, run its last line */
+			client->ended = 1;
+			runCommands(client, 1);
+			break;
+		}
+
+		/* The pipelined replies get sent at once */
+		bufferAppend(&client->input, data, result);
+		runCommands(client, 0);
+	}
+
+	/* Close it once its last command got run */
+	if(client->ended && !client->held) client->closing = 1;
+}
+
+/**
+ *  \brief Accepts the pending connections
+ *
+ *  \param listener The listening socket
+ *  \param list The list the clients start with (or NULL)
+ */
+static void acceptClients(int listener, struct TODOList *list) {
+	struct ServerClient *client;
+	struct epoll_event event;
+	int fd;
+
+	while((fd = accept(listener, NULL, NULL)) != -1 || errno == EINTR) {
+		if(fd == -1) continue;
+
+		if((client = (struct ServerClient *) calloc(1, sizeof(struct ServerClient))) == NULL) {
+			printf("ERROR allocating a client");
+			exit(1);
+		}
+		client->fd = fd;
+		client->list = list;
+		client->events = EPOLLIN;
+		fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+		fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+		memset(&event, 0, sizeof(struct epoll_event));
+		event.events = EPOLLIN;
+		event.data.ptr = client;
+		if(epoll_ctl(serverEpoll, EPOLL_CTL_ADD, fd, &event) == -1) {
+			close(fd);
+			free(client);
+			continue;
+		}
+
+		client->next = serverClients;
+		if(serverClients != NULL) serverClients->previous = client;
+		serverClients = client;
+	}
+}
+
+/**
+ *  \brief Fills the address of a socket
+ *
+ *  \param address The address
+ *  \param socketPath The socket path
+ *
+ *  \return Whether the path fits in the address
+ */
+static char getAddress(struct sockaddr_un *address, const char *socketPath) {
+	memset(address, 0, sizeof(struct sockaddr_un));
+	address->sun_family = AF_UNIX;
+	if(strlen(socketPath) >= sizeof(address->sun_path)) return 0;
+	strcpy(address->sun_path, socketPath);
+	return 1;
+}
+
+/**
+ *  \brief Creates the listening socket
+ *
+ *  \param socketPath The socket path
+ *
+ *  \return The listening socket (or -1 on error)
+ */
+static int listenSocket(const char *socketPath) {
+	struct sockaddr_un address;
+	int fd;
+	int probe;
+
+	if(!getAddress(&address, socketPath)) {
+		fprintf(stderr, "ERROR socket path too long: %s\n", socketPath);
+		return -1;
+	}
+	if((fd = socket(AF_UNIX, SOCK_STREAM, 0)) == -1) {
+		fprintf(stderr, "ERROR creating the socket\n");
+		return -1;
+	}
+
+	if(bind(fd, (struct sockaddr *) &address, sizeof(struct sockaddr_un)) == -1) {
+		if(errno != EADDRINUSE) {
+			fprintf(stderr, "ERROR binding to: %s\n", socketPath);
+			close(fd);
+			return -1;
+		}
+
+		/* Replace the socket left behind by a server that's gone */
+		if((probe = serverConnect(socketPath)) != -1) {
+			fprintf(stderr, "ERROR already serving on: %s\n", socketPath);
+			close(probe);
+			close(fd);
+			return -1;
+		}
+		unlink(socketPath);
+		if(bind(fd, (struct sockaddr *) &address, sizeof(struct sockaddr_un)) == -1) {
+			fprintf(stderr, "ERROR binding to: %s\n", socketPath);
+			close(fd);
+			return -1;
+		}
+	}
+
+	if(listen(fd, SOMAXCONN) == -1) {
+		fprintf(stderr, "ERROR listening on: %s\n", socketPath);
+		close(fd);
+		return -1;
+	}
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+	fcntl(fd, F_SETFD, FD_CLOEXEC);
+	return fd;
+}
+
+int serverRun(const char *socketPath, const char *filename, const char *title) {
+	/* The event loop events */
+	struct epoll_event events[SERVER_MAX_EVENTS];
+	struct epoll_event event;
+	struct ServerClient *client;
+	int count;
+	int i;
+
+	/* The sigaction for the termination signals */
+	struct sigaction sa;
+
+	/* The served lists & their directory */
+	struct TODOList *list;
+	struct ServerList *served;
+	const char *slash = filename != NULL ? strrchr(filename, '/') : NULL;
+
+	/* The listening socket */
+	int listener;
+
+	/* Serve the lists from the directory of the first one */
+	if((serverDirectory = (char *) malloc(slash != NULL ? slash - filename + 2 : 1)) == NULL) {
+		printf("ERROR allocating the served directory");
+		exit(1);
+	}
+	if(slash != NULL) memcpy(serverDirectory, filename, slash - filename + 1);
+	serverDirectory[slash != NULL ? slash - filename + 1 : 0] = '\0';
+	list = filename != NULL ? getServedList(filename, title) : NULL;
+
+	if((listener = listenSocket(socketPath)) == -1) return 1;
+	if((serverEpoll = epoll_create(SERVER_MAX_EVENTS)) == -1) {
+		fprintf(stderr, "ERROR creating the epoll instance\n");
+		close(listener);
+		return 1;
+	}
+	fcntl(serverEpoll, F_SETFD, FD_CLOEXEC);
+	memset(&event, 0, sizeof(struct epoll_event));
+	event.events = EPOLLIN;
+	event.data.ptr = NULL;
+	epoll_ctl(serverEpoll, EPOLL_CTL_ADD, listener, &event);
+
+	/* Stop on SIGINT & SIGTERM (Without restarting the epoll wait) */
+	sa.sa_handler = stopServer;
+	sa.sa_flags = 0;
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+
+	/* Don't die writing to a client that's gone */
+	sa.sa_handler = SIG_IGN;
+	sigaction(SIGPIPE, &sa, NULL);
+
+	/* Event loop */
+	while(!serverStopping) {
+		if((count = epoll_wait(serverEpoll, events, SERVER_MAX_EVENTS, -1)) == -1) {
+			if(errno == EINTR) continue;
+			fprintf(stderr, "ERROR waiting for events\n");
+			break;
+		}
+
+		for(i = 0; i < count; i++) {
+			if((client = (struct ServerClient *) events[i].data.ptr) == NULL) {
+				acceptClients(listener, list);
+				continue;
+			}
+
+			if(events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) readClient(client);
+			sendReplies(client);
+
+			/* Run the held back commands while their replies get sent right away */
+			while(client->held && client->output.length == 0) {
+				readClient(client);
+				sendReplies(client);
+			}
+			if(client->closing && client->output.length == 0) closeClient(client);
+		}
+	}
+
+	/* Disconnect the clients */
+	while(serverClients != NULL) closeClient(serverClients);
+	close(listener);
+	close(serverEpoll);
+	unlink(socketPath);
+
+	/* Save & close the lists */
+	while((served = serverLists) != NULL) {
+		serverLists = served->next;
+		todoListFlush(served->list);
+		todoListClose(served->list);
+		free(served->filename);
+		free(served);
+	}
+	free(serverDirectory);
+	return 0;
+}
+
+int serverConnect(const char *socketPath) {
+	struct sockaddr_un address;
+	int fd;
+
+	if(!getAddress(&address, socketPath) || (fd = socket(AF_UNIX, SOCK_STREAM, 0)) == -1) return -1;
+	if(connect(fd, (struct sockaddr *) &address, sizeof(struct sockaddr_un)) == -1) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
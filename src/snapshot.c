@@ -0,0 +1,171 @@
+/*
+	C90 TODO List
+	Copyright (C) 2015 Daniel Esteban Nombela <dani@dabuten.co>
+
+	This software is provided 'as-is', without any express or implied
+	warranty. In no event will the author be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "snapshot.h"
+
+/**
+ *  \brief Rounds a size up to the snapshot section alignment
+ */
+#define ALIGN(size) (((size) + 7) & ~((size_t) 7))
+
+/**
+ *  \brief Computes the snapshot checksum of some 8 byte aligned data
+ *
+ *  \param data The data
+ *  \param size The data size (A multiple of 8)
+ *
+ *  \return The checksum
+ */
+static uint64_t checksum(const char *data, size_t size) {
+	const uint64_t *word = (const uint64_t *) data;
+	const uint64_t *end = word + size / 8;
+	uint64_t hash = 0xCBF29CE484222325UL;
+
+	for(; word < end; word++) {
+		hash = (hash ^ *word) * 0x9E3779B97F4A7C15UL;
+		hash ^= hash >> 32;
+	}
+	return hash;
+}
+
+char *snapshotFilename(const char *listFilename) {
+	char *filename = (char *) malloc(strlen(listFilename) + sizeof(SNAPSHOT_EXTENSION));
+	if(filename == NULL) {
+		printf("ERROR allocating snapshot filename");
+		exit(1);
+	}
+	strcpy(filename, listFilename);
+	strcat(filename, SNAPSHOT_EXTENSION);
+	return filename;
+}
+
+char snapshotOpen(struct Snapshot *snapshot, const char *filename, const struct FileIdentity *source) {
+	const struct SnapshotHeader *header;
+	size_t offset;
+
+	snapshot->data = NULL;
+	if(source->size == 0 || (snapshot->data = mapFile(filename, &snapshot->size, &snapshot->mapped)) == NULL) return 0;
+	header = (const struct SnapshotHeader *) snapshot->data;
+
+	/* Check it was taken from the current list file */
+	if(
+		snapshot->size < sizeof(struct SnapshotHeader)
+		|| memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0
+		|| header->sourceSize != source->size
+		|| header->sourceInode != source->inode
+		|| header->sourceMtime != source->mtime
+		|| header->sourceMtimeNsec != source->mtimeNsec
+	) {
+		snapshotClose(snapshot);
+		return 0;
+	}
+
+	/* Check the sections fit & are intact */
+	offset = sizeof(struct SnapshotHeader) + ALIGN(header->titleLength + 1)
+		+ (header->count + 1) * sizeof(uint64_t) + ((header->count + 63) / 64) * sizeof(uint64_t) + ALIGN(header->blobSize);
+	if(
+		offset != snapshot->size
+		|| checksum(snapshot->data + sizeof(struct SnapshotHeader), snapshot->size - sizeof(struct SnapshotHeader)) != header->checksum
+	) {
+		snapshotClose(snapshot);
+		return 0;
+	}
+
+	/* Point to the sections */
+	offset = sizeof(struct SnapshotHeader);
+	snapshot->title = snapshot->data + offset;
+	offset += ALIGN(header->titleLength + 1);
+	snapshot->offsets = (const uint64_t *) (snapshot->data + offset);
+	offset += (header->count + 1) * sizeof(uint64_t);
+	snapshot->done = (const uint64_t *) (snapshot->data + offset);
+	offset += ((header->count + 63) / 64) * sizeof(uint64_t);
+	snapshot->blob = snapshot->data + offset;
+	snapshot->count = header->count;
+	return 1;
+}
+
+void snapshotClose(struct Snapshot *snapshot) {
+	if(snapshot->data != NULL) unmapFile(snapshot->data, snapshot->size, snapshot->mapped);
+	snapshot->data = NULL;
+}
+
+void snapshotAdd(struct SnapshotWriter *writer, const char *title, size_t length, char done) {
+	uint64_t offset = writer->blob.length;
+	uint64_t word = 0;
+
+	/* Start a new bitmap word every 64 entries */
+	if(writer->count % 64 == 0) bufferAppend(&writer->done, (const char *) &word, sizeof(uint64_t));
+	if(done) ((uint64_t *) writer->done.data)[writer->count / 64] |= (uint64_t) 1 << (writer->count % 64);
+
+	bufferAppend(&writer->offsets, (const char *) &offset, sizeof(uint64_t));
+	bufferAppend(&writer->blob, title, length);
+	bufferAppend(&writer->blob, "", 1);
+	writer->count++;
+}
+
+char snapshotWrite(struct SnapshotWriter *writer, const char *filename, const struct FileIdentity *source, const char *title) {
+	/* The snapshot header & data */
+	struct SnapshotHeader header;
+	struct Buffer data = {NULL, 0, 0};
+	const char padding[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+	const size_t titleLength = strlen(title);
+	const uint64_t blobSize = writer->blob.length;
+
+	/* Whether the snapshot got written */
+	char written;
+
+	/* Lay out the sections */
+	memset(&header, 0, sizeof(struct SnapshotHeader));
+	bufferAppend(&data, (const char *) &header, sizeof(struct SnapshotHeader));
+	bufferAppend(&data, title, titleLength + 1);
+	bufferAppend(&data, padding, ALIGN(titleLength + 1) - (titleLength + 1));
+	bufferAppend(&data, writer->offsets.data, writer->offsets.length);
+	bufferAppend(&data, (const char *) &blobSize, sizeof(uint64_t));
+	bufferAppend(&data, writer->done.data, writer->done.length);
+	bufferAppend(&data, writer->blob.data, writer->blob.length);
+	bufferAppend(&data, padding, ALIGN(writer->blob.length) - writer->blob.length);
+
+	/* Fill in the header */
+	memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+	header.sourceSize = source->size;
+	header.sourceInode = source->inode;
+	header.sourceMtime = source->mtime;
+	header.sourceMtimeNsec = source->mtimeNsec;
+	header.count = writer->count;
+	header.titleLength = titleLength;
+	header.blobSize = blobSize;
+	header.checksum = checksum(data.data + sizeof(struct SnapshotHeader), data.length - sizeof(struct SnapshotHeader));
+	memcpy(data.data, &header, sizeof(struct SnapshotHeader));
+
+	/* Write it through a temp file, so it's replaced atomically (It's just a cache, so no fsync) */
+	STATS_COUNT(STATS_BYTES_WRITTEN, data.length);
+	if(!(written = writeFileAtomically(filename, &data, WRITE_SYNC_NONE))) printf("ERROR writing to file: %s\n", filename);
+
+	/* Free the writer */
+	bufferFree(&data);
+	bufferFree(&writer->offsets);
+	bufferFree(&writer->done);
+	bufferFree(&writer->blob);
+	writer->count = 0;
+	return written;
+}
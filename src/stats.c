@@ -0,0 +1,193 @@
+/*
+	C90 TODO List
+	Copyright (C) 2015 Daniel Esteban Nombela <dani@dabuten.co>
+
+	This software is provided 'as-is', without any express or implied
+	warranty. In no event will the author be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "stats.h"
+
+/* Initialize the variables */
+__thread unsigned long statsCounters[STATS_COUNTERS_COUNT] = {0};
+static char statsEnabled = 0;
+static const char *statsReportFilename = NULL;
+static const char *statsTraceFilename = NULL;
+static struct StatsTimer statsTimers[STATS_TIMERS_COUNT];
+static double statsEpoch = 0;
+static pthread_mutex_t statsMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ *  \brief The trace event struct
+ */
+struct TraceEvent {
+	int timer;       /**< The timer */
+	double start;    /**< The start time (seconds since the epoch) */
+	double duration; /**< The duration (seconds) */
+};
+
+/** The trace events **/
+static struct TraceEvent *traceEvents = NULL;
+static unsigned long traceEventsCount = 0;
+static unsigned long traceEventsCapacity = 0;
+
+/** The timers & counters names **/
+static const char *timerNames[STATS_TIMERS_COUNT] = {"load", "save", "command", "render"};
+static const char *counterNames[STATS_COUNTERS_COUNT] = {"bytes_read", "bytes_written", "allocations", "arena_chunks", "frame_bytes", "interned_bytes", "deduped_bytes"};
+
+void statsEnable(const char *reportFilename, const char *traceFilename) {
+	statsEnabled = 1;
+	statsReportFilename = reportFilename;
+	statsTraceFilename = traceFilename;
+	statsEpoch = getMonotonicTime();
+	memset(statsTimers, 0, sizeof(statsTimers));
+}
+
+double statsBegin() {
+	return statsEnabled ? getMonotonicTime() : 0;
+}
+
+void statsEnd(const int timer, const double start) {
+	struct StatsTimer *stats = statsTimers + timer;
+	double elapsed;
+	unsigned long nanoseconds;
+	int bucket = 0;
+
+	if(start == 0) return;
+	elapsed = getMonotonicTime() - start;
+
+	/* Update the timer (The background writer times its saves too) */
+	pthread_mutex_lock(&statsMutex);
+	if(stats->count == 0 || elapsed < stats->min) stats->min = elapsed;
+	if(elapsed > stats->max) stats->max = elapsed;
+	stats->total += elapsed;
+	stats->count++;
+
+	/* Update the histogram */
+	for(nanoseconds = elapsed * 1e9; nanoseconds > 1 && bucket < STATS_BUCKETS - 1; nanoseconds >>= 1) bucket++;
+	stats->buckets[bucket]++;
+
+	/* Record the trace event */
+	if(statsTraceFilename != NULL && traceEventsCount < STATS_MAX_TRACE_EVENTS) {
+		if(traceEventsCount == traceEventsCapacity) {
+			traceEventsCapacity = traceEventsCapacity > 0 ? traceEventsCapacity * 2 : 1024;
+			if((traceEvents = (struct TraceEvent *) realloc(traceEvents, sizeof(struct TraceEvent) * traceEventsCapacity)) == NULL) {
+				printf("ERROR allocating trace events");
+				exit(1);
+			}
+		}
+		traceEvents[traceEventsCount].timer = timer;
+		traceEvents[traceEventsCount].start = start - statsEpoch;
+		traceEvents[traceEventsCount].duration = elapsed;
+		traceEventsCount++;
+	}
+	pthread_mutex_unlock(&statsMutex);
+}
+
+/**
+ *  \brief Estimates a percentile from a timer histogram
+ *
+ *  \param stats The timer
+ *  \param percentile The percentile (0-100)
+ *
+ *  \return The upper bound of the bucket holding the percentile,
+ *          capped to the slowest call (microseconds)
+ */
+static double estimatePercentile(const struct StatsTimer *stats, const unsigned long percentile) {
+	const unsigned long target = (stats->count * percentile + 99) / 100;
+	unsigned long seen = 0;
+	int bucket;
+	double estimate;
+
+	if(stats->count == 0) return 0;
+	for(bucket = 0; bucket < STATS_BUCKETS; bucket++) {
+		if((seen += stats->buckets[bucket]) >= target) break;
+	}
+	estimate = (double) (2UL << bucket) / 1e3;
+	return estimate < stats->max * 1e6 ? estimate : stats->max * 1e6;
+}
+
+/**
+ *  \brief Writes the Chrome trace events
+ */
+static void writeTrace() {
+	FILE *file = fopen(statsTraceFilename, "w");
+	unsigned long i;
+
+	if(file == NULL) {
+		fprintf(stderr, "ERROR writing to file: %s\n", statsTraceFilename);
+		return;
+	}
+
+	fputs("{\"traceEvents\":[\n", file);
+	for(i = 0; i < traceEventsCount; i++) {
+		fprintf(file, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}%s\n",
+			timerNames[traceEvents[i].timer], traceEvents[i].start * 1e6, traceEvents[i].duration * 1e6,
+			i < traceEventsCount - 1 ? "," : "");
+	}
+	fputs("]}\n", file);
+	fclose(file);
+}
+
+void statsAddCounters(const unsigned long *counters) {
+	int i;
+
+	for(i = 0; i < STATS_COUNTERS_COUNT; i++) statsCounters[i] += counters[i];
+}
+
+void statsReport() {
+	FILE *file = stderr;
+	const struct StatsTimer *stats;
+	int i;
+	int bucket;
+	char first;
+
+	if(!statsEnabled) return;
+	statsEnabled = 0;
+
+	if(statsReportFilename != NULL && (file = fopen(statsReportFilename, "w")) == NULL) {
+		fprintf(stderr, "ERROR writing to file: %s\n", statsReportFilename);
+		file = stderr;
+	}
+
+	/* Timers */
+	fputs("{\"timers\":{", file);
+	for(i = 0; i < STATS_TIMERS_COUNT; i++) {
+		stats = statsTimers + i;
+		fprintf(file, "%s\"%s\":{\"count\":%lu,\"total_ms\":%.3f,\"min_us\":%.3f,\"max_us\":%.3f,\"p50_us\":%.3f,\"p99_us\":%.3f,\"histogram_ns\":{",
+			i > 0 ? "," : "", timerNames[i], stats->count, stats->total * 1e3, stats->min * 1e6, stats->max * 1e6,
+			estimatePercentile(stats, 50), estimatePercentile(stats, 99));
+		for(bucket = 0, first = 1; bucket < STATS_BUCKETS; bucket++) {
+			if(stats->buckets[bucket] == 0) continue;
+			fprintf(file, "%s\"%lu\":%lu", first ? "" : ",", 2UL << bucket, stats->buckets[bucket]);
+			first = 0;
+		}
+		fputs("}}", file);
+	}
+
+	/* Counters */
+	fputs("},\"counters\":{", file);
+	for(i = 0; i < STATS_COUNTERS_COUNT; i++) fprintf(file, "%s\"%s\":%lu", i > 0 ? "," : "", counterNames[i], statsCounters[i]);
+	fputs("}}\n", file);
+	if(file != stderr) fclose(file);
+
+	/* Trace */
+	if(statsTraceFilename != NULL) writeTrace();
+	free(traceEvents);
+	traceEvents = NULL;
+}
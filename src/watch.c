@@ -0,0 +1,82 @@
+/*
+	C90 TODO List
+	Copyright (C) 2015 Daniel Esteban Nombela <dani@dabuten.co>
+
+	This software is provided 'as-is', without any express or implied
+	warranty. In no event will the author be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "watch.h"
+
+char watchOpen(struct Watch *watch, const char *filename) {
+	const char *slash = strrchr(filename, '/');
+	char *directory = NULL;
+
+	watch->name = NULL;
+	if((watch->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) == -1) return 0;
+
+	/* Split the directory & the name */
+	if(slash != NULL) {
+		if((directory = (char *) malloc(slash - filename + 2)) == NULL) {
+			printf("ERROR allocating directory name");
+			exit(1);
+		}
+		memcpy(directory, filename, slash - filename + 1);
+		directory[slash - filename + 1] = '\0';
+	}
+	if((watch->name = (char *) malloc(strlen(slash != NULL ? slash + 1 : filename) + 1)) == NULL) {
+		printf("ERROR allocating watch name");
+		exit(1);
+	}
+	strcpy(watch->name, slash != NULL ? slash + 1 : filename);
+
+	/* Watch the directory (So the renames onto the file get noticed too) */
+	if(inotify_add_watch(watch->fd, directory != NULL ? directory : ".", WATCH_EVENTS) == -1) watchClose(watch);
+	free(directory);
+	return watch->fd != -1;
+}
+
+unsigned int watchRead(struct Watch *watch) {
+	/* The events buffer (Aligned for the event structs) */
+	union {
+		struct inotify_event event;
+		char data[4096];
+	} buffer;
+	const struct inotify_event *event;
+	unsigned int events = 0;
+	ssize_t length;
+	ssize_t offset;
+
+	if(watch->fd == -1) return 0;
+
+	/* Drain the events, keeping the ones about the file */
+	while((length = read(watch->fd, buffer.data, sizeof(buffer.data))) > 0) {
+		for(offset = 0; offset < length; offset += sizeof(struct inotify_event) + event->len) {
+			event = (const struct inotify_event *) (buffer.data + offset);
+			if(event->len > 0 && strcmp(event->name, watch->name) == 0) events |= event->mask;
+		}
+	}
+	return events;
+}
+
+void watchClose(struct Watch *watch) {
+	if(watch->fd != -1) close(watch->fd);
+	free(watch->name);
+	watch->fd = -1;
+	watch->name = NULL;
+}
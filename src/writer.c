@@ -0,0 +1,266 @@
+/*
+	C90 TODO List
+	Copyright (C) 2015 Daniel Esteban Nombela <dani@dabuten.co>
+
+	This software is provided 'as-is', without any express or implied
+	warranty. In no event will the author be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "writer.h"
+
+/**
+ *  \brief Computes the absolute deadline for a timed wait
+ *
+ *  \param deadline The deadline
+ *  \param delay The delay from now (seconds)
+ */
+static void getDeadline(struct timespec *deadline, double delay) {
+	clock_gettime(CLOCK_REALTIME, deadline);
+	if(delay < 0) delay = 0;
+	deadline->tv_sec += (time_t) delay;
+	deadline->tv_nsec += (long) ((delay - (time_t) delay) * 1e9);
+	if(deadline->tv_nsec >= 1000000000L) {
+		deadline->tv_sec++;
+		deadline->tv_nsec -= 1000000000L;
+	}
+}
+
+/**
+ *  \brief Gets the sync level of the saves
+ *
+ *  \param writer The writer
+ *
+ *  \return The WRITE_SYNC_* level of its fsync policy
+ */
+static int getSyncLevel(const struct Writer *writer) {
+	switch(writer->fsyncPolicy) {
+		case WRITER_FSYNC_ALWAYS:
+			return WRITE_SYNC_ALL;
+		case WRITER_FSYNC_INTERVAL:
+			return WRITE_SYNC_DATA;
+		default:
+			return WRITE_SYNC_NONE;
+	}
+}
+
+/**
+ *  \brief Copies a filename to be synced
+ *
+ *  \param filename The filename (or NULL)
+ *
+ *  \return A newly allocated copy (or NULL)
+ */
+static char *copySyncFilename(const char *filename) {
+	char *copy;
+
+	if(filename == NULL) return NULL;
+	if((copy = (char *) malloc(strlen(filename) + 1)) == NULL) {
+		printf("ERROR allocating sync filename");
+		exit(1);
+	}
+	strcpy(copy, filename);
+	return copy;
+}
+
+/**
+ *  \brief Syncs the unsynced saves (With the mutex held)
+ *
+ *  Just the file last saved & the one appended to get synced, with the
+ *  mutex released, so the changes don't wait for the disk.
+ *
+ *  \param writer The writer
+ */
+static void syncSaves(struct Writer *writer) {
+	/* Copy the filenames, as the next save can replace them */
+	char *filename = copySyncFilename(writer->syncFilename);
+	char *appended = writer->appendFilename;
+
+	writer->unsynced = 0;
+	writer->lastSync = getMonotonicTime();
+	writer->appendFilename = NULL;
+	if(filename == NULL && appended == NULL) return;
+
+	writer->syncing = 1;
+	pthread_mutex_unlock(&writer->mutex);
+	if(filename != NULL) syncFile(filename);
+	if(appended != NULL) syncFile(appended);
+	pthread_mutex_lock(&writer->mutex);
+	writer->syncing = 0;
+	pthread_cond_broadcast(&writer->changed);
+	free(filename);
+	free(appended);
+}
+
+/**
+ *  \brief The writer thread
+ *
+ *  \param data The writer
+ *
+ *  \return NULL
+ */
+static void *writerLoop(void *data) {
+	struct Writer *writer = (struct Writer *) data;
+	struct timespec deadline;
+	double now;
+
+	pthread_mutex_lock(&writer->mutex);
+	while(writer->pending || !writer->stopping) {
+		if(!writer->pending) {
+			if(!writer->unsynced) {
+				/* Wait for a request */
+				pthread_cond_wait(&writer->changed, &writer->mutex);
+			} else if((now = getMonotonicTime()) < writer->lastSync + WRITER_SYNC_INTERVAL) {
+				/* Wait for a request or the end of the sync interval */
+				getDeadline(&deadline, writer->lastSync + WRITER_SYNC_INTERVAL - now);
+				pthread_cond_timedwait(&writer->changed, &writer->mutex, &deadline);
+			} else {
+				syncSaves(writer);
+			}
+			continue;
+		}
+
+		/* Give a burst of changes a moment to settle, so it gets saved at once */
+		getDeadline(&deadline, WRITER_COALESCE_DELAY);
+		while(!writer->stopping && !writer->flushing && pthread_cond_timedwait(&writer->changed, &writer->mutex, &deadline) != ETIMEDOUT);
+
+		/* Save */
+		writer->pending = 0;
+		writer->saving = 1;
+		writer->save(writer->data, getSyncLevel(writer));
+		writer->saving = 0;
+		if(writer->fsyncPolicy == WRITER_FSYNC_INTERVAL) writer->unsynced = 1;
+		pthread_cond_broadcast(&writer->changed);
+	}
+
+	/* Hand over the counters of the thread */
+	memcpy(writer->counters, statsCounters, sizeof(writer->counters));
+	pthread_mutex_unlock(&writer->mutex);
+	return NULL;
+}
+
+/**
+ *  \brief Starts the writer thread if it isn't running (With the mutex held)
+ *
+ *  \param writer The writer
+ *
+ *  \return Whether it's running
+ */
+static char startWriter(struct Writer *writer) {
+	if(writer->started) return 1;
+	writer->stopping = 0;
+	writer->lastSync = getMonotonicTime();
+	if(pthread_create(&writer->thread, NULL, writerLoop, writer) != 0) return 0;
+	writer->started = 1;
+	return 1;
+}
+
+void writerInit(struct Writer *writer, void (*save)(void *data, int sync), void *data, int fsyncPolicy) {
+	memset(writer, 0, sizeof(struct Writer));
+	pthread_mutex_init(&writer->mutex, NULL);
+	pthread_cond_init(&writer->changed, NULL);
+	writer->save = save;
+	writer->data = data;
+	writer->fsyncPolicy = fsyncPolicy;
+}
+
+void writerSaved(struct Writer *writer, const char *filename) {
+	if(writer->syncFilename != NULL && strcmp(writer->syncFilename, filename) == 0) return;
+	free(writer->syncFilename);
+	writer->syncFilename = copySyncFilename(filename);
+}
+
+void writerAppended(struct Writer *writer, const char *filename) {
+	if(writer->fsyncPolicy != WRITER_FSYNC_INTERVAL) return;
+
+	/* Start the thread, so it gets synced by the end of the interval */
+	if(!startWriter(writer)) {
+		syncFile(filename);
+		return;
+	}
+	if(writer->appendFilename != NULL && strcmp(writer->appendFilename, filename) != 0) {
+		free(writer->appendFilename);
+		writer->appendFilename = NULL;
+	}
+	if(writer->appendFilename == NULL) writer->appendFilename = copySyncFilename(filename);
+	if(!writer->unsynced) {
+		writer->unsynced = 1;
+		pthread_cond_broadcast(&writer->changed);
+	}
+}
+
+void writerLock(struct Writer *writer) {
+	pthread_mutex_lock(&writer->mutex);
+}
+
+void writerUnlock(struct Writer *writer) {
+	pthread_mutex_unlock(&writer->mutex);
+}
+
+void writerRequest(struct Writer *writer) {
+	writer->pending = 1;
+	if(!startWriter(writer)) {
+		/* Save right away if the thread couldn't be created */
+		writer->pending = 0;
+		writer->save(writer->data, writer->fsyncPolicy != WRITER_FSYNC_NEVER ? WRITE_SYNC_ALL : WRITE_SYNC_NONE);
+		return;
+	}
+	pthread_cond_broadcast(&writer->changed);
+}
+
+void writerFlush(struct Writer *writer) {
+	pthread_mutex_lock(&writer->mutex);
+
+	/* Skip the coalescing delay & wait for the save */
+	writer->flushing = 1;
+	pthread_cond_broadcast(&writer->changed);
+	while(writer->pending || writer->saving) pthread_cond_wait(&writer->changed, &writer->mutex);
+	writer->flushing = 0;
+
+	/* Sync the saves (Waiting for the sync the thread is running) */
+	if(writer->unsynced) syncSaves(writer);
+	while(writer->syncing) pthread_cond_wait(&writer->changed, &writer->mutex);
+	pthread_mutex_unlock(&writer->mutex);
+}
+
+void writerWait(struct Writer *writer) {
+	while(writer->saving) pthread_cond_wait(&writer->changed, &writer->mutex);
+}
+
+void writerStop(struct Writer *writer) {
+	if(!writer->started) return;
+	writerFlush(writer);
+
+	/* Finish the thread */
+	pthread_mutex_lock(&writer->mutex);
+	writer->stopping = 1;
+	pthread_cond_broadcast(&writer->changed);
+	pthread_mutex_unlock(&writer->mutex);
+	pthread_join(writer->thread, NULL);
+	statsAddCounters(writer->counters);
+	writer->started = 0;
+}
+
+void writerDestroy(struct Writer *writer) {
+	writerStop(writer);
+	free(writer->syncFilename);
+	writer->syncFilename = NULL;
+	free(writer->appendFilename);
+	writer->appendFilename = NULL;
+	pthread_mutex_destroy(&writer->mutex);
+	pthread_cond_destroy(&writer->changed);
+}
@@ -0,0 +1,270 @@
+/*
+	C90 TODO List
+	Copyright (C) 2015 Daniel Esteban Nombela <dani@dabuten.co>
+
+	This software is provided 'as-is', without any express or implied
+	warranty. In no event will the author be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+/**
+ *  \file journal.c
+ *
+ *  Replay checks for the operation journal
+ *
+ *  Appends the records of the table to a journal, damages it or its base
+ *  file the way a crash or another process would, replays it & compares
+ *  the records it got against the expected ones. Exits with 1 on the
+ *  first mismatch.
+ */
+
+/* Using Standard lib, Standard I/O, Strings & POSIX */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Using Journal, Lib & Writer */
+#include "journal.h"
+#include "lib.h"
+#include "writer.h"
+
+/**
+ *  \brief The journal record struct
+ */
+struct JournalRecord {
+	char op;             /**< The operation (JOURNAL_OPS constant) */
+	unsigned long index; /**< The entry index (Records without a text) */
+	const char *text;    /**< The title or the selection (Records with a text) */
+};
+
+/**
+ *  \brief The journal records (One per operation)
+ */
+static const struct JournalRecord journalRecords[] = {
+	{JOURNAL_ADD, 0, "first entry"},
+	{JOURNAL_ADD, 0, ""},
+	{JOURNAL_DELETE, 2, NULL},
+	{JOURNAL_TOGGLE, 1, NULL},
+	{JOURNAL_DELETE_SELECTION, 0, "1-3,done"},
+	{JOURNAL_TOGGLE_SELECTION, 0, "pending"},
+	{JOURNAL_DEDUPE, 0, NULL},
+	{JOURNAL_DELETE, 4294967295UL, NULL},
+	{JOURNAL_ADD, 0, "✔ last entry"}
+};
+
+/**
+ *  \brief The number of journal records
+ */
+#define JOURNAL_RECORDS (sizeof(journalRecords) / sizeof(struct JournalRecord))
+
+/**
+ *  \brief Formats a record (The way the checks compare them)
+ *
+ *  \param buffer The buffer
+ *  \param op The record operation
+ *  \param index The record entry index
+ *  \param text The record text range start
+ *  \param length The record text range length
+ */
+static void formatRecord(struct Buffer *buffer, char op, unsigned long index, const char *text, size_t length) {
+	char line[64];
+
+	bufferAppend(buffer, line, sprintf(line, "%c %lu [", op, index));
+	if(text != NULL) bufferAppend(buffer, text, length);
+	bufferAppend(buffer, "]\n", 2);
+}
+
+/**
+ *  \brief Records a replayed record (JournalApply callback)
+ *
+ *  \param data The buffer
+ *  \param op The record operation
+ *  \param index The record entry index
+ *  \param title The record text range start
+ *  \param length The record text range length
+ */
+static void recordRecord(void *data, char op, unsigned long index, const char *title, size_t length) {
+	formatRecord((struct Buffer *) data, op, index, title, length);
+}
+
+/**
+ *  \brief Appends the records of the table to a journal
+ *
+ *  \param journal The journal
+ *  \param count The number of records to append (From the first one)
+ *  \param expected The buffer to format them into
+ */
+static void appendRecords(struct Journal *journal, size_t count, struct Buffer *expected) {
+	const struct JournalRecord *record;
+
+	for(record = journalRecords; record < journalRecords + count; record++) {
+		if(!journalAppend(journal, record->op, record->index, record->text, record->text != NULL ? strlen(record->text) : 0)) {
+			printf("ERROR appending to the journal\n");
+			exit(1);
+		}
+		formatRecord(expected, record->op, JOURNAL_HAS_TEXT(record->op) ? 0 : record->index, record->text, record->text != NULL ? strlen(record->text) : 0);
+	}
+}
+
+/**
+ *  \brief Replays a journal & checks its records
+ *
+ *  \param name The check name
+ *  \param baseFilename The base filename
+ *  \param expected The records expected (formatRecord format)
+ *  \param expectedSize The valid journal size expected
+ */
+static void checkReplay(const char *name, const char *baseFilename, const struct Buffer *expected, unsigned long expectedSize) {
+	struct Buffer records = {NULL, 0, 0};
+	struct FileIdentity base;
+	char *filename = journalFilename(baseFilename);
+	unsigned long validSize;
+	unsigned long count;
+	unsigned long expectedCount = 0;
+	size_t i;
+
+	for(i = 0; i < expected->length; i++) if(expected->data[i] == '\n') expectedCount++;
+
+	getFileIdentity(baseFilename, &base);
+	count = journalReplay(filename, &base, recordRecord, &records, &validSize);
+	if(count != expectedCount || validSize != expectedSize) {
+		printf("FAIL %s: got %lu records & %lu valid bytes, expected %lu & %lu\n", name, count, validSize, expectedCount, expectedSize);
+		exit(1);
+	}
+	if(records.length != expected->length || memcmp(records.data, expected->data, records.length) != 0) {
+		bufferAppend(&records, "", 1);
+		printf("FAIL %s: got\n%s\nexpected\n%.*s\n", name, records.data, (int) expected->length, expected->data);
+		exit(1);
+	}
+
+	free(filename);
+	bufferFree(&records);
+	printf("ok %s\n", name);
+}
+
+/**
+ *  \brief Writes a file in place
+ *
+ *  \param filename The filename
+ *  \param text The file text
+ *  \param mode The fopen mode ("w" or "a")
+ */
+static void writeText(const char *filename, const char *text, const char *mode) {
+	FILE *file;
+
+	if((file = fopen(filename, mode)) == NULL || fputs(text, file) == EOF || fclose(file) != 0) {
+		printf("ERROR writing %s\n", filename);
+		exit(1);
+	}
+}
+
+/**
+ *  \brief Checks the compaction threshold
+ *
+ *  \param journalSize The journal size
+ *  \param baseSize The base file size
+ *  \param expected Whether it should be compacted
+ */
+static void checkCompaction(unsigned long journalSize, unsigned long baseSize, char expected) {
+	struct Journal journal;
+
+	memset(&journal, 0, sizeof(journal));
+	journal.size = journalSize;
+	journal.base.size = baseSize;
+	if(journalNeedsCompaction(&journal) != expected) {
+		printf("FAIL compaction of %lu bytes on a %lu bytes base: expected %s\n", journalSize, baseSize, expected ? "one" : "none");
+		exit(1);
+	}
+}
+
+int main(int argc, char **argv) {
+	/* The base & journal files */
+	char baseFilename[256];
+	char *filename;
+	struct Journal journal;
+	struct Buffer expected = {NULL, 0, 0};
+	unsigned long headerSize;
+	unsigned long validSize;
+
+	sprintf(baseFilename, "%s/journal-%ld.txt", argc > 1 ? argv[1] : "/tmp", (long) getpid());
+	filename = journalFilename(baseFilename);
+	writeText(baseFilename, "✘ base entry\n", "w");
+
+	/* No journal */
+	checkReplay("missing journal", baseFilename, &expected, 0);
+
+	/* Every operation, with & without a text */
+	journalOpen(&journal, baseFilename, 0, WRITE_SYNC_NONE);
+	headerSize = journal.size;
+	checkReplay("header only", baseFilename, &expected, headerSize);
+	appendRecords(&journal, JOURNAL_RECORDS, &expected);
+	checkReplay("every operation", baseFilename, &expected, journal.size);
+
+	/* A torn last record gets discarded */
+	validSize = journal.size;
+	writeText(filename, "Atorn entry", "a");
+	checkReplay("torn last record", baseFilename, &expected, validSize);
+	writeText(filename, "D1", "a");
+	checkReplay("torn last index record", baseFilename, &expected, validSize);
+
+	/* Appending after the valid prefix drops the torn record */
+	journalClose(&journal);
+	journalOpen(&journal, baseFilename, validSize, WRITE_SYNC_NONE);
+	appendRecords(&journal, 1, &expected);
+	checkReplay("append after a torn record", baseFilename, &expected, journal.size);
+
+	/* Rebasing keeps the records after the offset only */
+	validSize = journal.size;
+	appendRecords(&journal, 3, &expected);
+	writeText(baseFilename, "✘ base entry\n✘ first entry\n", "w");
+	journalRebase(&journal, baseFilename, validSize);
+	expected.length = 0;
+	formatRecord(&expected, JOURNAL_ADD, 0, "first entry", 11);
+	formatRecord(&expected, JOURNAL_ADD, 0, "", 0);
+	formatRecord(&expected, JOURNAL_DELETE, 2, NULL, 0);
+	checkReplay("rebase", baseFilename, &expected, journal.size);
+	journalClose(&journal);
+
+	/* A journal left behind by another base file gets ignored */
+	writeText(baseFilename, "✘ changed base entry\n", "w");
+	expected.length = 0;
+	checkReplay("base identity mismatch", baseFilename, &expected, 0);
+
+	/* So does a journal without a valid header */
+	writeText(filename, "TODOJOURNAL0 1 2 3 4\nA entry\n", "w");
+	checkReplay("wrong magic", baseFilename, &expected, 0);
+	writeText(filename, JOURNAL_MAGIC " 1 2\nA entry\n", "w");
+	checkReplay("short header", baseFilename, &expected, 0);
+	writeText(filename, JOURNAL_MAGIC, "w");
+	checkReplay("torn header", baseFilename, &expected, 0);
+
+	/* Compaction only past the minimum size & the base size ratio */
+	checkCompaction(0, 0, 0);
+	checkCompaction(JOURNAL_COMPACT_MIN_SIZE - 1, 0, 0);
+	checkCompaction(JOURNAL_COMPACT_MIN_SIZE, 0, 1);
+	checkCompaction(JOURNAL_COMPACT_MIN_SIZE, JOURNAL_COMPACT_MIN_SIZE * JOURNAL_COMPACT_RATIO, 1);
+	checkCompaction(JOURNAL_COMPACT_MIN_SIZE, JOURNAL_COMPACT_MIN_SIZE * JOURNAL_COMPACT_RATIO + 1, 0);
+	checkCompaction(JOURNAL_COMPACT_MIN_SIZE * 2, JOURNAL_COMPACT_MIN_SIZE * 2 * JOURNAL_COMPACT_RATIO, 1);
+	printf("ok compaction threshold\n");
+
+	unlink(filename);
+	unlink(baseFilename);
+	free(filename);
+	bufferFree(&expected);
+	return 0;
+}
@@ -0,0 +1,136 @@
+/*
+	C90 TODO List
+	Copyright (C) 2015 Daniel Esteban Nombela <dani@dabuten.co>
+
+	This software is provided 'as-is', without any express or implied
+	warranty. In no event will the author be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+/**
+ *  \file roundtrip.c
+ *
+ *  Load/save round-trip checks for the TODO list text format
+ *
+ *  Writes list files by hand, loads & saves them through the list API
+ *  and compares the saved file against the expected text. Exits with 1
+ *  on the first mismatch.
+ */
+
+/* Using Standard lib, Standard I/O, Strings & POSIX */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Using Data & Writer */
+#include "data.h"
+#include "writer.h"
+
+/**
+ *  \brief The list header
+ */
+#define ROUNDTRIP_HEADER "========================================\n                  Test\n========================================\n"
+
+/**
+ *  \brief Writes a file
+ *
+ *  \param filename The filename
+ *  \param text The file text
+ */
+static void writeText(const char *filename, const char *text) {
+	FILE *file;
+
+	if((file = fopen(filename, "w")) == NULL || fputs(text, file) == EOF || fclose(file) != 0) {
+		printf("ERROR writing %s\n", filename);
+		exit(1);
+	}
+}
+
+/**
+ *  \brief Checks that a file holds the expected text
+ *
+ *  \param name The check name
+ *  \param filename The filename
+ *  \param expected The expected text
+ */
+static void checkText(const char *name, const char *filename, const char *expected) {
+	char text[1024];
+	size_t length;
+	FILE *file;
+
+	if((file = fopen(filename, "r")) == NULL) {
+		printf("FAIL %s: %s is missing\n", name, filename);
+		exit(1);
+	}
+	length = fread(text, 1, sizeof(text) - 1, file);
+	text[length] = '\0';
+	fclose(file);
+
+	if(strcmp(text, expected) != 0) {
+		printf("FAIL %s: got\n%s\nexpected\n%s\n", name, text, expected);
+		exit(1);
+	}
+	printf("ok %s\n", name);
+}
+
+/**
+ *  \brief Loads a list, adds an entry & checks the saved file
+ *
+ *  \param name The check name
+ *  \param filename The list filename
+ *  \param text The list text
+ *  \param expected The saved text expected
+ *  \param length The entries expected after the load
+ */
+static void roundTrip(const char *name, const char *filename, const char *text, const char *expected, const unsigned long length) {
+	struct TODOList *list;
+
+	writeText(filename, text);
+	list = todoListOpen(filename, NULL);
+	if(todoListGetLength(list) != length) {
+		printf("FAIL %s: loaded %lu entries, expected %lu\n", name, todoListGetLength(list), length);
+		exit(1);
+	}
+	todoListAdd(list, "new", 3, 0);
+	todoListClose(list);
+	checkText(name, filename, expected);
+}
+
+int main(int argc, char **argv) {
+	/* The list file */
+	char filename[256];
+	sprintf(filename, "%s/roundtrip-%ld.txt", argc > 1 ? argv[1] : "/tmp", (long) getpid());
+
+	setTODOListFsyncPolicy(WRITER_FSYNC_NEVER);
+
+	roundTrip("plain", filename,
+		ROUNDTRIP_HEADER "✔ one\n✘ two\n",
+		ROUNDTRIP_HEADER "✔ one\n✘ two\n✘ new\n", 2);
+	roundTrip("indented", filename,
+		ROUNDTRIP_HEADER "  ✘ indented task\n\t✔ tabbed task\n✘ flush\n",
+		ROUNDTRIP_HEADER "✘ indented task\n✔ tabbed task\n✘ flush\n✘ new\n", 3);
+	roundTrip("blank", filename,
+		ROUNDTRIP_HEADER "✘ one\n\n   \n✔ two\n\n",
+		ROUNDTRIP_HEADER "✘ one\n✔ two\n✘ new\n", 2);
+	roundTrip("no newline", filename,
+		ROUNDTRIP_HEADER "✘ one\n  ✔ last",
+		ROUNDTRIP_HEADER "✘ one\n✔ last\n✘ new\n", 2);
+
+	unlink(filename);
+	return 0;
+}
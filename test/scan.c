@@ -0,0 +1,176 @@
+/*
+	C90 TODO List
+	Copyright (C) 2015 Daniel Esteban Nombela <dani@dabuten.co>
+
+	This software is provided 'as-is', without any express or implied
+	warranty. In no event will the author be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+/**
+ *  \file scan.c
+ *
+ *  Equivalence checks for the scanning kernels
+ *
+ *  Runs findByte & trimRange with every kernel the CPU supports over all
+ *  the range lengths from 0 to SCAN_MAX_LENGTH at every alignment, with
+ *  random whitespace & line breaks, and compares them against a plain
+ *  reference. The bytes around the range are random too, so a kernel
+ *  reading past it gets caught. Exits with 1 on the first mismatch.
+ */
+
+/* Using Standard lib, Standard I/O & Strings */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Using Lib */
+#include "lib.h"
+
+/**
+ *  \brief The longest range checked
+ */
+#define SCAN_MAX_LENGTH 100
+
+/**
+ *  \brief The number of alignments checked (The widest kernel block size, twice)
+ */
+#define SCAN_ALIGNMENTS 64
+
+/**
+ *  \brief The number of random fills per length & alignment
+ */
+#define SCAN_FILLS 16
+
+/**
+ *  \brief The bytes the ranges get filled with (Every whitespace byte, the line break & two others)
+ */
+static const char scanBytes[] = " \t\n\v\f\rax";
+
+/**
+ *  \brief The state of the random generator (A fixed seed, so a failure can be reproduced)
+ */
+static unsigned long scanSeed = 1;
+
+/**
+ *  \brief Returns a random number (A linear congruential generator)
+ *
+ *  \param limit The upper bound (Excluded)
+ *
+ *  \return The number
+ */
+static unsigned long scanRandom(unsigned long limit) {
+	scanSeed = scanSeed * 1103515245UL + 12345UL;
+	return (scanSeed >> 16) % limit;
+}
+
+/**
+ *  \brief Fills a buffer with random bytes
+ *
+ *  Some fills are mostly whitespace & some mostly other bytes, so both
+ *  the long runs & the scattered ones get checked.
+ *
+ *  \param buffer The buffer
+ *  \param size The buffer size
+ */
+static void fillRandom(char *buffer, size_t size) {
+	/* The chance of a non whitespace byte (Out of 8) */
+	const unsigned long other = scanRandom(9);
+	size_t i;
+
+	for(i = 0; i < size; i++) buffer[i] = scanRandom(8) < other ? scanBytes[6 + scanRandom(2)] : scanBytes[scanRandom(6)];
+}
+
+/**
+ *  \brief Tells whether a byte is whitespace (The reference)
+ *
+ *  \param byte The byte
+ *
+ *  \return Whether it is
+ */
+static char isSpace(char byte) {
+	return byte != '\0' && strchr(" \t\n\v\f\r", byte) != NULL;
+}
+
+/**
+ *  \brief Checks the kernels on a range against the reference
+ *
+ *  \param name The kernels name
+ *  \param str The range start
+ *  \param length The range length
+ */
+static void checkRange(const char *name, const char *str, size_t length) {
+	const char *end = str + length;
+	const char *expectedByte = str;
+	const char *expectedStart = str;
+	const char *expectedEnd = end;
+	const char *found;
+	const char *trimmed;
+	size_t trimmedLength = length;
+
+	/* The reference */
+	while(expectedByte < end && *expectedByte != '\n') expectedByte++;
+	while(expectedStart < end && isSpace(*expectedStart)) expectedStart++;
+	while(expectedEnd > expectedStart && isSpace(*(expectedEnd - 1))) expectedEnd--;
+
+	found = findByte(str, end, '\n');
+	trimmed = trimRange(str, &trimmedLength);
+	if(found != expectedByte || trimmed != expectedStart || trimmed + trimmedLength != expectedEnd) {
+		printf("FAIL %s kernels on %lu bytes at alignment %lu: findByte at %ld (expected %ld), trimRange at %ld+%lu (expected %ld+%ld)\n",
+			name, (unsigned long) length, (unsigned long) ((size_t) str % SCAN_ALIGNMENTS),
+			(long) (found - str), (long) (expectedByte - str),
+			(long) (trimmed - str), (unsigned long) trimmedLength, (long) (expectedStart - str), (long) (expectedEnd - expectedStart));
+		exit(1);
+	}
+}
+
+/**
+ *  \brief Checks some kernels on every length & alignment
+ *
+ *  \param name The kernels name
+ *  \param kernels The kernels (SCAN_KERNELS_* constant)
+ */
+static void checkKernels(const char *name, int kernels) {
+	/* The ranges, with room for every alignment & the bytes around them */
+	static char buffer[SCAN_ALIGNMENTS * 3 + SCAN_MAX_LENGTH];
+	char *base = buffer + SCAN_ALIGNMENTS - (size_t) buffer % SCAN_ALIGNMENTS;
+	size_t length;
+	size_t alignment;
+	int fill;
+
+	if(setScanKernels(kernels) != kernels) {
+		printf("skip %s kernels (unsupported)\n", name);
+		return;
+	}
+
+	for(length = 0; length <= SCAN_MAX_LENGTH; length++) {
+		for(alignment = 0; alignment < SCAN_ALIGNMENTS; alignment++) {
+			for(fill = 0; fill < SCAN_FILLS; fill++) {
+				fillRandom(buffer, sizeof(buffer));
+				checkRange(name, base + alignment, length);
+			}
+		}
+	}
+	printf("ok %s kernels\n", name);
+}
+
+int main() {
+	checkKernels("scalar", SCAN_KERNELS_SCALAR);
+	checkKernels("sse2", SCAN_KERNELS_SSE2);
+	checkKernels("avx2", SCAN_KERNELS_AVX2);
+	return 0;
+}
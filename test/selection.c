@@ -0,0 +1,266 @@
+/*
+	C90 TODO List
+	Copyright (C) 2015 Daniel Esteban Nombela <dani@dabuten.co>
+
+	This software is provided 'as-is', without any express or implied
+	warranty. In no event will the author be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+/**
+ *  \file selection.c
+ *
+ *  Selection grammar & sweep checks
+ *
+ *  Deletes or toggles each selection of the table on a fresh list (Every
+ *  third entry done) in journal mode, then checks the entries it got &
+ *  the ones the position index finds, and checks them again once the
+ *  journal got replayed by a new load. Exits with 1 on the first mismatch.
+ */
+
+/* Using Standard lib, Standard I/O, Strings & POSIX */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Using Data, Lib & Writer */
+#include "data.h"
+#include "lib.h"
+#include "writer.h"
+
+/**
+ *  \brief The list header
+ */
+#define SELECTION_HEADER "========================================\n                  Test\n========================================\n"
+
+/**
+ *  \brief The number of entries of the list
+ *         (Spans up to a SELECTION_REBUILD_RATIO-th of it get removed from the index one by one)
+ */
+#define SELECTION_LIST_LENGTH 24
+
+/**
+ *  \brief The selection case struct
+ */
+struct SelectionCase {
+	const char *spec;     /**< The selection */
+	char op;              /**< The operation ('d' to delete, 't' to toggle) */
+	const char *affected; /**< The comma separated indices it deletes or toggles */
+};
+
+/**
+ *  \brief The selection cases
+ */
+static const struct SelectionCase selectionCases[] = {
+	/* Single indices (Plain deletes & toggles) */
+	{"5", 'd', "5"},
+	{"5", 't', "5"},
+	{"24", 'd', "24"},
+	{"25", 'd', ""},
+	{"0", 'd', ""},
+
+	/* Indices & ranges, removed from the index one by one */
+	{"2,4", 'd', "2,4"},
+	{"4,2", 'd', "2,4"},
+	{" 2 , 4 ", 'd', "2,4"},
+	{"9-11", 'd', "9,10,11"},
+	{"11-9", 'd', "9,10,11"},
+	{"9-10,10-11", 'd', "9,10,11"},
+	{"23-40", 'd', "23,24"},
+	{"0-2", 'd', "1,2"},
+	{"2,4", 't', "2,4"},
+
+	/* Bigger spans, with the index rebuilt */
+	{"9-12", 'd', "9,10,11,12"},
+	{"2-5,4-7", 'd', "2,3,4,5,6,7"},
+	{"7-9,1-3,2-4", 'd', "1,2,3,4,7,8,9"},
+	{"3-4,5-6", 'd', "3,4,5,6"},
+	{"20-100", 'd', "20,21,22,23,24"},
+	{"1-24", 'd', "1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20,21,22,23,24"},
+	{"9-12", 't', "9,10,11,12"},
+
+	/* Statuses */
+	{"done", 'd', "3,6,9,12,15,18,21,24"},
+	{"DONE", 'd', "3,6,9,12,15,18,21,24"},
+	{"pending", 'd', "1,2,4,5,7,8,10,11,13,14,16,17,19,20,22,23"},
+	{"done,pending", 'd', "1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20,21,22,23,24"},
+	{"1-2,done", 'd', "1,2,3,6,9,12,15,18,21,24"},
+	{"done", 't', "3,6,9,12,15,18,21,24"},
+	{"pending,24", 't', "1,2,4,5,7,8,10,11,13,14,16,17,19,20,22,23,24"},
+
+	/* Malformed specs */
+	{"", 'd', ""},
+	{"   ", 'd', ""},
+	{",", 'd', ""},
+	{"2,,4", 'd', ""},
+	{"2,", 'd', ""},
+	{"a", 'd', ""},
+	{"-3", 'd', ""},
+	{"2-", 'd', ""},
+	{"2-4x", 'd', ""},
+	{"2 4", 'd', ""},
+	{"finished", 't', ""}
+};
+
+/**
+ *  \brief Serializes an entry (todoListIterate visitor)
+ *
+ *  \param data The buffer
+ *  \param entryIndex The entry index
+ *  \param entry The entry
+ *
+ *  \return Whether to keep iterating
+ */
+static char serializeEntry(void *data, unsigned long entryIndex, const struct TODOEntry *entry) {
+	struct Buffer *buffer = (struct Buffer *) data;
+
+	(void) entryIndex;
+	bufferAppend(buffer, entry->done ? DONE_MARKER " " : PENDING_MARKER " ", sizeof(DONE_MARKER));
+	bufferAppend(buffer, entry->title, entry->titleLength);
+	bufferAppend(buffer, "\n", 1);
+	return 1;
+}
+
+/**
+ *  \brief Serializes the list entries a case expects
+ *
+ *  \param selectionCase The case (or NULL for the untouched list)
+ *  \param buffer The buffer
+ *
+ *  \return The number of entries it affects
+ */
+static unsigned long expectEntries(const struct SelectionCase *selectionCase, struct Buffer *buffer) {
+	char affected[SELECTION_LIST_LENGTH + 1];
+	const char *index;
+	char *indexEnd;
+	char line[64];
+	unsigned long count = 0;
+	int i;
+
+	memset(affected, 0, sizeof(affected));
+	for(index = selectionCase != NULL ? selectionCase->affected : ""; *index != '\0'; index = *indexEnd == ',' ? indexEnd + 1 : indexEnd) {
+		affected[strtoul(index, &indexEnd, 10)] = 1;
+		count++;
+	}
+
+	for(i = 1; i <= SELECTION_LIST_LENGTH; i++) {
+		if(affected[i] && selectionCase->op == 'd') continue;
+		sprintf(line, "%s entry %d\n", (i % 3 == 0) != affected[i] ? DONE_MARKER : PENDING_MARKER, i);
+		bufferAppend(buffer, line, strlen(line));
+	}
+	return count;
+}
+
+/**
+ *  \brief Checks the entries of a list, along with the ones its index finds
+ *
+ *  \param name The check name
+ *  \param list The TODO list
+ *  \param expected The entries expected (In the list text format)
+ */
+static void checkEntries(const char *name, struct TODOList *list, const char *expected) {
+	struct Buffer entries = {NULL, 0, 0};
+	struct Buffer indexed = {NULL, 0, 0};
+	unsigned long i;
+
+	todoListIterate(list, serializeEntry, &entries);
+	for(i = 1; i <= todoListGetLength(list); i++) serializeEntry(&indexed, i, todoListGetEntry(list, i));
+	bufferAppend(&entries, "", 1);
+	bufferAppend(&indexed, "", 1);
+
+	if(strcmp(entries.data, expected) != 0) {
+		printf("FAIL %s: got\n%s\nexpected\n%s\n", name, entries.data, expected);
+		exit(1);
+	}
+	if(strcmp(indexed.data, expected) != 0) {
+		printf("FAIL %s: the index holds\n%s\nexpected\n%s\n", name, indexed.data, expected);
+		exit(1);
+	}
+	bufferFree(&entries);
+	bufferFree(&indexed);
+}
+
+/**
+ *  \brief Runs a selection case
+ *
+ *  \param filename The list filename
+ *  \param selectionCase The case
+ */
+static void checkCase(const char *filename, const struct SelectionCase *selectionCase) {
+	struct Buffer text = {NULL, 0, 0};
+	struct Buffer expected = {NULL, 0, 0};
+	struct TODOList *list;
+	char *journal = journalFilename(filename);
+	unsigned long expectedCount;
+	unsigned long count;
+	char name[128];
+
+	sprintf(name, "%s \"%s\"", selectionCase->op == 'd' ? "delete" : "toggle", selectionCase->spec);
+
+	/* A fresh list */
+	bufferAppend(&text, SELECTION_HEADER, sizeof(SELECTION_HEADER) - 1);
+	expectEntries(NULL, &text);
+	unlink(journal);
+	if(!writeFileAtomically(filename, &text, WRITE_SYNC_NONE)) {
+		printf("ERROR writing %s\n", filename);
+		exit(1);
+	}
+
+	/* Apply the selection in journal mode */
+	setTODOListJournalMode(1);
+	list = todoListOpen(filename, NULL);
+	count = selectionCase->op == 'd' ? todoListDeleteSelection(list, selectionCase->spec) : todoListToggleSelection(list, selectionCase->spec);
+	expectedCount = expectEntries(selectionCase, &expected);
+	bufferAppend(&expected, "", 1);
+	if(count != expectedCount) {
+		printf("FAIL %s: got %lu entries, expected %lu\n", name, count, expectedCount);
+		exit(1);
+	}
+	checkEntries(name, list, expected.data);
+	todoListClose(list);
+
+	/* Replay the journal record */
+	setTODOListJournalMode(0);
+	list = todoListOpen(filename, NULL);
+	checkEntries(name, list, expected.data);
+	todoListClose(list);
+
+	if(access(journal, F_OK) == 0) {
+		printf("FAIL %s: the journal was left behind\n", name);
+		exit(1);
+	}
+
+	free(journal);
+	bufferFree(&text);
+	bufferFree(&expected);
+	printf("ok %s\n", name);
+}
+
+int main(int argc, char **argv) {
+	/* The list file */
+	char filename[256];
+	size_t i;
+
+	sprintf(filename, "%s/selection-%ld.txt", argc > 1 ? argv[1] : "/tmp", (long) getpid());
+	setTODOListFsyncPolicy(WRITER_FSYNC_NEVER);
+
+	for(i = 0; i < sizeof(selectionCases) / sizeof(struct SelectionCase); i++) checkCase(filename, selectionCases + i);
+
+	unlink(filename);
+	return 0;
+}
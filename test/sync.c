@@ -0,0 +1,245 @@
+/*
+	C90 TODO List
+	Copyright (C) 2015 Daniel Esteban Nombela <dani@dabuten.co>
+
+	This software is provided 'as-is', without any express or implied
+	warranty. In no event will the author be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+/**
+ *  \file sync.c
+ *
+ *  Merge checks for the external changes of a watched list file
+ *
+ *  Opens a list in watch mode (With the auto save disabled, so the local
+ *  changes stay pending), changes its file the way another process would,
+ *  calls todoListSync & compares the merged entries against the expected
+ *  ones. Exits with 1 on the first mismatch.
+ */
+
+/* Using Standard lib, Standard I/O, Strings & POSIX */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Using Data, Lib & Writer */
+#include "data.h"
+#include "lib.h"
+#include "writer.h"
+
+/**
+ *  \brief The list header
+ */
+#define SYNC_HEADER "========================================\n                  Test\n========================================\n"
+
+/**
+ *  \brief The number of entries of the list edited past SYNC_MAX_EDITS
+ */
+#define SYNC_LONG_LIST 600
+
+/**
+ *  \brief Writes a file in place
+ *
+ *  \param filename The filename
+ *  \param text The file text
+ *  \param mode The fopen mode ("w" or "a")
+ */
+static void writeText(const char *filename, const char *text, const char *mode) {
+	FILE *file;
+
+	if((file = fopen(filename, mode)) == NULL || fputs(text, file) == EOF || fclose(file) != 0) {
+		printf("ERROR writing %s\n", filename);
+		exit(1);
+	}
+}
+
+/**
+ *  \brief Replaces a file through a rename (As the editors & our own saves do)
+ *
+ *  \param filename The filename
+ *  \param text The file text
+ */
+static void replaceText(const char *filename, const char *text) {
+	struct Buffer buffer = {NULL, 0, 0};
+
+	bufferAppend(&buffer, text, strlen(text));
+	if(!writeFileAtomically(filename, &buffer, WRITE_SYNC_NONE)) {
+		printf("ERROR writing %s\n", filename);
+		exit(1);
+	}
+	bufferFree(&buffer);
+}
+
+/**
+ *  \brief Serializes an entry (todoListIterate visitor)
+ *
+ *  \param data The buffer
+ *  \param entryIndex The entry index
+ *  \param entry The entry
+ *
+ *  \return Whether to keep iterating
+ */
+static char serializeEntry(void *data, unsigned long entryIndex, const struct TODOEntry *entry) {
+	struct Buffer *buffer = (struct Buffer *) data;
+
+	(void) entryIndex;
+	bufferAppend(buffer, entry->done ? DONE_MARKER " " : PENDING_MARKER " ", sizeof(DONE_MARKER));
+	bufferAppend(buffer, entry->title, entry->titleLength);
+	bufferAppend(buffer, "\n", 1);
+	return 1;
+}
+
+/**
+ *  \brief Syncs a list & checks its entries
+ *
+ *  \param name The check name
+ *  \param list The TODO list
+ *  \param expected The entries expected (In the list text format)
+ */
+static void checkSync(const char *name, struct TODOList *list, const char *expected) {
+	struct Buffer entries = {NULL, 0, 0};
+
+	if(!todoListSync(list)) {
+		printf("FAIL %s: the sync changed nothing\n", name);
+		exit(1);
+	}
+	todoListIterate(list, serializeEntry, &entries);
+	bufferAppend(&entries, "", 1);
+	if(strcmp(entries.data, expected) != 0) {
+		printf("FAIL %s: got\n%s\nexpected\n%s\n", name, entries.data, expected);
+		exit(1);
+	}
+	bufferFree(&entries);
+	printf("ok %s\n", name);
+}
+
+/**
+ *  \brief Opens a list from a text
+ *
+ *  \param filename The list filename
+ *  \param text The list text
+ *
+ *  \return The list handle
+ */
+static struct TODOList *openText(const char *filename, const char *text) {
+	writeText(filename, text, "w");
+	return todoListOpen(filename, NULL);
+}
+
+/**
+ *  \brief Checks the edits past SYNC_MAX_EDITS (Matched in order instead of diffed)
+ *
+ *  Every other entry gets replaced in the file, along with a local toggle
+ *  & a local delete of kept entries.
+ *
+ *  \param filename The list filename
+ */
+static void checkLongEdit(const char *filename) {
+	struct Buffer text = {NULL, 0, 0};
+	struct Buffer expected = {NULL, 0, 0};
+	struct TODOList *list;
+	char line[64];
+	int i;
+
+	bufferAppend(&text, SYNC_HEADER, sizeof(SYNC_HEADER) - 1);
+	for(i = 0; i < SYNC_LONG_LIST; i++) {
+		sprintf(line, PENDING_MARKER " entry %d\n", i);
+		bufferAppend(&text, line, strlen(line));
+	}
+	bufferAppend(&text, "", 1);
+	list = openText(filename, text.data);
+
+	/* Toggle the first entry & delete the third one locally */
+	todoListToggle(list, 1);
+	todoListDelete(list, 3);
+
+	/* Replace the odd entries in the file */
+	text.length = 0;
+	bufferAppend(&text, SYNC_HEADER, sizeof(SYNC_HEADER) - 1);
+	for(i = 0; i < SYNC_LONG_LIST; i++) {
+		sprintf(line, PENDING_MARKER " %s %d\n", i % 2 == 0 ? "entry" : "replaced", i);
+		bufferAppend(&text, line, strlen(line));
+		if(i == 2) continue;
+		if(i == 0) sprintf(line, DONE_MARKER " entry 0\n");
+		bufferAppend(&expected, line, strlen(line));
+	}
+	bufferAppend(&text, "", 1);
+	bufferAppend(&expected, "", 1);
+	replaceText(filename, text.data);
+	checkSync("more than SYNC_MAX_EDITS edits", list, expected.data);
+
+	todoListClose(list);
+	bufferFree(&text);
+	bufferFree(&expected);
+}
+
+int main(int argc, char **argv) {
+	/* The list file */
+	char filename[256];
+	struct TODOList *list;
+
+	sprintf(filename, "%s/sync-%ld.txt", argc > 1 ? argv[1] : "/tmp", (long) getpid());
+	setTODOListFsyncPolicy(WRITER_FSYNC_NEVER);
+	setTODOListWatchMode(1);
+	setTODOListAutoSave(0);
+
+	/* Lines appended in place get added */
+	list = openText(filename, SYNC_HEADER "✘ one\n");
+	writeText(filename, "✘ two\n✔ three\n", "a");
+	checkSync("append", list, "✘ one\n✘ two\n✔ three\n");
+
+	/* A trailing partial line waits for the rest of it */
+	writeText(filename, "✘ four\n✘ fi", "a");
+	checkSync("trailing partial line", list, "✘ one\n✘ two\n✔ three\n✘ four\n");
+	writeText(filename, "ve\n", "a");
+	checkSync("trailing partial line completed", list, "✘ one\n✘ two\n✔ three\n✘ four\n✘ five\n");
+	todoListClose(list);
+
+	/* A toggle in the file gets applied */
+	list = openText(filename, SYNC_HEADER "✘ a\n✘ b\n✘ c\n");
+	replaceText(filename, SYNC_HEADER "✘ a\n✔ b\n✘ c\n");
+	checkSync("external toggle", list, "✘ a\n✔ b\n✘ c\n");
+	todoListClose(list);
+
+	/* A delete in the file wins over a local toggle */
+	list = openText(filename, SYNC_HEADER "✘ a\n✘ b\n✘ c\n");
+	todoListToggle(list, 2);
+	replaceText(filename, SYNC_HEADER "✘ a\n✘ c\n");
+	checkSync("external delete & local toggle", list, "✘ a\n✘ c\n");
+	todoListClose(list);
+
+	/* A local delete wins over a toggle in the file */
+	list = openText(filename, SYNC_HEADER "✘ a\n✘ b\n✘ c\n");
+	todoListDelete(list, 2);
+	replaceText(filename, SYNC_HEADER "✘ a\n✔ b\n✔ c\n");
+	checkSync("local delete & external toggle", list, "✘ a\n✔ c\n");
+	todoListClose(list);
+
+	/* The entries added & deleted in the file go in place, the local ones stay after them */
+	list = openText(filename, SYNC_HEADER "✘ a\n✘ b\n✘ c\n✘ d\n");
+	todoListAdd(list, "local", 5, 0);
+	replaceText(filename, SYNC_HEADER "✘ a\n✘ x\n✘ c\n✘ d\n✘ y\n");
+	checkSync("external insert & delete", list, "✘ a\n✘ x\n✘ c\n✘ d\n✘ y\n✘ local\n");
+	todoListClose(list);
+
+	checkLongEdit(filename);
+
+	unlink(filename);
+	return 0;
+}